@@ -0,0 +1,355 @@
+// HTTP load benchmark: the firmware's web API under concurrent clients, and
+// what the load does to the render loop.
+//
+//   make http-bench
+//   .pio/bench/http_bench --concurrency 0,1,4,16,32 --phase-s 5 --json http.json
+//
+// The firmware runs on the virtual board (see host/) in real time on the
+// main thread, exactly as loop() runs on the ESP8266: WiFiInputSource serves
+// one client per pass and the LED show blocks for the strip's wire time.
+// Client threads fire a mix of /set_* (speed, brightness, hue), /config and
+// / requests over loopback. Each phase reports request throughput, latency
+// percentiles and the intervals between LED frames; phase 0 (no clients) is
+// the baseline the frame jitter of the loaded phases is compared with.
+// Requests still in flight when a phase ends are served to completion and
+// kept in the latency percentiles (they are the slowest ones); the "cut off"
+// column counts them, and they are left out of the request rate.
+//
+// The host CPU is far faster than the ESP8266's, so handler costs are
+// understated; what carries over is the structure: how request rate is
+// bound to the loop rate, and how much a request stretches a frame.
+#include "virtual_board.h"
+#include <Arduino.h>
+#include "config.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+void setup();
+void loop();
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  struct Options
+  {
+    std::vector<int> concurrency = {0, 1, 4, 16, 32};
+    double phaseS = 5;
+    int setWeight = 6; // Request mix: /set_*, /config, /
+    int configWeight = 3;
+    int rootWeight = 1;
+    int portOffset = 8100;
+    std::string fsRoot = ".pio/bench/littlefs";
+    const char *jsonPath = nullptr;
+    bool verbose = false;
+  };
+
+  struct PhaseResult
+  {
+    int clients;
+    unsigned long ok;
+    unsigned long errors;
+    unsigned long cutOff;          // Successful requests that completed after the phase ended
+    double seconds;
+    std::vector<double> latencyMs; // Successful requests
+    std::vector<double> frameMs;   // Intervals between LED shows
+  };
+
+  double percentile(std::vector<double> values, double p)
+  {
+    if (values.empty())
+      return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+  }
+
+  double maximum(const std::vector<double> &values)
+  {
+    return values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+  }
+
+  /**
+   * @brief One blocking GET over a new connection, like the web UI's fetch()
+   * @return HTTP status, or 0 if the request failed
+   */
+  int get(int port, const std::string &path)
+  {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+      return 0;
+    timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    int status = 0;
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0)
+    {
+      std::string request = "GET " + path + " HTTP/1.1\r\nHost: portal\r\nConnection: close\r\n\r\n";
+      if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) == (ssize_t)request.size())
+      {
+        char chunk[4096];
+        std::string head;
+        ssize_t n;
+        while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+        {
+          if (head.size() < 16)
+            head.append(chunk, (size_t)std::min<ssize_t>(n, 16));
+        }
+        if (n == 0 && head.compare(0, 5, "HTTP/") == 0)
+          status = atoi(head.c_str() + 9);
+      }
+    }
+    close(fd);
+    return status;
+  }
+
+  std::string pickRequest(const Options &options, std::mt19937 &rng)
+  {
+    int total = options.setWeight + options.configWeight + options.rootWeight;
+    int pick = (int)(rng() % (unsigned)total);
+    if (pick >= options.setWeight + options.configWeight)
+      return "/";
+    if (pick >= options.setWeight)
+      return "/config";
+    switch (rng() % 3)
+    {
+    case 0:
+      return "/set_speed?speed=" + std::to_string(1 + rng() % 10);
+    case 1:
+      return "/set_brightness?brightness=" + std::to_string(128 + rng() % 128);
+    default:
+      int hue = (int)(rng() % 200);
+      return "/set_hue?min=" + std::to_string(hue) + "&max=" + std::to_string(hue + 40);
+    }
+  }
+
+  /**
+   * @brief Drive the firmware loop for a while, recording the frame intervals
+   */
+  void runLoop(double seconds, std::vector<double> *frameMs)
+  {
+    const VirtualBoard::Strip *strip = VirtualBoard::getStrip(PortalConfig::Hardware::LED_PIN);
+    unsigned long shows = strip ? strip->shows : 0;
+    uint64_t lastShowUs = strip ? strip->lastShowUs : 0;
+    uint64_t endUs = VirtualBoard::nowUs() + (uint64_t)(seconds * 1e6);
+    while (VirtualBoard::nowUs() < endUs)
+    {
+      loop();
+      if (strip && strip->shows != shows)
+      {
+        if (frameMs && shows > 0)
+          frameMs->push_back((strip->lastShowUs - lastShowUs) / 1000.0);
+        shows = strip->shows;
+        lastShowUs = strip->lastShowUs;
+      }
+    }
+  }
+
+  PhaseResult runPhase(const Options &options, int clients)
+  {
+    PhaseResult result = {clients, 0, 0, 0, 0, {}, {}};
+    std::atomic<bool> running(true);
+    std::atomic<int> finished(0);
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<unsigned long> errors(clients, 0);
+    std::vector<unsigned long> cutOff(clients, 0);
+    std::vector<std::thread> threads;
+    int port = PortalConfig::WiFi::HTTP_PORT + options.portOffset;
+    for (int c = 0; c < clients; c++)
+    {
+      threads.emplace_back([&, c]()
+                           {
+        std::mt19937 rng(1234 + c);
+        while (running)
+        {
+          std::string path = pickRequest(options, rng);
+          Clock::time_point start = Clock::now();
+          int status = get(port, path);
+          double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+          if (status == 200)
+          {
+            latencies[c].push_back(ms);
+            if (!running)
+              cutOff[c]++;
+          }
+          else
+            errors[c]++;
+        }
+        finished++; });
+    }
+
+    Clock::time_point start = Clock::now();
+    runLoop(options.phaseS, &result.frameMs);
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    running = false;
+    // Serve the requests still in flight so the clients can finish
+    while (finished < clients)
+      runLoop(0.01, nullptr);
+    for (std::thread &t : threads)
+      t.join();
+
+    for (int c = 0; c < clients; c++)
+    {
+      result.latencyMs.insert(result.latencyMs.end(), latencies[c].begin(), latencies[c].end());
+      result.errors += errors[c];
+      result.cutOff += cutOff[c];
+    }
+    result.ok = result.latencyMs.size();
+    return result;
+  }
+
+  /**
+   * @brief Requests per second completed within the phase
+   */
+  double requestRate(const PhaseResult &p)
+  {
+    return (p.ok - p.cutOff) / p.seconds;
+  }
+
+  bool writeJson(const char *path, const std::vector<PhaseResult> &phases)
+  {
+    FILE *file = fopen(path, "w");
+    if (!file)
+      return false;
+    fprintf(file, "{\n  \"phases\": [\n");
+    for (size_t i = 0; i < phases.size(); i++)
+    {
+      const PhaseResult &p = phases[i];
+      fprintf(file,
+              "    {\"clients\": %d, \"requests\": %lu, \"errors\": %lu, \"cut_off\": %lu, \"rps\": %.1f, "
+              "\"latency_p50_ms\": %.2f, "
+              "\"latency_p90_ms\": %.2f, \"latency_p99_ms\": %.2f, \"latency_max_ms\": %.2f, \"fps\": %.1f, "
+              "\"frame_p50_ms\": %.2f, \"frame_p99_ms\": %.2f, \"frame_max_ms\": %.2f}%s\n",
+              p.clients, p.ok, p.errors, p.cutOff, requestRate(p), percentile(p.latencyMs, 50), percentile(p.latencyMs, 90),
+              percentile(p.latencyMs, 99), maximum(p.latencyMs), p.frameMs.size() / p.seconds,
+              percentile(p.frameMs, 50), percentile(p.frameMs, 99), maximum(p.frameMs),
+              i + 1 < phases.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+  }
+
+  bool parseList(const char *text, std::vector<int> &values)
+  {
+    values.clear();
+    for (const char *p = text; *p;)
+    {
+      char *end;
+      long value = strtol(p, &end, 10);
+      if (end == p || value < 0 || value > 60) // The server's listen backlog is 64
+        return false;
+      values.push_back((int)value);
+      p = *end == ',' ? end + 1 : end;
+      if (*end && *end != ',')
+        return false;
+    }
+    return !values.empty();
+  }
+
+  bool parseOptions(int argc, char **argv, Options &options)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+      if (arg == "--verbose")
+        options.verbose = true;
+      else if (value == nullptr)
+        return false;
+      else if (arg == "--concurrency" && parseList(value, options.concurrency))
+        i++;
+      else if (arg == "--phase-s")
+        options.phaseS = atof(argv[++i]);
+      else if (arg == "--mix" &&
+               sscanf(value, "%d:%d:%d", &options.setWeight, &options.configWeight, &options.rootWeight) == 3)
+        i++;
+      else if (arg == "--port-offset")
+        options.portOffset = atoi(argv[++i]);
+      else if (arg == "--fs")
+        options.fsRoot = argv[++i];
+      else if (arg == "--json")
+        options.jsonPath = argv[++i];
+      else
+        return false;
+    }
+    return options.phaseS > 0 && options.setWeight >= 0 && options.configWeight >= 0 && options.rootWeight >= 0 &&
+           options.setWeight + options.configWeight + options.rootWeight > 0;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    fprintf(stderr,
+            "usage: %s [--concurrency N,N,...] [--phase-s N] [--mix SET:CONFIG:ROOT] [--port-offset N] [--fs DIR]\n"
+            "          [--json PATH] [--verbose]\n",
+            argv[0]);
+    return 2;
+  }
+  if (VirtualBoard::prepareFs(options.fsRoot.c_str(), "data") < 0)
+  {
+    fprintf(stderr, "http bench: cannot create %s\n", options.fsRoot.c_str());
+    return 1;
+  }
+  VirtualBoard::setFsRoot(options.fsRoot.c_str());
+  VirtualBoard::setPortOffset(options.portOffset);
+  VirtualBoard::setRealTime(true);
+  VirtualBoard::setSerialFds(-1, options.verbose ? STDERR_FILENO : -1);
+  ESP.getFreeHeap();
+
+  // Boot, let the startup flashes finish, then start the portal with button 1
+  setup();
+  runLoop(2.0, nullptr);
+  VirtualBoard::setInput(PortalConfig::Hardware::BUTTON1_PIN, LOW);
+  runLoop(0.2, nullptr);
+  VirtualBoard::setInput(PortalConfig::Hardware::BUTTON1_PIN, HIGH);
+  runLoop(1.0, nullptr);
+
+  printf("%7s %8s %6s %7s %8s %8s %8s %8s %8s %6s %9s %9s %9s %10s\n", "clients", "requests", "errors", "cut off",
+         "req/s", "p50 ms",
+         "p90 ms", "p99 ms", "max ms", "fps", "frame p50", "frame p99", "frame max", "p99 vs idle");
+  std::vector<PhaseResult> phases;
+  double idleP99 = -1;
+  bool starved = false;
+  for (int clients : options.concurrency)
+  {
+    PhaseResult p = runPhase(options, clients);
+    phases.push_back(p);
+    double frameP99 = percentile(p.frameMs, 99);
+    if (clients == 0 && idleP99 < 0)
+      idleP99 = frameP99;
+    starved |= clients > 0 && p.ok == 0;
+
+    char vsIdle[16] = "";
+    if (idleP99 >= 0 && clients > 0)
+      snprintf(vsIdle, sizeof(vsIdle), "%+.2f ms", frameP99 - idleP99);
+    printf("%7d %8lu %6lu %7lu %8.1f %8.2f %8.2f %8.2f %8.2f %6.1f %9.2f %9.2f %9.2f %10s\n", clients, p.ok, p.errors,
+           p.cutOff, requestRate(p), percentile(p.latencyMs, 50), percentile(p.latencyMs, 90), percentile(p.latencyMs, 99),
+           maximum(p.latencyMs), p.frameMs.size() / p.seconds, percentile(p.frameMs, 50), frameP99, maximum(p.frameMs),
+           vsIdle);
+    fflush(stdout);
+  }
+
+  if (options.jsonPath && !writeJson(options.jsonPath, phases))
+  {
+    fprintf(stderr, "Cannot write %s\n", options.jsonPath);
+    return 1;
+  }
+  return starved ? 1 : 0;
+}
@@ -0,0 +1,371 @@
+// Kernel microbenchmarks: the per-LED code paths of the effects, timed on the
+// host across ring sizes and compared with a locally stored baseline.
+//
+//   .pio/bench/kernel_bench --update             # store the results as the baseline
+//   make bench                                   # run, compare with .pio/bench/baseline.json
+//   .pio/bench/kernel_bench --json results.json  # also write the results
+//   .pio/bench/kernel_bench --strict             # exit non-zero on a regression
+//
+// Built like the tests (-DUNIT_TEST), so CRGB and CHSV are the host
+// stand-ins from effects.h and portal_effect.h. FastLED's own colour code
+// (hsv2rgb_rainbow, nscale8) is not built here and is not timed on its own;
+// the frame kernels include the stand-in CHSV conversion, so they track
+// layout and buffer work rather than FastLED's colour math. Absolute numbers
+// say little about the ESP8266; the ratios between runs on one machine are
+// what the baseline comparison is for. A baseline is only meaningful on the
+// machine (and compiler flags) that wrote it, so it is not checked in.
+//
+// One op is one pass over a buffer of the given number of LEDs. Bytes per
+// op counts the LED and coordinate data a pass reads and writes.
+#include "../src/config_manager.h"
+#include "../src/effects.h"
+#include "../src/led_arena.h"
+#include "../src/portal_effect.h"
+#include "../test/mock_led_driver.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static unsigned long simulatedMs = 0;
+
+extern "C" unsigned long millis() { return simulatedMs; }
+
+constexpr int MAX_BENCH_LEDS = 4096;
+constexpr int MAX_PORTAL_LEDS = PortalConfig::Hardware::MAX_LEDS_PER_RING;
+static const int SIZES[] = {32, 64, 128, 256, 512, 1024, 2048, 4096};
+
+typedef PortalEffectTemplate<MAX_PORTAL_LEDS, PortalConfig::Effects::GRADIENT_STEP_DEFAULT,
+                             PortalConfig::Effects::GRADIENT_MOVE_DEFAULT>
+    BenchPortal;
+
+static volatile uint32_t sink; // Keeps the optimizer from dropping the work
+
+static uint32_t checksum(const CRGB *leds, int count)
+{
+  uint32_t sum = 0;
+  for (int i = 0; i < count; i++)
+    sum += leds[i].r + leds[i].g * 3u + leds[i].b * 7u;
+  return sum;
+}
+
+/**
+ * @brief One kernel: prepares its state for a size, then runs one pass per call
+ */
+struct Kernel
+{
+  const char *name;
+  int maxLeds;        // Largest ring the code path supports
+  int bytesPerLed;    // Data read plus written per LED and pass
+  std::function<std::function<void()>(int leds)> prepare;
+};
+
+struct Result
+{
+  std::string name;
+  int leds;
+  double nsPerOp;
+  double nsPerLed;
+  unsigned long bytesPerOp;
+  unsigned long iterations;
+};
+
+/**
+ * @brief Effect on a mock driver, started and past its fade-in
+ */
+struct PortalRig
+{
+  LedArena arena;
+  MockLEDDriver<MAX_PORTAL_LEDS> driver;
+  BenchPortal portal;
+
+  PortalRig(int leds, int mode) : portal(&driver, &arena)
+  {
+    ConfigManager::begin();
+    ConfigManager::setPortalMode(mode);
+    ConfigManager::capture();
+    srand(1);
+    driver.length = leds;
+    arena.begin(BenchPortal::arenaBytes(leds));
+    portal.begin();
+    simulatedMs = 0;
+    portal.start();
+    simulatedMs = PortalConfig::Timing::FADE_IN_DURATION_MS + PortalConfig::Timing::UPDATE_INTERVAL_MS;
+    portal.update(simulatedMs);
+  }
+
+  void frame()
+  {
+    simulatedMs += PortalConfig::Timing::UPDATE_INTERVAL_MS;
+    portal.update(simulatedMs);
+  }
+};
+
+static std::vector<Kernel> kernels()
+{
+  static CRGB a[MAX_BENCH_LEDS], b[MAX_BENCH_LEDS];
+  static float xs[MAX_BENCH_LEDS], ys[MAX_BENCH_LEDS];
+  static std::unique_ptr<PortalRig> rig;
+
+  return {
+      // Gradient fill between two drivers, as in generatePortalEffect()
+      {"interpolate_color", MAX_BENCH_LEDS, 3, [](int n)
+       {
+         return [n]()
+         {
+           CRGB c1(20, 200, 90), c2(250, 10, 160);
+           for (int i = 0; i < n; i++)
+             a[i] = interpolateColor(c1, c2, (float)i / (n - 1));
+           sink = checksum(a, 1);
+         };
+       }},
+      // Ring rotation copy, the inner loop of portalEffect()
+      {"rotate_copy", MAX_BENCH_LEDS, 6, [](int n)
+       {
+         for (int i = 0; i < n; i++)
+           b[i] = CRGB((uint8_t)i, (uint8_t)(i >> 2), (uint8_t)(i >> 4));
+         return [n]()
+         {
+           static int position = 0;
+           position = (position + 3) % n;
+           for (int i = 0; i < n; i++)
+             a[i] = b[(i + position) % n];
+           sink = checksum(a, 1);
+         };
+       }},
+      {"led_position", MAX_BENCH_LEDS, 8, [](int n)
+       {
+         return [n]()
+         {
+           float radius = n / (2.0f * PortalConfig::Math::PI_F);
+           for (int i = 0; i < n; i++)
+             getLEDPosition(i, n, radius, xs[i], ys[i]);
+           sink = (uint32_t)xs[n / 3];
+         };
+       }},
+      // Random driver layout plus gradient fill of the whole ring
+      {"generate_gradient", MAX_PORTAL_LEDS, 3, [](int n)
+       {
+         rig.reset(new PortalRig(n, 0));
+         return [n]()
+         {
+           rig->portal.testGeneratePortalEffect(a);
+           sink = checksum(a, 1);
+         };
+       }},
+      // One classic frame: rotation copy through the driver interface
+      {"portal_frame", MAX_PORTAL_LEDS, 6, [](int n)
+       {
+         rig.reset(new PortalRig(n, 0));
+         return [n]()
+         {
+           rig->frame();
+           sink = checksum(rig->driver.buffer, 1);
+         };
+       }},
+      // One virtual-gradient frame: two sequences, driver search, CHSV per LED
+      {"virtual_gradient_frame", MAX_PORTAL_LEDS, 9, [](int n)
+       {
+         rig.reset(new PortalRig(n, 1));
+         return [n]()
+         {
+           rig->frame();
+           sink = checksum(rig->driver.buffer, 1);
+         };
+       }},
+  };
+}
+
+/**
+ * @brief Time a pass: best of several samples, each long enough to read the clock
+ */
+static Result measure(const Kernel &kernel, int leds, double sampleMs)
+{
+  typedef std::chrono::steady_clock Clock;
+  std::function<void()> pass = kernel.prepare(leds);
+  pass(); // Warm caches and first-frame state
+
+  unsigned long iterations = 1;
+  for (;;)
+  {
+    Clock::time_point start = Clock::now();
+    for (unsigned long i = 0; i < iterations; i++)
+      pass();
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    if (ms >= sampleMs || iterations >= (1ul << 30))
+      break;
+    iterations *= ms > 0 ? (unsigned long)(sampleMs / ms) + 1 : 10;
+  }
+
+  double best = 1e300;
+  for (int sample = 0; sample < 5; sample++)
+  {
+    Clock::time_point start = Clock::now();
+    for (unsigned long i = 0; i < iterations; i++)
+      pass();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    if (ns < best)
+      best = ns;
+  }
+  return {kernel.name, leds, best, best / leds, (unsigned long)kernel.bytesPerLed * leds, iterations};
+}
+
+static bool writeJson(const char *path, const std::vector<Result> &results)
+{
+  FILE *file = fopen(path, "w");
+  if (!file)
+    return false;
+  // One benchmark per line, so the file diffs well and readBaseline() stays simple
+  fprintf(file, "{\n  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const Result &r = results[i];
+    fprintf(file,
+            "    {\"name\": \"%s\", \"leds\": %d, \"ns_per_op\": %.1f, \"ns_per_led\": %.3f, \"bytes_per_op\": %lu, "
+            "\"iterations\": %lu}%s\n",
+            r.name.c_str(), r.leds, r.nsPerOp, r.nsPerLed, r.bytesPerOp, r.iterations,
+            i + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  fclose(file);
+  return true;
+}
+
+/**
+ * @brief Read a file written by writeJson()
+ * @return false if the file is missing
+ */
+static bool readBaseline(const char *path, std::vector<Result> &baseline)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return false;
+  char line[512];
+  while (fgets(line, sizeof(line), file))
+  {
+    char name[64];
+    Result r;
+    if (sscanf(line, " {\"name\": \"%63[^\"]\", \"leds\": %d, \"ns_per_op\": %lf", name, &r.leds, &r.nsPerOp) == 3)
+    {
+      r.name = name;
+      baseline.push_back(r);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+static const Result *find(const std::vector<Result> &results, const std::string &name, int leds)
+{
+  for (const Result &r : results)
+  {
+    if (r.name == name && r.leds == leds)
+      return &r;
+  }
+  return nullptr;
+}
+
+static void usage(const char *program)
+{
+  fprintf(stderr,
+          "usage: %s [--quick] [--filter NAME] [--json PATH] [--baseline PATH] [--threshold PCT] [--no-compare]\n"
+          "          [--strict] [--update]\n",
+          program);
+}
+
+int main(int argc, char **argv)
+{
+  const char *jsonPath = nullptr;
+  const char *baselinePath = ".pio/bench/baseline.json";
+  const char *filter = nullptr;
+  double thresholdPct = 25;
+  double sampleMs = 20;
+  bool compare = true;
+  bool strict = false;
+  bool update = false;
+  for (int i = 1; i < argc; i++)
+  {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--quick") == 0)
+      sampleMs = 2;
+    else if (strcmp(argv[i], "--no-compare") == 0)
+      compare = false;
+    else if (strcmp(argv[i], "--strict") == 0)
+      strict = true;
+    else if (strcmp(argv[i], "--update") == 0)
+      update = true;
+    else if (strcmp(argv[i], "--json") == 0 && hasValue)
+      jsonPath = argv[++i];
+    else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+      baselinePath = argv[++i];
+    else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+      filter = argv[++i];
+    else if (strcmp(argv[i], "--threshold") == 0 && hasValue)
+      thresholdPct = atof(argv[++i]);
+    else
+    {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<Result> baseline;
+  bool haveBaseline = compare && !update && readBaseline(baselinePath, baseline);
+  if (compare && !update && !haveBaseline)
+    printf("No baseline at %s - run with --update to create one\n", baselinePath);
+
+  printf("%-24s %6s %12s %10s %10s %9s\n", "kernel", "leds", "ns/op", "ns/led", "bytes/op", "vs base");
+  std::vector<Result> results;
+  int regressions = 0;
+  for (const Kernel &kernel : kernels())
+  {
+    if (filter && strstr(kernel.name, filter) == nullptr)
+      continue;
+    for (int leds : SIZES)
+    {
+      if (leds > kernel.maxLeds)
+        continue; // The effect does not drive rings this long
+      Result r = measure(kernel, leds, sampleMs);
+      results.push_back(r);
+
+      char delta[32] = "";
+      const Result *base = haveBaseline ? find(baseline, r.name, leds) : nullptr;
+      bool regressed = false;
+      if (base && base->nsPerOp > 0)
+      {
+        double pct = 100.0 * (r.nsPerOp - base->nsPerOp) / base->nsPerOp;
+        regressed = pct > thresholdPct;
+        snprintf(delta, sizeof(delta), "%+.1f%%", pct);
+      }
+      regressions += regressed;
+      printf("%-24s %6d %12.1f %10.3f %10lu %9s%s\n", r.name.c_str(), leds, r.nsPerOp, r.nsPerLed, r.bytesPerOp, delta,
+             regressed ? "  REGRESSION" : "");
+    }
+  }
+
+  if (jsonPath && !writeJson(jsonPath, results))
+  {
+    fprintf(stderr, "Cannot write %s\n", jsonPath);
+    return 1;
+  }
+  if (update)
+  {
+    if (!writeJson(baselinePath, results))
+    {
+      fprintf(stderr, "Cannot write %s\n", baselinePath);
+      return 1;
+    }
+    printf("Baseline written to %s\n", baselinePath);
+    return 0;
+  }
+  if (regressions > 0)
+  {
+    printf("%d benchmark(s) slower than the baseline by more than %.0f%%\n", regressions, thresholdPct);
+    return strict ? 1 : 0;
+  }
+  return 0;
+}
@@ -0,0 +1,10 @@
+# Portal show cue list - loaded from LittleFS at boot, started via /timeline?action=start
+# time(ms)  action       arguments
+0           mode         0
+0           hue          160 200
+0           speed        2
+0           toggle
+8000        speed        4
+12000       hue          180 230
+20000       malfunction
+23000       fadeout
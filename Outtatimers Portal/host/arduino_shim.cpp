@@ -0,0 +1,372 @@
+// Implementation of the virtual board: clock, pins, strips and the global
+// objects of the Arduino shims (Serial, ESP, WiFi, LittleFS, FastLED, SPI)
+#include "virtual_board.h"
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <FastLED.h>
+#include <LittleFS.h>
+#include <SPI.h>
+#include <chrono>
+#include <dirent.h>
+#include <errno.h>
+#include <malloc.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+ESP8266WiFiClass WiFi;
+FS LittleFS;
+CFastLED FastLED;
+SPIClass SPI;
+
+namespace
+{
+  bool realTime = false;
+  uint64_t virtualUs = 0;
+  const auto wallStart = std::chrono::steady_clock::now();
+
+  struct Pin
+  {
+    int mode = INPUT;
+    int level = HIGH; // Unconnected inputs read high, like pulled-up buttons
+    void (*handler)(void *) = nullptr;
+    void *arg = nullptr;
+    int interruptMode = 0;
+  };
+  Pin pins[VirtualBoard::PIN_COUNT];
+
+  constexpr int MAX_STRIPS = 8;
+  VirtualBoard::Strip strips[MAX_STRIPS];
+  bool gapPaused[MAX_STRIPS];
+  int stripCount = 0;
+
+  int portOffset = 0;
+  int serialIn = -1;
+  int serialOut = STDOUT_FILENO;
+  std::string fsRoot = ".";
+  uint32_t chipId = 0x00C0FFEE;
+
+  // Heap the firmware would see on a D1 mini after the core and WiFi stack
+  constexpr uint32_t VIRTUAL_HEAP_BYTES = 48 * 1024;
+  size_t heapBaseline = 0;
+  bool heapBaselineSet = false;
+
+  bool validPin(int pin) { return pin >= 0 && pin < VirtualBoard::PIN_COUNT; }
+
+  bool makeDirectories(const std::string &path)
+  {
+    for (size_t slash = path.find('/', 1);; slash = path.find('/', slash + 1))
+    {
+      std::string prefix = path.substr(0, slash);
+      if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+        return false;
+      if (slash == std::string::npos)
+        return true;
+    }
+  }
+
+  bool copyFile(const std::string &from, const std::string &to)
+  {
+    FILE *in = fopen(from.c_str(), "rb");
+    FILE *out = in ? fopen(to.c_str(), "wb") : nullptr;
+    char chunk[4096];
+    size_t n;
+    while (out && (n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+      fwrite(chunk, 1, n, out);
+    if (in)
+      fclose(in);
+    if (out)
+      fclose(out);
+    return out != nullptr;
+  }
+}
+
+// Clock
+
+void VirtualBoard::setRealTime(bool enable) { realTime = enable; }
+bool VirtualBoard::isRealTime() { return realTime; }
+
+uint64_t VirtualBoard::nowUs()
+{
+  if (!realTime)
+    return virtualUs;
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wallStart)
+      .count();
+}
+
+void VirtualBoard::advanceUs(uint64_t us)
+{
+  if (realTime)
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  else
+    virtualUs += us;
+}
+
+unsigned long millis() { return (unsigned long)(VirtualBoard::nowUs() / 1000); }
+unsigned long micros() { return (unsigned long)VirtualBoard::nowUs(); }
+uint64_t micros64() { return VirtualBoard::nowUs(); }
+void delay(unsigned long ms) { VirtualBoard::advanceUs((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { VirtualBoard::advanceUs(us); }
+void yield() {}
+
+// GPIO
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (validPin(pin))
+    pins[pin].mode = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (validPin(pin) && pins[pin].mode == OUTPUT)
+    pins[pin].level = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) { return validPin(pin) ? pins[pin].level : LOW; }
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode)
+{
+  if (!validPin(pin))
+    return;
+  pins[pin].handler = handler;
+  pins[pin].arg = arg;
+  pins[pin].interruptMode = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  if (validPin(pin))
+    pins[pin].handler = nullptr;
+}
+
+void VirtualBoard::setInput(int pin, int level)
+{
+  if (!validPin(pin) || pins[pin].mode == OUTPUT)
+    return;
+  level = level ? HIGH : LOW;
+  if (level == pins[pin].level)
+    return;
+  pins[pin].level = level;
+  Pin &p = pins[pin];
+  bool fire = p.interruptMode == CHANGE || (p.interruptMode == RISING && level == HIGH) ||
+              (p.interruptMode == FALLING && level == LOW);
+  if (p.handler && fire)
+    p.handler(p.arg);
+}
+
+int VirtualBoard::getLevel(int pin) { return validPin(pin) ? pins[pin].level : LOW; }
+
+uint32_t VirtualBoard::readInputs()
+{
+  uint32_t bits = 0;
+  for (int pin = 0; pin < 16; pin++)
+    bits |= (uint32_t)(pins[pin].level == HIGH) << pin;
+  return bits;
+}
+
+// Random numbers
+
+long random(long max) { return max <= 0 ? 0 : rand() % max; }
+long random(long min, long max) { return max <= min ? min : min + rand() % (max - min); }
+void randomSeed(unsigned long seed) { srand((unsigned)seed); }
+
+// LED strips
+
+void VirtualBoard::addStrip(int pin, const CRGB *data, int length)
+{
+  if (stripCount == MAX_STRIPS)
+    return;
+  strips[stripCount++] = {pin, length, data, 255, 0, 0, 0};
+}
+
+void VirtualBoard::recordShow(int pin, uint8_t brightness)
+{
+  for (int i = 0; i < stripCount; i++)
+  {
+    Strip &strip = strips[i];
+    if (strip.pin != pin)
+      continue;
+    uint64_t now = nowUs();
+    if (strip.shows > 0 && !gapPaused[i] && now - strip.lastShowUs > strip.longestGapUs)
+      strip.longestGapUs = now - strip.lastShowUs;
+    gapPaused[i] = false;
+    strip.brightness = brightness;
+    strip.lastShowUs = now;
+    strip.shows++;
+    return;
+  }
+}
+
+void VirtualBoard::restartFrameGaps()
+{
+  for (int i = 0; i < stripCount; i++)
+    gapPaused[i] = true;
+}
+
+const VirtualBoard::Strip *VirtualBoard::getStrip(int pin)
+{
+  for (int i = 0; i < stripCount; i++)
+  {
+    if (strips[i].pin == pin)
+      return &strips[i];
+  }
+  return nullptr;
+}
+
+// Network, serial, file system, chip
+
+void VirtualBoard::setPortOffset(int offset) { portOffset = offset; }
+int VirtualBoard::getPortOffset() { return portOffset; }
+
+void VirtualBoard::setSerialFds(int inFd, int outFd)
+{
+  serialIn = inFd;
+  serialOut = outFd;
+}
+int VirtualBoard::getSerialInFd() { return serialIn; }
+int VirtualBoard::getSerialOutFd() { return serialOut; }
+
+void VirtualBoard::setFsRoot(const char *directory) { fsRoot = directory; }
+const char *VirtualBoard::getFsRoot() { return fsRoot.c_str(); }
+
+int VirtualBoard::prepareFs(const char *directory, const char *dataDir)
+{
+  if (!makeDirectories(directory))
+    return -1;
+  DIR *dir = dataDir ? opendir(dataDir) : nullptr;
+  if (dir == nullptr)
+    return 0;
+  int copied = 0;
+  while (dirent *entry = readdir(dir))
+  {
+    std::string from = std::string(dataDir) + "/" + entry->d_name;
+    struct stat info;
+    if (entry->d_name[0] == '.' || stat(from.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+      continue;
+    copied += copyFile(from, std::string(directory) + "/" + entry->d_name);
+  }
+  closedir(dir);
+  return copied;
+}
+
+void VirtualBoard::setChipId(uint32_t id) { chipId = id; }
+uint32_t VirtualBoard::getChipId() { return chipId; }
+
+// HardwareSerial
+
+int HardwareSerial::available()
+{
+  // One byte of look-ahead is enough for the read() loops of the firmware
+  return serialIn >= 0 && peeked_ >= 0 ? 1 : (serialIn >= 0 && (peeked_ = readByte()) >= 0);
+}
+
+int HardwareSerial::read()
+{
+  if (!available())
+    return -1;
+  int byte = peeked_;
+  peeked_ = -1;
+  return byte;
+}
+
+int HardwareSerial::readByte()
+{
+  uint8_t byte;
+  return ::read(serialIn, &byte, 1) == 1 ? byte : -1;
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t length)
+{
+  if (serialOut < 0)
+    return length;
+  size_t written = 0;
+  while (written < length)
+  {
+    ssize_t n = ::write(serialOut, data + written, length - written);
+    if (n <= 0)
+      break;
+    written += (size_t)n;
+  }
+  return written;
+}
+
+size_t HardwareSerial::printf(const char *format, ...)
+{
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  return n > 0 ? write(reinterpret_cast<const uint8_t *>(text), strlen(text)) : 0;
+}
+
+// ESP
+
+uint32_t EspClass::getChipId() { return VirtualBoard::getChipId(); }
+
+uint32_t EspClass::getFreeHeap()
+{
+  size_t used = mallinfo2().uordblks;
+  if (!heapBaselineSet)
+  {
+    heapBaseline = used;
+    heapBaselineSet = true;
+  }
+  size_t grown = used > heapBaseline ? used - heapBaseline : 0;
+  return grown < VIRTUAL_HEAP_BYTES ? VIRTUAL_HEAP_BYTES - (uint32_t)grown : 0;
+}
+
+void EspClass::restart()
+{
+  Serial.println("ESP.restart() - virtual board halted");
+  exit(0);
+}
+
+// LittleFS
+
+bool FS::hostPath(const char *path, std::string &hostPath)
+{
+  if (path == nullptr || path[0] != '/' || strstr(path, "..") != nullptr)
+    return false;
+  hostPath = fsRoot + path;
+  return true;
+}
+
+bool FS::begin()
+{
+  struct stat info;
+  return stat(fsRoot.c_str(), &info) == 0 ? S_ISDIR(info.st_mode) : mkdir(fsRoot.c_str(), 0755) == 0;
+}
+
+File FS::open(const char *path, const char *mode)
+{
+  std::string host;
+  if (!hostPath(path, host))
+    return File();
+  const char *hostMode = mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb";
+  FILE *file = fopen(host.c_str(), hostMode);
+  return file ? File(file) : File();
+}
+
+bool FS::exists(const char *path)
+{
+  std::string host;
+  struct stat info;
+  return hostPath(path, host) && stat(host.c_str(), &info) == 0;
+}
+
+bool FS::remove(const char *path)
+{
+  std::string host;
+  return hostPath(path, host) && ::remove(host.c_str()) == 0;
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+  std::string hostFrom, hostTo;
+  return hostPath(from, hostFrom) && hostPath(to, hostTo) && ::rename(hostFrom.c_str(), hostTo.c_str()) == 0;
+}
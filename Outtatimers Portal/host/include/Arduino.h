@@ -0,0 +1,157 @@
+// Arduino core stand-in for the virtual board (see host/virtual_board.cpp)
+//
+// Covers the subset of the ESP8266 Arduino core the firmware uses: time,
+// GPIO, random numbers, String, HardwareSerial and the ESP object.
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define F(string) (string)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define GPI (VirtualBoard::readInputs())
+
+#include "../virtual_board.h"
+
+// Time
+unsigned long millis();
+unsigned long micros();
+uint64_t micros64();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+inline int digitalPinToInterrupt(int pin) { return pin; }
+
+// Random numbers (ESP8266 core semantics: [0, max) and [min, max))
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/**
+ * @brief Minimal Arduino String: enough for request arguments
+ */
+class String
+{
+public:
+  String() : buffer_(dup("")) {}
+  String(const char *text) : buffer_(dup(text ? text : "")) {}
+  String(const String &other) : buffer_(dup(other.buffer_)) {}
+  String &operator=(const String &other)
+  {
+    if (this != &other)
+    {
+      free(buffer_);
+      buffer_ = dup(other.buffer_);
+    }
+    return *this;
+  }
+  ~String() { free(buffer_); }
+
+  const char *c_str() const { return buffer_; }
+  unsigned int length() const { return (unsigned int)strlen(buffer_); }
+  long toInt() const { return strtol(buffer_, nullptr, 10); }
+  bool operator==(const char *text) const { return strcmp(buffer_, text) == 0; }
+  bool operator==(const String &other) const { return strcmp(buffer_, other.buffer_) == 0; }
+  bool operator!=(const char *text) const { return !(*this == text); }
+
+private:
+  char *buffer_;
+
+  static char *dup(const char *text)
+  {
+    size_t size = strlen(text) + 1;
+    char *copy = static_cast<char *>(malloc(size));
+    memcpy(copy, text, size);
+    return copy;
+  }
+};
+
+/**
+ * @brief UART stand-in: log output to a file descriptor, input from another
+ */
+class HardwareSerial
+{
+public:
+  void begin(unsigned long baud) { (void)baud; }
+
+  int available();
+  int read();
+  int availableForWrite() { return 256; } // Like the ESP8266 UART TX buffer
+  size_t write(const uint8_t *data, size_t length);
+  size_t write(uint8_t byte) { return write(&byte, 1); }
+
+  size_t print(const char *text) { return write(reinterpret_cast<const uint8_t *>(text), strlen(text)); }
+  size_t print(const String &text) { return print(text.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value) { return printf("%u", (unsigned)value); }
+  size_t print(int value) { return printf("%d", value); }
+  size_t print(unsigned int value) { return printf("%u", value); }
+  size_t print(long value) { return printf("%ld", value); }
+  size_t print(unsigned long value) { return printf("%lu", value); }
+  size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+
+  size_t println() { return print("\r\n"); }
+  template <typename T>
+  size_t println(const T &value)
+  {
+    size_t n = print(value);
+    return n + println();
+  }
+  size_t println(double value, int digits) { return print(value, digits) + println(); }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+  int peeked_ = -1;
+
+  int readByte();
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief The ESP object: chip identity and heap figures
+ *
+ * Heap figures model a fixed ESP8266 heap from which the host process's
+ * live allocations (since boot) are subtracted, so leaks show up in
+ * HeapMonitor exactly as they would on the device.
+ */
+class EspClass
+{
+public:
+  uint32_t getChipId();
+  uint32_t getFreeHeap();
+  uint32_t getMaxFreeBlockSize() { return getFreeHeap(); }
+  uint8_t getHeapFragmentation() { return 0; }
+  uint32_t getFreeContStack() { return 4096; }
+  void restart();
+};
+
+extern EspClass ESP;
@@ -0,0 +1,334 @@
+// ESP8266WebServer stand-in for the virtual board, on POSIX sockets
+//
+// Behaves like the ESP8266 server from the firmware's point of view: one
+// client is served per handleClient() call, inside loop(), and the
+// connection is closed after the response. Requests queue in the listen
+// backlog meanwhile, so a busy client slows the render loop as it would on
+// the device. GET query arguments and url-encoded POST bodies are parsed.
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <functional>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+enum HTTPMethod
+{
+  HTTP_ANY,
+  HTTP_GET,
+  HTTP_HEAD,
+  HTTP_POST,
+  HTTP_PUT,
+  HTTP_PATCH,
+  HTTP_DELETE,
+  HTTP_OPTIONS
+};
+
+class ESP8266WebServer
+{
+public:
+  typedef std::function<void()> THandlerFunction;
+
+  static constexpr int REQUEST_TIMEOUT_MS = 1000; // Wall time to wait for a complete request
+  static constexpr size_t MAX_REQUEST_BYTES = 8192;
+
+  explicit ESP8266WebServer(int port = 80)
+      : port_(port), listenFd_(-1), clientFd_(-1), method_(HTTP_GET), responded_(false), served_(0) {}
+  ~ESP8266WebServer()
+  {
+    if (listenFd_ >= 0)
+      close(listenFd_);
+  }
+
+  void begin()
+  {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0)
+      return;
+    int on = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)(port_ + VirtualBoard::getPortOffset()));
+    if (bind(listenFd_, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd_, 64) != 0)
+    {
+      fprintf(stderr, "virtual board: cannot listen on TCP port %d: %s\n", port_ + VirtualBoard::getPortOffset(),
+              strerror(errno));
+      close(listenFd_);
+      listenFd_ = -1;
+      return;
+    }
+    fcntl(listenFd_, F_SETFL, fcntl(listenFd_, F_GETFL, 0) | O_NONBLOCK);
+  }
+
+  void on(const char *uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+  void on(const char *uri, HTTPMethod method, THandlerFunction handler) { routes_.push_back({uri, method, handler}); }
+  void onNotFound(THandlerFunction handler) { notFound_ = handler; }
+
+  /**
+   * @brief Serve at most one waiting client (never waits for a connection)
+   */
+  void handleClient()
+  {
+    if (listenFd_ < 0)
+      return;
+    clientFd_ = accept(listenFd_, nullptr, nullptr);
+    if (clientFd_ < 0)
+      return;
+    int on = 1;
+    setsockopt(clientFd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (readRequest())
+      dispatch();
+    close(clientFd_);
+    clientFd_ = -1;
+    served_++;
+  }
+
+  void sendHeader(const char *name, const char *value, bool first = false)
+  {
+    std::string line = std::string(name) + ": " + value + "\r\n";
+    headers_ = first ? line + headers_ : headers_ + line;
+  }
+
+  void send(int code, const char *contentType, const char *content)
+  {
+    send(code, contentType, reinterpret_cast<const uint8_t *>(content), strlen(content));
+  }
+  void send(int code, const char *contentType, const String &content) { send(code, contentType, content.c_str()); }
+
+  void send(int code, const char *contentType, const uint8_t *content, size_t length)
+  {
+    sendHead(code, contentType, length);
+    writeAll(content, length);
+  }
+
+  template <typename T>
+  size_t streamFile(T &file, const char *contentType)
+  {
+    size_t length = file.size();
+    sendHead(200, contentType, length);
+    uint8_t chunk[1460];
+    size_t sent = 0;
+    size_t n;
+    while ((n = file.read(chunk, sizeof(chunk))) > 0)
+    {
+      writeAll(chunk, n);
+      sent += n;
+    }
+    return sent;
+  }
+
+  bool hasArg(const char *name) const { return findArg(name) != nullptr; }
+  String arg(const char *name) const
+  {
+    const std::string *value = findArg(name);
+    return String(value ? value->c_str() : "");
+  }
+  int args() const { return (int)args_.size(); }
+  String uri() const { return String(uri_.c_str()); }
+  HTTPMethod method() const { return method_; }
+
+  /**
+   * @brief Requests served since begin()
+   */
+  unsigned long getServedCount() const { return served_; }
+
+private:
+  struct Route
+  {
+    std::string uri;
+    HTTPMethod method;
+    THandlerFunction handler;
+  };
+
+  int port_;
+  int listenFd_;
+  int clientFd_;
+  HTTPMethod method_;
+  std::string uri_;
+  std::vector<std::pair<std::string, std::string>> args_;
+  std::string headers_;
+  bool responded_;
+  std::vector<Route> routes_;
+  THandlerFunction notFound_;
+  unsigned long served_;
+
+  bool readRequest()
+  {
+    std::string request;
+    size_t headerEnd = std::string::npos;
+    size_t contentLength = 0;
+    char chunk[2048];
+    pollfd pfd = {clientFd_, POLLIN, 0};
+    while (request.size() < MAX_REQUEST_BYTES)
+    {
+      if (headerEnd != std::string::npos && request.size() >= headerEnd + 4 + contentLength)
+        break;
+      if (poll(&pfd, 1, REQUEST_TIMEOUT_MS) <= 0)
+        return false;
+      ssize_t n = recv(clientFd_, chunk, sizeof(chunk), 0);
+      if (n <= 0)
+        return false;
+      request.append(chunk, (size_t)n);
+      if (headerEnd == std::string::npos && (headerEnd = request.find("\r\n\r\n")) != std::string::npos)
+        contentLength = headerValue(request.substr(0, headerEnd), "content-length");
+    }
+    if (headerEnd == std::string::npos)
+      return false;
+
+    size_t methodEnd = request.find(' ');
+    size_t uriEnd = request.find(' ', methodEnd + 1);
+    if (methodEnd == std::string::npos || uriEnd == std::string::npos)
+      return false;
+    method_ = parseMethod(request.substr(0, methodEnd));
+    std::string target = request.substr(methodEnd + 1, uriEnd - methodEnd - 1);
+    size_t query = target.find('?');
+    uri_ = urlDecode(target.substr(0, query));
+    args_.clear();
+    if (query != std::string::npos)
+      parseArgs(target.substr(query + 1));
+    if (method_ == HTTP_POST && contentLength > 0)
+      parseArgs(request.substr(headerEnd + 4, contentLength));
+    return true;
+  }
+
+  void dispatch()
+  {
+    headers_.clear();
+    responded_ = false;
+    for (const Route &route : routes_)
+    {
+      if (route.uri == uri_ && (route.method == HTTP_ANY || route.method == method_))
+      {
+        route.handler();
+        break;
+      }
+    }
+    if (!responded_ && notFound_)
+      notFound_();
+    if (!responded_)
+      send(500, "text/plain", "No response");
+  }
+
+  void sendHead(int code, const char *contentType, size_t length)
+  {
+    char head[256];
+    snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n",
+             code, reason(code), contentType, length);
+    std::string response = head + headers_ + "\r\n";
+    writeAll(reinterpret_cast<const uint8_t *>(response.data()), response.size());
+    headers_.clear();
+    responded_ = true;
+  }
+
+  void writeAll(const uint8_t *data, size_t length)
+  {
+    while (length > 0 && clientFd_ >= 0)
+    {
+      ssize_t n = ::send(clientFd_, data, length, MSG_NOSIGNAL);
+      if (n <= 0)
+        return;
+      data += n;
+      length -= (size_t)n;
+    }
+  }
+
+  const std::string *findArg(const char *name) const
+  {
+    for (const auto &arg : args_)
+    {
+      if (arg.first == name)
+        return &arg.second;
+    }
+    return nullptr;
+  }
+
+  void parseArgs(const std::string &text)
+  {
+    size_t start = 0;
+    while (start < text.size())
+    {
+      size_t end = text.find('&', start);
+      if (end == std::string::npos)
+        end = text.size();
+      std::string pair = text.substr(start, end - start);
+      size_t equals = pair.find('=');
+      if (!pair.empty())
+        args_.push_back({urlDecode(pair.substr(0, equals)),
+                         equals == std::string::npos ? "" : urlDecode(pair.substr(equals + 1))});
+      start = end + 1;
+    }
+  }
+
+  static std::string urlDecode(const std::string &text)
+  {
+    std::string decoded;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+      if (text[i] == '+')
+        decoded += ' ';
+      else if (text[i] == '%' && i + 2 < text.size() && isxdigit((unsigned char)text[i + 1]) &&
+               isxdigit((unsigned char)text[i + 2]))
+      {
+        decoded += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+        i += 2;
+      }
+      else
+        decoded += text[i];
+    }
+    return decoded;
+  }
+
+  static size_t headerValue(const std::string &head, const char *name)
+  {
+    std::string lower = head;
+    for (char &c : lower)
+      c = (char)tolower((unsigned char)c);
+    size_t at = lower.find(std::string("\r\n") + name + ":");
+    return at == std::string::npos ? 0 : (size_t)strtoul(head.c_str() + at + strlen(name) + 3, nullptr, 10);
+  }
+
+  static HTTPMethod parseMethod(const std::string &method)
+  {
+    if (method == "POST")
+      return HTTP_POST;
+    if (method == "HEAD")
+      return HTTP_HEAD;
+    if (method == "PUT")
+      return HTTP_PUT;
+    if (method == "PATCH")
+      return HTTP_PATCH;
+    if (method == "DELETE")
+      return HTTP_DELETE;
+    if (method == "OPTIONS")
+      return HTTP_OPTIONS;
+    return HTTP_GET;
+  }
+
+  static const char *reason(int code)
+  {
+    switch (code)
+    {
+    case 200:
+      return "OK";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    default:
+      return code < 400 ? "OK" : "Error";
+    }
+  }
+};
@@ -0,0 +1,61 @@
+// ESP8266WiFi stand-in for the virtual board: the station is always
+// connected and the board's address is the host's loopback address.
+#pragma once
+
+#include <Arduino.h>
+
+#define WL_IDLE_STATUS 0
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+#define WIFI_OFF 0
+#define WIFI_STA 1
+#define WIFI_AP 2
+#define WIFI_AP_STA 3
+
+/**
+ * @brief IPv4 address, stored in network byte order like the ESP8266 core
+ */
+class IPAddress
+{
+public:
+  IPAddress() : address_(0) {}
+  IPAddress(uint32_t address) : address_(address) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : address_((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+
+  operator uint32_t() const { return address_; }
+  uint8_t operator[](int index) const { return (uint8_t)(address_ >> (8 * index)); }
+
+private:
+  uint32_t address_;
+};
+
+class ESP8266WiFiClass
+{
+public:
+  ESP8266WiFiClass() : status_(WL_IDLE_STATUS), mode_(WIFI_STA) {}
+
+  int begin(const char *ssid, const char *password)
+  {
+    (void)ssid;
+    (void)password;
+    status_ = WL_CONNECTED;
+    return status_;
+  }
+  int status() const { return status_; }
+  int getMode() const { return mode_; }
+  bool mode(int mode)
+  {
+    mode_ = mode;
+    return true;
+  }
+  IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+  int softAPgetStationNum() const { return 0; }
+
+private:
+  int status_;
+  int mode_;
+};
+
+extern ESP8266WiFiClass WiFi;
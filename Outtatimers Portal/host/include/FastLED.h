@@ -0,0 +1,159 @@
+// FastLED stand-in for the virtual board
+//
+// CRGB and nscale8() follow FastLED's arithmetic. CHSV uses a plain
+// six-sector conversion instead of FastLED's rainbow map, so hues look
+// slightly different from the real strip. show() reports the frame to the
+// board and takes as long as clocking it out to WS2812 LEDs would.
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+enum EOrder
+{
+  RGB = 0012,
+  RBG = 0021,
+  GRB = 0102,
+  GBR = 0120,
+  BRG = 0201,
+  BGR = 0210
+};
+
+struct CHSV
+{
+  uint8_t h, s, v;
+  CHSV() : h(0), s(0), v(0) {}
+  CHSV(uint8_t hue, uint8_t sat, uint8_t val) : h(hue), s(sat), v(val) {}
+};
+
+struct CRGB
+{
+  uint8_t r, g, b;
+
+  enum HTMLColorCode : uint32_t
+  {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Green = 0x008000,
+    Red = 0xFF0000,
+    White = 0xFFFFFF
+  };
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+  CRGB(HTMLColorCode code) : r((code >> 16) & 0xFF), g((code >> 8) & 0xFF), b(code & 0xFF) {}
+  CRGB(const CHSV &hsv) { fromHsv(hsv); }
+
+  CRGB &operator=(const CHSV &hsv)
+  {
+    fromHsv(hsv);
+    return *this;
+  }
+
+  /**
+   * @brief Scale towards black by scale/256ths, like FastLED's scale8()
+   */
+  CRGB &nscale8(uint8_t scale)
+  {
+    r = (uint8_t)(((uint16_t)r * (1 + scale)) >> 8);
+    g = (uint8_t)(((uint16_t)g * (1 + scale)) >> 8);
+    b = (uint8_t)(((uint16_t)b * (1 + scale)) >> 8);
+    return *this;
+  }
+
+private:
+  void fromHsv(const CHSV &hsv)
+  {
+    uint8_t sector = hsv.h / 43;
+    uint8_t rest = (uint8_t)((hsv.h - sector * 43) * 6);
+    uint8_t p = (uint8_t)((hsv.v * (255 - hsv.s)) >> 8);
+    uint8_t q = (uint8_t)((hsv.v * (255 - ((hsv.s * rest) >> 8))) >> 8);
+    uint8_t t = (uint8_t)((hsv.v * (255 - ((hsv.s * (255 - rest)) >> 8))) >> 8);
+    switch (sector)
+    {
+    case 0:
+      r = hsv.v, g = t, b = p;
+      break;
+    case 1:
+      r = q, g = hsv.v, b = p;
+      break;
+    case 2:
+      r = p, g = hsv.v, b = t;
+      break;
+    case 3:
+      r = p, g = q, b = hsv.v;
+      break;
+    case 4:
+      r = t, g = p, b = hsv.v;
+      break;
+    default:
+      r = hsv.v, g = p, b = q;
+      break;
+    }
+  }
+};
+
+inline void fill_solid(CRGB *leds, int count, const CRGB &color)
+{
+  for (int i = 0; i < count; i++)
+    leds[i] = color;
+}
+
+template <uint8_t DATA_PIN, EOrder ORDER>
+class WS2812B
+{
+};
+
+/**
+ * @brief One strip on one data pin
+ */
+class CLEDController
+{
+public:
+  CLEDController() : pin_(-1), data_(nullptr), length_(0) {}
+  CLEDController(int pin, CRGB *data, int length) : pin_(pin), data_(data), length_(length)
+  {
+    VirtualBoard::addStrip(pin, data, length);
+  }
+
+  /**
+   * @brief Push the frame at the given brightness (blocks for the wire time)
+   */
+  void showLeds(uint8_t brightness)
+  {
+    // WS2812: 30 us per LED plus the 50 us latch
+    VirtualBoard::advanceUs(30ull * length_ + 50);
+    VirtualBoard::recordShow(pin_, brightness);
+  }
+
+  int size() const { return length_; }
+  CRGB *leds() { return data_; }
+
+private:
+  int pin_;
+  CRGB *data_;
+  int length_;
+};
+
+class CFastLED
+{
+public:
+  static constexpr int MAX_CONTROLLERS = 8;
+
+  CFastLED() : count_(0) {}
+
+  template <template <uint8_t, EOrder> class CHIPSET, uint8_t DATA_PIN, EOrder ORDER>
+  CLEDController &addLeds(CRGB *data, int length)
+  {
+    if (count_ == MAX_CONTROLLERS)
+      abort();
+    controllers_[count_] = CLEDController(DATA_PIN, data, length);
+    return controllers_[count_++];
+  }
+
+private:
+  CLEDController controllers_[MAX_CONTROLLERS];
+  int count_;
+};
+
+extern CFastLED FastLED;
@@ -0,0 +1,87 @@
+// LittleFS stand-in for the virtual board, backed by a host directory
+//
+// "/config.log" lives at <fs root>/config.log; the root is set with
+// VirtualBoard::setFsRoot(). Files are flat like on the portal, and paths
+// that try to leave the root are refused.
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+enum SeekMode
+{
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2
+};
+
+/**
+ * @brief Open file handle; copies share the handle, like the ESP8266 core
+ */
+class File
+{
+public:
+  File() {}
+  explicit File(FILE *file) : file_(file, fclose) {}
+
+  explicit operator bool() const { return file_ != nullptr; }
+
+  size_t size() const
+  {
+    if (!file_)
+      return 0;
+    long position = ftell(file_.get());
+    fseek(file_.get(), 0, SEEK_END);
+    long end = ftell(file_.get());
+    fseek(file_.get(), position, SEEK_SET);
+    return end > 0 ? (size_t)end : 0;
+  }
+
+  size_t position() const { return file_ ? (size_t)ftell(file_.get()) : 0; }
+  int available() const { return file_ ? (int)(size() - position()) : 0; }
+
+  bool seek(size_t position, SeekMode mode = SeekSet)
+  {
+    static const int whence[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    return file_ && fseek(file_.get(), (long)position, whence[mode]) == 0;
+  }
+
+  int read()
+  {
+    return file_ ? fgetc(file_.get()) : -1;
+  }
+
+  size_t read(uint8_t *buffer, size_t length) { return file_ ? fread(buffer, 1, length, file_.get()) : 0; }
+
+  size_t readBytesUntil(char terminator, char *buffer, size_t length)
+  {
+    size_t n = 0;
+    int c;
+    while (n < length && (c = read()) >= 0 && c != terminator)
+      buffer[n++] = (char)c;
+    return n;
+  }
+
+  size_t write(const uint8_t *data, size_t length) { return file_ ? fwrite(data, 1, length, file_.get()) : 0; }
+
+  void close() { file_.reset(); }
+
+private:
+  std::shared_ptr<FILE> file_;
+};
+
+class FS
+{
+public:
+  bool begin();
+  File open(const char *path, const char *mode);
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+
+private:
+  static bool hostPath(const char *path, std::string &hostPath);
+};
+
+extern FS LittleFS;
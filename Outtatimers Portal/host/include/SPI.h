@@ -0,0 +1,31 @@
+// SPI stand-in for the virtual board: no devices are attached, so every
+// transfer reads 0xFF (inputs pulled up)
+#pragma once
+
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+
+class SPISettings
+{
+public:
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+  {
+    (void)clock;
+    (void)bitOrder;
+    (void)dataMode;
+  }
+};
+
+class SPIClass
+{
+public:
+  void begin() {}
+  void beginTransaction(const SPISettings &) {}
+  uint8_t transfer(uint8_t) { return 0xFF; }
+  void endTransaction() {}
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,122 @@
+// WiFiUDP stand-in for the virtual board, on a non-blocking POSIX socket
+//
+// Local ports and broadcast destinations are shifted by the board's port
+// offset, so boards on one host talk to each other but not to privileged
+// ports. Replies to a sender go to the sender's real port.
+#pragma once
+
+#include <ESP8266WiFi.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class WiFiUDP
+{
+public:
+  WiFiUDP() : fd_(-1), length_(0), offset_(0), remoteIP_(0), remotePort_(0), outIP_(0), outPort_(0), outLength_(0) {}
+  ~WiFiUDP() { stop(); }
+  WiFiUDP(const WiFiUDP &) = delete;
+  WiFiUDP &operator=(const WiFiUDP &) = delete;
+
+  uint8_t begin(uint16_t port)
+  {
+    if (!open())
+      return 0;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)(port + VirtualBoard::getPortOffset()));
+    return bind(fd_, (sockaddr *)&addr, sizeof(addr)) == 0 ? 1 : 0;
+  }
+
+  void stop()
+  {
+    if (fd_ >= 0)
+      close(fd_);
+    fd_ = -1;
+  }
+
+  int parsePacket()
+  {
+    length_ = offset_ = 0;
+    if (fd_ < 0)
+      return 0;
+    sockaddr_in from;
+    socklen_t fromLength = sizeof(from);
+    ssize_t n = recvfrom(fd_, datagram_, sizeof(datagram_), 0, (sockaddr *)&from, &fromLength);
+    if (n <= 0)
+      return 0;
+    length_ = (size_t)n;
+    remoteIP_ = from.sin_addr.s_addr;
+    remotePort_ = ntohs(from.sin_port);
+    return (int)n;
+  }
+
+  int read(uint8_t *buffer, size_t length)
+  {
+    size_t n = length < length_ - offset_ ? length : length_ - offset_;
+    memcpy(buffer, datagram_ + offset_, n);
+    offset_ += n;
+    return (int)n;
+  }
+
+  IPAddress remoteIP() { return IPAddress(remoteIP_); }
+  uint16_t remotePort() { return remotePort_; }
+
+  int beginPacket(IPAddress ip, uint16_t port)
+  {
+    if (!open())
+      return 0;
+    outIP_ = ip;
+    outPort_ = outIP_ == INADDR_BROADCAST ? (uint16_t)(port + VirtualBoard::getPortOffset()) : port;
+    outLength_ = 0;
+    return 1;
+  }
+
+  size_t write(const uint8_t *data, size_t length)
+  {
+    size_t n = length < sizeof(out_) - outLength_ ? length : sizeof(out_) - outLength_;
+    memcpy(out_ + outLength_, data, n);
+    outLength_ += n;
+    return n;
+  }
+
+  int endPacket()
+  {
+    sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = outIP_;
+    to.sin_port = htons(outPort_);
+    return sendto(fd_, out_, outLength_, 0, (sockaddr *)&to, sizeof(to)) == (ssize_t)outLength_ ? 1 : 0;
+  }
+
+private:
+  int fd_;
+  uint8_t datagram_[1500];
+  size_t length_;
+  size_t offset_;
+  uint32_t remoteIP_;
+  uint16_t remotePort_;
+  uint32_t outIP_;
+  uint16_t outPort_;
+  uint8_t out_[1500];
+  size_t outLength_;
+
+  bool open()
+  {
+    if (fd_ >= 0)
+      return true;
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0)
+      return false;
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd_, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+  }
+};
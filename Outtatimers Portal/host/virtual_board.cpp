@@ -0,0 +1,244 @@
+// Virtual board: runs the unmodified firmware (src/main.cpp) on the host
+//
+// The firmware is compiled for the device code path against the Arduino
+// shims in host/include/, so setup() and loop() run exactly as on the
+// ESP8266: the web server answers on TCP, cues and clock sync use UDP,
+// settings persist in a host directory and Serial is the console. Time is
+// virtual by default, which soaks hours of show in minutes.
+//
+// Usage: virtual_board [options]
+//   --seconds N / --hours N  Length of the run in board time (default 60 s)
+//   --tick-ms N              Board time per loop() pass (default 1)
+//   --realtime               Follow the wall clock (for HTTP/UDP clients)
+//   --fs DIR                 Flash directory (default .pio/vboard/littlefs)
+//   --no-uploadfs            Do not copy data/ into the flash directory
+//   --port-offset N          Added to every port (default 8000: HTTP on 8080)
+//   --chip-id HEX            Chip id for clock sync (default C0FFEE)
+//   --serial-pty             Console on a pseudo terminal instead of stdio
+//   --press PIN@MS[+HOLD]    Press a button at board time MS (repeatable)
+//   --report-s N             Print board status every N seconds (0 = off)
+//   --quiet                  Drop the firmware's console output
+#include "virtual_board.h"
+#include <Arduino.h>
+#include <FastLED.h>
+#include "config.h"
+#include "heap_monitor.h"
+#include "input_manager.h"
+#include <chrono>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+void setup();
+void loop();
+
+// Firmware objects whose counters go into the status report
+extern InputManager inputManager;
+extern ButtonInputSource buttonInput;
+
+namespace
+{
+  struct Press
+  {
+    int pin;
+    uint64_t atMs;
+    uint64_t holdMs;
+    bool down;
+    bool done;
+  };
+
+  struct Options
+  {
+    double seconds = 60;
+    unsigned tickMs = 1;
+    bool realTime = false;
+    std::string fsRoot = ".pio/vboard/littlefs";
+    bool uploadFs = true;
+    int portOffset = 8000;
+    uint32_t chipId = 0x00C0FFEE;
+    bool serialPty = false;
+    std::vector<Press> presses;
+    double reportS = 10;
+    bool quiet = false;
+  };
+
+  void usage(const char *program)
+  {
+    fprintf(stderr,
+            "usage: %s [--seconds N | --hours N] [--tick-ms N] [--realtime] [--fs DIR] [--no-uploadfs]\n"
+            "          [--port-offset N] [--chip-id HEX] [--serial-pty] [--press PIN@MS[+HOLD]]...\n"
+            "          [--report-s N] [--quiet]\n",
+            program);
+  }
+
+  bool parsePress(const char *text, Press &press)
+  {
+    unsigned pin;
+    unsigned long long atMs, holdMs = 100;
+    int fields = sscanf(text, "%u@%llu+%llu", &pin, &atMs, &holdMs);
+    if (fields < 2 || pin >= (unsigned)VirtualBoard::PIN_COUNT)
+      return false;
+    press = {(int)pin, atMs, holdMs, false, false};
+    return true;
+  }
+
+  bool parseOptions(int argc, char **argv, Options &options)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+      bool takesValue = arg != "--realtime" && arg != "--no-uploadfs" && arg != "--serial-pty" && arg != "--quiet";
+      if (takesValue && value == nullptr)
+        return false;
+
+      if (arg == "--seconds")
+        options.seconds = atof(value);
+      else if (arg == "--hours")
+        options.seconds = atof(value) * 3600;
+      else if (arg == "--tick-ms")
+        options.tickMs = (unsigned)atoi(value);
+      else if (arg == "--realtime")
+        options.realTime = true;
+      else if (arg == "--fs")
+        options.fsRoot = value;
+      else if (arg == "--no-uploadfs")
+        options.uploadFs = false;
+      else if (arg == "--port-offset")
+        options.portOffset = atoi(value);
+      else if (arg == "--chip-id")
+        options.chipId = (uint32_t)strtoul(value, nullptr, 16);
+      else if (arg == "--serial-pty")
+        options.serialPty = true;
+      else if (arg == "--press")
+      {
+        Press press;
+        if (!parsePress(value, press))
+          return false;
+        options.presses.push_back(press);
+      }
+      else if (arg == "--report-s")
+        options.reportS = atof(value);
+      else if (arg == "--quiet")
+        options.quiet = true;
+      else
+        return false;
+      if (takesValue)
+        i++;
+    }
+    return options.seconds > 0 && options.tickMs > 0;
+  }
+
+  /**
+   * @brief Put the console on a new pseudo terminal (for "screen" or a show PC tool)
+   */
+  bool openPty()
+  {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+      return false;
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL, 0) | O_NONBLOCK);
+    VirtualBoard::setSerialFds(master, master);
+    fprintf(stderr, "virtual board: serial console on %s\n", ptsname(master));
+    return true;
+  }
+
+  void applyPresses(std::vector<Press> &presses, uint64_t nowMs)
+  {
+    for (Press &press : presses)
+    {
+      if (!press.done && !press.down && nowMs >= press.atMs)
+      {
+        VirtualBoard::setInput(press.pin, LOW); // Buttons are active low
+        VirtualBoard::restartFrameGaps();
+        press.down = true;
+      }
+      if (press.down && nowMs >= press.atMs + press.holdMs)
+      {
+        VirtualBoard::setInput(press.pin, HIGH);
+        press.down = false;
+        press.done = true;
+      }
+    }
+  }
+
+  void report(FILE *out, unsigned long loops, double wallS)
+  {
+    const VirtualBoard::Strip *strip = VirtualBoard::getStrip(PortalConfig::Hardware::LED_PIN);
+    double boardS = VirtualBoard::nowUs() / 1e6;
+    unsigned long dropped = inputManager.getDroppedCount() + buttonInput.getDroppedCount() +
+                            buttonInput.getDroppedEdgeCount();
+    fprintf(out,
+            "[vboard] t=%.1fs loops=%lu shows=%lu longest-frame-gap=%.2fms free-heap=%u heap-grown=%u dropped=%lu "
+            "rejected=%lu wall=%.1fs (x%.1f)\n",
+            boardS, loops, strip ? strip->shows : 0, strip ? strip->longestGapUs / 1000.0 : 0.0, ESP.getFreeHeap(),
+            HeapMonitor::getStats().heapGrowthHigh, dropped, inputManager.getRejectedCount(), wallS,
+            wallS > 0 ? boardS / wallS : 0.0);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  int copied = VirtualBoard::prepareFs(options.fsRoot.c_str(), options.uploadFs ? "data" : nullptr);
+  if (copied < 0)
+  {
+    fprintf(stderr, "virtual board: cannot create %s\n", options.fsRoot.c_str());
+    return 1;
+  }
+  if (options.uploadFs)
+    fprintf(stderr, "virtual board: %d files from data/ in %s\n", copied, options.fsRoot.c_str());
+
+  VirtualBoard::setFsRoot(options.fsRoot.c_str());
+  VirtualBoard::setPortOffset(options.portOffset);
+  VirtualBoard::setChipId(options.chipId);
+  VirtualBoard::setRealTime(options.realTime);
+  if (options.serialPty)
+  {
+    if (!openPty())
+    {
+      fprintf(stderr, "virtual board: cannot open a pseudo terminal\n");
+      return 1;
+    }
+  }
+  else
+  {
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL, 0) | O_NONBLOCK);
+    VirtualBoard::setSerialFds(STDIN_FILENO, options.quiet ? -1 : STDOUT_FILENO);
+  }
+  ESP.getFreeHeap(); // Heap baseline: the host process before boot
+
+  auto wallStart = std::chrono::steady_clock::now();
+  auto wallSeconds = [&]()
+  { return std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count(); };
+
+  setup();
+
+  uint64_t endUs = (uint64_t)(options.seconds * 1e6);
+  uint64_t reportUs = (uint64_t)(options.reportS * 1e6);
+  uint64_t nextReportUs = reportUs;
+  unsigned long loops = 0;
+  while (VirtualBoard::nowUs() < endUs)
+  {
+    applyPresses(options.presses, VirtualBoard::nowUs() / 1000);
+    loop();
+    loops++;
+    VirtualBoard::advanceUs((uint64_t)options.tickMs * 1000);
+    if (reportUs > 0 && VirtualBoard::nowUs() >= nextReportUs)
+    {
+      report(stderr, loops, wallSeconds());
+      nextReportUs += reportUs;
+    }
+  }
+
+  if (reportUs == 0 || endUs % reportUs != 0)
+    report(stderr, loops, wallSeconds());
+  return 0;
+}
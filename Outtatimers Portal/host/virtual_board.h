@@ -0,0 +1,136 @@
+// Control side of the virtual board: the clock, pins and LED strips the
+// Arduino shims in host/include/ run against. The firmware never includes
+// this file; the runner (virtual_board.cpp) and the shims do.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct CRGB;
+
+namespace VirtualBoard
+{
+  // Clock
+
+  /**
+   * @brief Follow the wall clock instead of advancing only on demand
+   *
+   * In virtual time (the default) the clock moves only through advanceUs(),
+   * delay() and LED shows, so hours of show run in minutes. In real time it
+   * follows the host's monotonic clock, which HTTP load tests need.
+   */
+  void setRealTime(bool realTime);
+  bool isRealTime();
+
+  /**
+   * @brief Microseconds since boot
+   */
+  uint64_t nowUs();
+
+  /**
+   * @brief Let time pass: advances the virtual clock, or sleeps in real time
+   */
+  void advanceUs(uint64_t us);
+
+  // GPIO (pins 0-16 of the ESP8266)
+
+  constexpr int PIN_COUNT = 17;
+
+  /**
+   * @brief Drive an input pin from outside, firing its pin change interrupt
+   * @param pin GPIO number
+   * @param level 0 (low) or 1 (high)
+   */
+  void setInput(int pin, int level);
+
+  /**
+   * @brief Current pin level (inputs as driven, outputs as written)
+   */
+  int getLevel(int pin);
+
+  /**
+   * @brief Levels of GPIO0-15 as one word, like the GPI register
+   */
+  uint32_t readInputs();
+
+  // LED strips
+
+  /**
+   * @brief What an LED controller last put on the wire
+   */
+  struct Strip
+  {
+    int pin;
+    int length;
+    const CRGB *data;       ///< Firmware buffer
+    uint8_t brightness;     ///< Brightness of the last show
+    unsigned long shows;    ///< Number of show() calls
+    uint64_t lastShowUs;    ///< Clock at the end of the last show
+    uint64_t longestGapUs;  ///< Longest time between two shows (frame jitter)
+  };
+
+  /**
+   * @brief Strip registered by FastLED.addLeds() on a data pin
+   * @return nullptr if no strip uses the pin
+   */
+  const Strip *getStrip(int pin);
+
+  /**
+   * @brief Called by the controller shim for every show()
+   */
+  void recordShow(int pin, uint8_t brightness);
+
+  /**
+   * @brief Restart frame gap measurement on every strip
+   *
+   * The next show() records no gap, so the idle time before a button press
+   * starts the show is not counted as a stalled frame.
+   */
+  void restartFrameGaps();
+
+  /**
+   * @brief Register a strip (called by the FastLED shim)
+   */
+  void addStrip(int pin, const CRGB *data, int length);
+
+  // Network
+
+  /**
+   * @brief Offset added to the TCP/UDP ports the firmware listens on
+   *
+   * Lets the board bind unprivileged ports (HTTP 80 becomes 8080 with an
+   * offset of 8000) and several boards share a host.
+   */
+  void setPortOffset(int offset);
+  int getPortOffset();
+
+  // Serial console
+
+  /**
+   * @brief File descriptors Serial reads from and writes to (-1 for none)
+   */
+  void setSerialFds(int inFd, int outFd);
+  int getSerialInFd();
+  int getSerialOutFd();
+
+  // Flash file system
+
+  /**
+   * @brief Host directory that stands in for the LittleFS partition
+   */
+  void setFsRoot(const char *directory);
+  const char *getFsRoot();
+
+  /**
+   * @brief Create the flash directory and fill it like "make uploadfs"
+   * @param directory Host directory, created with its parents if missing
+   * @param dataDir Directory whose files are copied in (nullptr to skip)
+   * @return Number of files copied, or -1 if the directory cannot be created
+   */
+  int prepareFs(const char *directory, const char *dataDir);
+
+  // Chip
+
+  void setChipId(uint32_t id);
+  uint32_t getChipId();
+}
@@ -67,6 +67,376 @@ else
     ((FAILED++))
 fi
 
+# Test 4: Frame Preview Test
+echo -e "\n${YELLOW}Running test_frame_preview...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_frame_preview.cpp" \
+    -o /tmp/test_frame_preview 2>/dev/null && /tmp/test_frame_preview; then
+    echo -e "${GREEN}✅ test_frame_preview PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_frame_preview FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 5: DMX Input Source Test (E1.31 / Art-Net over loopback UDP)
+echo -e "\n${YELLOW}Running test_dmx_input_source...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_dmx_input_source.cpp" \
+    -o /tmp/test_dmx_input_source 2>/dev/null && /tmp/test_dmx_input_source; then
+    echo -e "${GREEN}✅ test_dmx_input_source PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_dmx_input_source FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 6: UDP Cue Trigger Test (includes loopback latency harness)
+echo -e "\n${YELLOW}Running test_udp_command_source...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_udp_command_source.cpp" \
+    -pthread \
+    -o /tmp/test_udp_command_source 2>/dev/null && /tmp/test_udp_command_source; then
+    echo -e "${GREEN}✅ test_udp_command_source PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_udp_command_source FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 7: Cue Timeline Test
+echo -e "\n${YELLOW}Running test_cue_timeline...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_cue_timeline.cpp" \
+    src/config_manager.cpp \
+    -o /tmp/test_cue_timeline 2>/dev/null && /tmp/test_cue_timeline; then
+    echo -e "${GREEN}✅ test_cue_timeline PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_cue_timeline FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 8: Clock Sync Test (master + two followers as separate processes)
+echo -e "\n${YELLOW}Running test_clock_sync...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_clock_sync.cpp" \
+    -o /tmp/test_clock_sync 2>/dev/null && /tmp/test_clock_sync; then
+    echo -e "${GREEN}✅ test_clock_sync PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_clock_sync FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 9: Config Store Test
+echo -e "\n${YELLOW}Running test_config_store...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_config_store.cpp" \
+    src/config_manager.cpp \
+    -o /tmp/test_config_store 2>/dev/null && /tmp/test_config_store; then
+    echo -e "${GREEN}✅ test_config_store PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_config_store FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 10: Preset Store Test
+echo -e "\n${YELLOW}Running test_preset_store...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_preset_store.cpp" \
+    src/config_manager.cpp \
+    -o /tmp/test_preset_store 2>/dev/null && /tmp/test_preset_store; then
+    echo -e "${GREEN}✅ test_preset_store PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_preset_store FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 11: Config Snapshot Test
+echo -e "\n${YELLOW}Running test_config_snapshot...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_config_snapshot.cpp" \
+    src/config_manager.cpp \
+    -o /tmp/test_config_snapshot 2>/dev/null && /tmp/test_config_snapshot; then
+    echo -e "${GREEN}✅ test_config_snapshot PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_config_snapshot FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 12: Portal Effect Test
+echo -e "\n${YELLOW}Running test_portal_effect...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_portal_effect.cpp" \
+    src/effects.cpp \
+    src/config_manager.cpp \
+    -o /tmp/test_portal_effect 2>/dev/null && /tmp/test_portal_effect; then
+    echo -e "${GREEN}✅ test_portal_effect PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_portal_effect FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 13: Heap Monitor Test
+echo -e "\n${YELLOW}Running test_heap_monitor...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_heap_monitor.cpp" \
+    src/heap_monitor.cpp \
+    src/effects.cpp \
+    src/config_manager.cpp \
+    -o /tmp/test_heap_monitor 2>/dev/null && /tmp/test_heap_monitor; then
+    echo -e "${GREEN}✅ test_heap_monitor PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_heap_monitor FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 14: Button Capture Test
+echo -e "\n${YELLOW}Running test_button_capture...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_button_capture.cpp" \
+    -o /tmp/test_button_capture 2>/dev/null && /tmp/test_button_capture; then
+    echo -e "${GREEN}✅ test_button_capture PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_button_capture FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 15: Button Gesture Test
+echo -e "\n${YELLOW}Running test_button_gesture...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_button_gesture.cpp" \
+    -o /tmp/test_button_gesture 2>/dev/null && /tmp/test_button_gesture; then
+    echo -e "${GREEN}✅ test_button_gesture PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_button_gesture FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 16: Bank Input Test
+echo -e "\n${YELLOW}Running test_bank_input...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_bank_input.cpp" \
+    -o /tmp/test_bank_input 2>/dev/null && /tmp/test_bank_input; then
+    echo -e "${GREEN}✅ test_bank_input PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_bank_input FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 17: Input Manager Test
+echo -e "\n${YELLOW}Running test_input_manager...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_input_manager.cpp" \
+    -o /tmp/test_input_manager 2>/dev/null && /tmp/test_input_manager; then
+    echo -e "${GREEN}✅ test_input_manager PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_input_manager FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 18: Latency Tracer Test
+echo -e "\n${YELLOW}Running test_latency_tracer...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_latency_tracer.cpp" \
+    -o /tmp/test_latency_tracer 2>/dev/null && /tmp/test_latency_tracer; then
+    echo -e "${GREEN}✅ test_latency_tracer PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_latency_tracer FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 19: Serial Command Source Test (pseudo-terminal)
+echo -e "\n${YELLOW}Running test_serial_command_source...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_serial_command_source.cpp" \
+    -o /tmp/test_serial_command_source 2>/dev/null && /tmp/test_serial_command_source; then
+    echo -e "${GREEN}✅ test_serial_command_source PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_serial_command_source FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 20: Simulator smoke test (renders a short show)
+echo -e "\n${YELLOW}Running portal_sim...${NC}"
+if g++ -std=c++17 -O2 \
+    -DUNIT_TEST \
+    -I src \
+    "sim/portal_sim.cpp" \
+    src/effects.cpp \
+    src/config_manager.cpp \
+    -o /tmp/portal_sim 2>/dev/null && /tmp/portal_sim --cue data/show.cue --seconds 25 --fps 10 \
+    --strip /tmp/portal_sim_strip.ppm && [ "$(head -c 15 /tmp/portal_sim_strip.ppm | tr '\n' ' ')" = "P6 800 251 255 " ]; then
+    echo -e "${GREEN}✅ portal_sim PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ portal_sim FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 21: Golden frames (bit-exact effect output)
+echo -e "\n${YELLOW}Running test_golden_frames...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_golden_frames.cpp" \
+    src/effects.cpp \
+    src/config_manager.cpp \
+    -o /tmp/test_golden_frames 2>/dev/null && /tmp/test_golden_frames; then
+    echo -e "${GREEN}✅ test_golden_frames PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_golden_frames FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 22: Gradient generation property/fuzz test
+echo -e "\n${YELLOW}Running test_gradient_fuzz...${NC}"
+if g++ -std=c++17 -O1 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_gradient_fuzz.cpp" \
+    src/effects.cpp \
+    src/config_manager.cpp \
+    -o /tmp/test_gradient_fuzz 2>/dev/null && /tmp/test_gradient_fuzz; then
+    echo -e "${GREEN}✅ test_gradient_fuzz PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_gradient_fuzz FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 23: Virtual board soak (full firmware on the host, 10 minutes of board time)
+# The final report must show no heap lost since setup, no frame gap above two
+# frame times while the show runs and no dropped or rejected input events.
+SOAK_MAX_FRAME_GAP_MS=50
+echo -e "\n${YELLOW}Running virtual_board soak...${NC}"
+rm -rf /tmp/vboard_fs
+if make -s vboard >/dev/null 2>&1 && \
+    .pio/vboard/virtual_board --seconds 600 --fs /tmp/vboard_fs --port-offset 18000 --report-s 0 \
+        --press 14@5000 --press 12@60000 --press 13@300000 >/tmp/vboard_soak.log 2>&1 && \
+    grep -q "Animation STARTED" /tmp/vboard_soak.log && \
+    awk -v max_gap="$SOAK_MAX_FRAME_GAP_MS" '
+        /^Free heap after setup: / { start_heap = $5 + 0 }
+        /^\[vboard\] t=/ { report = $0 }
+        END {
+            n = split(report, fields, /[ =]/)
+            for (i = 1; i < n; i++) value[fields[i]] = fields[i + 1] + 0
+            printf "free heap %d (setup %d), longest frame gap %.2f ms (max %d), dropped %d, rejected %d\n",
+                   value["free-heap"], start_heap, value["longest-frame-gap"], max_gap,
+                   value["dropped"], value["rejected"]
+            exit !(report != "" && start_heap > 0 && value["free-heap"] >= start_heap &&
+                   value["heap-grown"] == 0 && value["longest-frame-gap"] > 0 &&
+                   value["longest-frame-gap"] < max_gap && value["dropped"] == 0 && value["rejected"] == 0)
+        }' /tmp/vboard_soak.log; then
+    echo -e "${GREEN}✅ virtual_board soak PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ virtual_board soak FAILED${NC}"
+    tail -20 /tmp/vboard_soak.log 2>/dev/null
+    ((FAILED++))
+fi
+
+# Test 24: Kernel benchmark harness (timings are not checked, only that every kernel runs and reports)
+echo -e "\n${YELLOW}Running kernel_bench...${NC}"
+if g++ -std=c++17 -O2 \
+    -DUNIT_TEST \
+    -I src \
+    bench/kernel_bench.cpp \
+    src/effects.cpp \
+    src/config_manager.cpp \
+    -o /tmp/kernel_bench 2>/dev/null && \
+    /tmp/kernel_bench --quick --no-compare --json /tmp/kernel_bench.json >/dev/null && \
+    (for kernel in interpolate_color rotate_copy led_position generate_gradient portal_frame virtual_gradient_frame; do
+        grep -q "\"name\": \"$kernel\", \"leds\": 32," /tmp/kernel_bench.json || exit 1
+    done); then
+    echo -e "${GREEN}✅ kernel_bench PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ kernel_bench FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 25: HTTP load benchmark smoke run (every request answered, frames keep coming)
+echo -e "\n${YELLOW}Running http_bench...${NC}"
+rm -rf /tmp/http_bench_fs
+if g++ -std=c++17 -O2 -pthread \
+    -I host/include \
+    -I host \
+    -I src \
+    src/main.cpp src/effects.cpp src/config_manager.cpp src/status_led.cpp src/heap_monitor.cpp src/portal_effect.cpp \
+    host/arduino_shim.cpp \
+    bench/http_bench.cpp \
+    -o /tmp/http_bench 2>/dev/null && \
+    /tmp/http_bench --concurrency 0,4 --phase-s 1 --port-offset 18100 --fs /tmp/http_bench_fs \
+        --json /tmp/http_bench.json >/dev/null && \
+    [ "$(grep -c '"errors": 0,' /tmp/http_bench.json)" -eq 2 ]; then
+    echo -e "${GREEN}✅ http_bench PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ http_bench FAILED${NC}"
+    ((FAILED++))
+fi
+
+# Test 26: Portal Commands Test
+echo -e "\n${YELLOW}Running test_portal_commands...${NC}"
+if g++ -std=c++17 \
+    -DUNIT_TEST \
+    -I src \
+    "test/test_portal_commands.cpp" \
+    src/config_manager.cpp \
+    -o /tmp/test_portal_commands 2>/dev/null && /tmp/test_portal_commands; then
+    echo -e "${GREEN}✅ test_portal_commands PASSED${NC}"
+    ((PASSED++))
+else
+    echo -e "${RED}❌ test_portal_commands FAILED${NC}"
+    ((FAILED++))
+fi
+
 # Summary
 echo -e "\n======================================"
 echo -e "🧪 Test Summary:"
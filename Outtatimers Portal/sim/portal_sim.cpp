@@ -0,0 +1,253 @@
+// Headless portal simulator: runs the effect and a cue list on a simulated
+// clock and writes what the ring shows as PPM images.
+//
+//   make sim
+//   .pio/sim/portal_sim --cue data/show.cue --seconds 30 --fps 25 --frames /tmp/frames
+//   ffmpeg -framerate 25 -i /tmp/frames/frame_%05d.ppm portal.mp4
+//
+// The loop runs as fast as the host can compute frames, so a long show takes
+// seconds. No Arduino runtime is needed; the clock is advanced by the
+// simulator and millis() returns it.
+#include "../src/config_manager.h"
+#include "../src/cue_timeline.h"
+#include "../src/input_manager.h"
+#include "../src/led_arena.h"
+#include "../src/portal_commands.h"
+#include "../src/portal_effect.h"
+#include "ring_image.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static unsigned long simulatedMs = 0;
+
+extern "C" unsigned long millis() { return simulatedMs; }
+extern "C" int digitalRead(int pin) { return HIGH; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+/**
+ * @brief Driver that keeps what the last show() put on the strip
+ *
+ * Like FastLED's showLeds(), show() applies the driver brightness to the
+ * pushed frame, so the captured colors are the ones a camera would see.
+ */
+class SimLEDDriver : public ILEDDriver
+{
+public:
+  static constexpr int MAX_LEDS = PortalConfig::Hardware::MAX_NUM_LEDS;
+
+  explicit SimLEDDriver(int length) : length_(length), brightness_(255), shows_(0) {}
+
+  void begin() override {}
+  void setBrightness(uint8_t b) override { brightness_ = b; }
+  void setPixel(int idx, const CRGB &color) override
+  {
+    if (idx >= 0 && idx < length_)
+      buffer_[idx] = color;
+  }
+  void fillSolid(const CRGB &color) override
+  {
+    for (int i = 0; i < length_; i++)
+      buffer_[i] = color;
+  }
+  void clear() override { fillSolid(CRGB(0, 0, 0)); }
+  void show() override
+  {
+    for (int i = 0; i < length_; i++)
+    {
+      shown_[i] = buffer_[i];
+      shown_[i].nscale8(brightness_);
+    }
+    shows_++;
+  }
+  CRGB *getBuffer() override { return buffer_; }
+  int getLength() const override { return length_; }
+
+  const CRGB *getShown() const { return shown_; }
+  unsigned long getShowCount() const { return shows_; }
+
+private:
+  int length_;
+  uint8_t brightness_;
+  unsigned long shows_;
+  CRGB buffer_[MAX_LEDS];
+  CRGB shown_[MAX_LEDS];
+};
+
+typedef PortalEffectTemplate<PortalConfig::Hardware::MAX_NUM_LEDS, PortalConfig::Effects::GRADIENT_STEP_DEFAULT,
+                             PortalConfig::Effects::GRADIENT_MOVE_DEFAULT>
+    SimPortal;
+
+static SimPortal *portal = nullptr;
+
+/**
+ * @brief Runs the firmware's command handlers on the simulated ring, silently
+ */
+struct SimShow
+{
+  static void start() { portal->start(); }
+  static void stop() { portal->stop(); }
+  static void triggerMalfunction() { portal->triggerMalfunction(); }
+  static void triggerFadeOut() { portal->triggerFadeOut(); }
+  static void log(const char *) {}
+};
+
+struct Options
+{
+  int leds = PortalConfig::Hardware::NUM_LEDS;
+  double seconds = 30;
+  int fps = 25;
+  unsigned seed = 1;
+  int size = 256;
+  const char *cue = nullptr;
+  const char *frames = nullptr;
+  const char *strip = nullptr;
+};
+
+static void usage()
+{
+  fprintf(stderr,
+          "Usage: portal_sim [options]\n"
+          "  --leds N       LED count (default %d, max %d)\n"
+          "  --seconds S    Simulated duration (default 30)\n"
+          "  --fps F        Captured frames per simulated second (default 25)\n"
+          "  --seed N       Random seed (default 1)\n"
+          "  --cue FILE     Cue list to play (default: toggle at 0 ms)\n"
+          "  --frames DIR   Write DIR/frame_NNNNN.ppm images of the ring\n"
+          "  --size PX      Ring image size in pixels (default 256)\n"
+          "  --strip FILE   Write one PPM with a row of LEDs per frame\n",
+          PortalConfig::Hardware::NUM_LEDS, PortalConfig::Hardware::MAX_NUM_LEDS);
+}
+
+static bool parseOptions(int argc, char **argv, Options &options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value)
+      return false;
+    if (strcmp(arg, "--leds") == 0)
+      options.leds = atoi(value);
+    else if (strcmp(arg, "--seconds") == 0)
+      options.seconds = atof(value);
+    else if (strcmp(arg, "--fps") == 0)
+      options.fps = atoi(value);
+    else if (strcmp(arg, "--seed") == 0)
+      options.seed = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--size") == 0)
+      options.size = atoi(value);
+    else if (strcmp(arg, "--cue") == 0)
+      options.cue = value;
+    else if (strcmp(arg, "--frames") == 0)
+      options.frames = value;
+    else if (strcmp(arg, "--strip") == 0)
+      options.strip = value;
+    else
+      return false;
+    i++;
+  }
+  return options.leds > PortalConfig::Effects::MAX_DRIVER_DISTANCE &&
+         options.leds <= PortalConfig::Hardware::MAX_NUM_LEDS && options.seconds > 0 && options.fps > 0 &&
+         options.size >= 16;
+}
+
+static bool readFile(const char *path, std::string &text)
+{
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+  char chunk[1024];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    text.append(chunk, n);
+  fclose(file);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    usage();
+    return 2;
+  }
+
+  randomSeed(options.seed);
+  ConfigManager::begin();
+
+  static SimLEDDriver driver(options.leds);
+  LedArena arena;
+  if (!arena.begin(SimPortal::arenaBytes(options.leds)))
+    return 1;
+  SimPortal effect(&driver, &arena);
+  portal = &effect;
+  if (!effect.begin())
+  {
+    fprintf(stderr, "Effect buffers unavailable for %d LEDs\n", options.leds);
+    return 1;
+  }
+
+  CueTimeline timeline;
+  std::string cues = "0 toggle\n";
+  if (options.cue && !readFile(options.cue, cues.assign("")))
+  {
+    fprintf(stderr, "Cannot read cue list %s\n", options.cue);
+    return 1;
+  }
+  int cueCount = timeline.loadFromString(cues.c_str());
+  InputManager inputs;
+  inputs.setCommandTable(PortalCommands<SimShow>::table);
+  inputs.addInputSource(&timeline);
+  timeline.start(0);
+
+  unsigned long durationMs = (unsigned long)(options.seconds * 1000.0);
+  unsigned long frameCount = (unsigned long)((uint64_t)durationMs * options.fps / 1000) + 1;
+  RingImage ring(options.leds, options.size);
+  std::vector<uint8_t> image((size_t)options.size * options.size * 3);
+  StripImageWriter strip;
+  if (options.strip && !strip.open(options.strip, options.leds, (int)frameCount))
+  {
+    fprintf(stderr, "Cannot write %s\n", options.strip);
+    return 1;
+  }
+
+  auto wallStart = std::chrono::steady_clock::now();
+  unsigned long frame = 0;
+  for (unsigned long t = 0; t <= durationMs; t += PortalConfig::Timing::UPDATE_INTERVAL_MS)
+  {
+    simulatedMs = t;
+    inputs.update(t);
+    effect.update(t);
+
+    // Frame k is the ring as shown at k / fps seconds
+    while (frame < frameCount && (uint64_t)frame * 1000 <= (uint64_t)t * options.fps)
+    {
+      if (options.frames)
+      {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/frame_%05lu.ppm", options.frames, frame);
+        ring.render(driver.getShown(), image.data());
+        if (!writePpm(path, image.data(), options.size, options.size))
+        {
+          fprintf(stderr, "Cannot write %s\n", path);
+          return 1;
+        }
+      }
+      strip.append(driver.getShown());
+      frame++;
+    }
+  }
+  strip.close();
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  printf("Simulated %.1f s of %d LEDs (%d cues, %lu shows), %lu frames in %.2f s wall time (%.0fx real time)\n",
+         durationMs / 1000.0, options.leds, cueCount, driver.getShowCount(), frame, wallSeconds,
+         wallSeconds > 0 ? durationMs / 1000.0 / wallSeconds : 0.0);
+  return 0;
+}
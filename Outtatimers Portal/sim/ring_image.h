@@ -0,0 +1,154 @@
+// Ring rasterizer and PPM output for the host simulator
+#pragma once
+
+#include "../src/config.h"
+#include "../src/effects.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+/**
+ * @brief Draws a ring frame as a square image, LEDs in their circular layout
+ *
+ * Every pixel is mapped to the LED it shows (or to the background) once, via
+ * getLEDPosition(), so rendering a frame is one lookup per pixel.
+ */
+class RingImage
+{
+public:
+  /**
+   * @brief Construct a new RingImage
+   * @param numLeds LED count of the ring
+   * @param size Image width and height in pixels
+   */
+  RingImage(int numLeds, int size) : size_(size), map_((size_t)size * size, -1)
+  {
+    float radius = size * 0.45f;
+    float center = size * 0.5f;
+    // Dots about as wide as the LED spacing, but at least 3x3 pixels
+    float dot = 2.0f * PortalConfig::Math::PI_F * radius / numLeds * 0.45f;
+    if (dot < 1.0f)
+      dot = 1.0f;
+    for (int i = 0; i < numLeds; i++)
+    {
+      float x, y;
+      if (!getLEDPosition(i, numLeds, radius, x, y))
+        continue;
+      int cx = (int)(center + x);
+      int cy = (int)(center - y); // Image rows grow downwards
+      int r = (int)(dot + 0.5f);
+      for (int py = cy - r; py <= cy + r; py++)
+      {
+        for (int px = cx - r; px <= cx + r; px++)
+        {
+          if (px < 0 || py < 0 || px >= size || py >= size)
+            continue;
+          if ((px - cx) * (px - cx) + (py - cy) * (py - cy) <= r * r)
+            map_[(size_t)py * size + px] = i;
+        }
+      }
+    }
+  }
+
+  int getSize() const { return size_; }
+
+  /**
+   * @brief Render a frame
+   * @param leds LED colors, as shown on the strip
+   * @param rgb Output, size * size * 3 bytes
+   */
+  void render(const CRGB *leds, uint8_t *rgb) const
+  {
+    for (size_t p = 0; p < map_.size(); p++)
+    {
+      int led = map_[p];
+      CRGB c = led >= 0 ? leds[led] : CRGB(0, 0, 0);
+      rgb[3 * p] = c.r;
+      rgb[3 * p + 1] = c.g;
+      rgb[3 * p + 2] = c.b;
+    }
+  }
+
+private:
+  int size_;
+  std::vector<int> map_; ///< LED index per pixel, -1 for background
+};
+
+/**
+ * @brief Write a binary PPM (P6) image
+ * @return true if the file was written completely
+ */
+inline bool writePpm(const char *path, const uint8_t *rgb, int width, int height)
+{
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+  fprintf(file, "P6\n%d %d\n255\n", width, height);
+  size_t bytes = (size_t)width * height * 3;
+  bool ok = fwrite(rgb, 1, bytes, file) == bytes;
+  return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief One long PPM image with a row per frame: LED index across, time down
+ *
+ * The row count is fixed when the file is opened; rows not appended by
+ * close() are written black so the image stays valid.
+ */
+class StripImageWriter
+{
+public:
+  StripImageWriter() : file_(nullptr), width_(0), rows_(0), written_(0) {}
+  ~StripImageWriter() { close(); }
+
+  bool open(const char *path, int width, int rows)
+  {
+    file_ = fopen(path, "wb");
+    if (!file_)
+      return false;
+    width_ = width;
+    rows_ = rows;
+    written_ = 0;
+    row_.assign((size_t)width * 3, 0);
+    fprintf(file_, "P6\n%d %d\n255\n", width, rows);
+    return true;
+  }
+
+  /**
+   * @brief Append a frame as the next row (ignored once all rows are written)
+   */
+  void append(const CRGB *leds)
+  {
+    if (!file_ || written_ >= rows_)
+      return;
+    for (int i = 0; i < width_; i++)
+    {
+      row_[3 * i] = leds[i].r;
+      row_[3 * i + 1] = leds[i].g;
+      row_[3 * i + 2] = leds[i].b;
+    }
+    fwrite(row_.data(), 1, row_.size(), file_);
+    written_++;
+  }
+
+  void close()
+  {
+    if (!file_)
+      return;
+    row_.assign(row_.size(), 0);
+    while (written_ < rows_)
+    {
+      fwrite(row_.data(), 1, row_.size(), file_);
+      written_++;
+    }
+    fclose(file_);
+    file_ = nullptr;
+  }
+
+private:
+  FILE *file_;
+  int width_;
+  int rows_;
+  int written_;
+  std::vector<uint8_t> row_;
+};
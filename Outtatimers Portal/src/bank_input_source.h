@@ -0,0 +1,133 @@
+#pragma once
+
+#include "debounce.h"
+#include "input_bank.h"
+#include "input_manager.h"
+
+/**
+ * @brief Input source for many buttons read as one bank
+ *
+ * Samples an IInputBank at a fixed interval and debounces every input of
+ * the bank together with a VerticalDebounce, so 32 inputs cost one read and
+ * a few bitwise operations per sample. Debounced changes of mapped inputs
+ * are queued as Pressed/Released events.
+ *
+ * @example
+ * ```cpp
+ * static const int ids[] = {1, 2, 3}; // inputs 0-2 are the three buttons
+ * BankInputSource expander(&bank, ids, 3, 0xFFFFFFFF, 10, "Expander");
+ * inputManager.addInputSource(&expander);
+ * ```
+ */
+class BankInputSource : public IInputSource
+{
+public:
+  static constexpr int MAX_INPUTS = 32;
+
+  /**
+   * @brief Construct a new BankInputSource
+   * @param bank Bank to read (must remain valid)
+   * @param inputIds Input ID per bank bit, 0 for unused bits (must remain valid)
+   * @param inputCount Number of entries in inputIds
+   * @param activeLowMask Bits that read low when pressed
+   * @param sampleMs Sampling interval; the debounce time is VerticalDebounce::SAMPLES times this
+   * @param name Source name for debugging
+   */
+  BankInputSource(IInputBank *bank, const int *inputIds, int inputCount, uint32_t activeLowMask,
+                  unsigned long sampleMs, const char *name)
+      : bank_(bank), inputIds_(inputIds), activeLowMask_(activeLowMask), sampleMs_(sampleMs), name_(name),
+        mappedMask_(0), lastSample_(0), sampled_(false), droppedCount_(0), eventQueueHead_(0), eventQueueTail_(0)
+  {
+    if (inputCount > MAX_INPUTS)
+      inputCount = MAX_INPUTS;
+    for (int i = 0; i < inputCount; i++)
+    {
+      if (inputIds_[i] != 0)
+        mappedMask_ |= 1u << i;
+    }
+  }
+
+  bool update(unsigned long currentTime) override
+  {
+    if (sampled_ && currentTime - lastSample_ < sampleMs_)
+      return false;
+    sampled_ = true;
+    lastSample_ = currentTime;
+
+    // Pressed inputs read as 1 from here on
+    uint32_t changed = debounce_.sample(bank_->read() ^ activeLowMask_) & mappedMask_;
+    uint32_t pressed = debounce_.getState();
+    while (changed)
+    {
+      int bit = __builtin_ctz(changed);
+      changed &= changed - 1;
+      queueEvent({.inputId = inputIds_[bit],
+                  .type = (pressed >> bit) & 1 ? EventType::Pressed : EventType::Released,
+                  .timestamp = currentTime,
+                  .sourceName = name_});
+    }
+    return hasEvents();
+  }
+
+  bool hasEvents() const override
+  {
+    return eventQueueHead_ != eventQueueTail_;
+  }
+
+  InputEvent getNextEvent() override
+  {
+    if (!hasEvents())
+    {
+      return {0, EventType::Released, 0, "none"};
+    }
+
+    InputEvent event = eventQueue_[eventQueueHead_];
+    eventQueueHead_ = (eventQueueHead_ + 1) % MAX_EVENTS;
+    return event;
+  }
+
+  const char *getSourceName() const override
+  {
+    return name_;
+  }
+
+  /**
+   * @brief Debounced pressed state of all bank inputs (bit set = pressed)
+   */
+  uint32_t getPressedMask() const { return debounce_.getState(); }
+
+  /**
+   * @brief Events lost because the queue was full
+   */
+  unsigned long getDroppedCount() const { return droppedCount_; }
+
+private:
+  static constexpr int MAX_EVENTS = 16;
+
+  IInputBank *bank_;
+  const int *inputIds_;
+  uint32_t activeLowMask_;
+  unsigned long sampleMs_;
+  const char *name_;
+  uint32_t mappedMask_;
+  unsigned long lastSample_;
+  bool sampled_;
+  VerticalDebounce debounce_;
+  unsigned long droppedCount_;
+
+  InputEvent eventQueue_[MAX_EVENTS];
+  int eventQueueHead_;
+  int eventQueueTail_;
+
+  void queueEvent(const InputEvent &event)
+  {
+    int nextTail = (eventQueueTail_ + 1) % MAX_EVENTS;
+    if (nextTail == eventQueueHead_)
+    {
+      droppedCount_++;
+      return;
+    }
+    eventQueue_[eventQueueTail_] = event;
+    eventQueueTail_ = nextTail;
+  }
+};
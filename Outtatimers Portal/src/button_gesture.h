@@ -0,0 +1,177 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Gesture state machine for one button
+ *
+ * Turns debounced press/release changes into tap, double-tap, long-press
+ * and hold-repeat gestures, so three buttons can carry more than three
+ * commands. Each call is O(1) and the state is a few words per button.
+ *
+ * - Tap: released before the long-press time. With double-tap enabled it is
+ *   reported once the double-tap window has passed without a second press.
+ * - DoubleTap: second press within the double-tap window after a tap
+ * - LongPress: held for the long-press time (reported once, while held)
+ * - Hold: repeated every hold-repeat interval after a long press
+ *
+ * A timing of 0 disables that gesture. Gesture timestamps are when the
+ * gesture happened (press time for taps, threshold time for long press and
+ * hold), not when tick() noticed it.
+ *
+ * @example
+ * ```cpp
+ * ButtonGesture gesture(800, 300, 150);
+ * gesture.press(now);        // on debounced press
+ * gesture.release(now);      // on debounced release
+ * ButtonGesture::Type type;
+ * unsigned long when;
+ * while (gesture.tick(now, type, when)) handle(type, when);
+ * ```
+ */
+class ButtonGesture
+{
+public:
+  enum class Type : uint8_t
+  {
+    None,
+    Tap,
+    DoubleTap,
+    LongPress,
+    Hold
+  };
+
+  /**
+   * @brief Construct a new ButtonGesture
+   * @param longPressMs Hold time for a long press (0 = off)
+   * @param doubleTapMs Window for the second tap (0 = off)
+   * @param holdRepeatMs Repeat interval after a long press (0 = off)
+   */
+  explicit ButtonGesture(unsigned long longPressMs = 0, unsigned long doubleTapMs = 0, unsigned long holdRepeatMs = 0)
+      : longPressMs_(longPressMs), doubleTapMs_(doubleTapMs), holdRepeatMs_(holdRepeatMs), state_(State::Idle),
+        pending_(Type::None), pressTime_(0), releaseTime_(0), nextRepeat_(0), pendingTime_(0) {}
+
+  /**
+   * @brief Whether any gesture is enabled (otherwise only raw press/release apply)
+   */
+  bool isEnabled() const { return longPressMs_ > 0 || doubleTapMs_ > 0; }
+
+  /**
+   * @brief Debounced press
+   * @param time Press timestamp in milliseconds
+   */
+  void press(unsigned long time)
+  {
+    if (state_ == State::WaitSecond && time - releaseTime_ < doubleTapMs_)
+    {
+      state_ = State::SecondDown;
+      report(Type::DoubleTap, time);
+      return;
+    }
+    if (state_ == State::WaitSecond)
+      report(Type::Tap, pressTime_); // Window ran out before tick() saw it
+    state_ = State::Down;
+    pressTime_ = time;
+  }
+
+  /**
+   * @brief Debounced release
+   * @param time Release timestamp in milliseconds
+   */
+  void release(unsigned long time)
+  {
+    if (state_ == State::Down)
+    {
+      if (longPressMs_ > 0 && time - pressTime_ >= longPressMs_)
+        report(Type::LongPress, pressTime_ + longPressMs_); // Released before tick() saw it
+      else if (doubleTapMs_ > 0)
+      {
+        state_ = State::WaitSecond;
+        releaseTime_ = time;
+        return;
+      }
+      else
+        report(Type::Tap, pressTime_);
+    }
+    state_ = State::Idle;
+  }
+
+  /**
+   * @brief Advance timers and return the next gesture, if any
+   * @param now Current timestamp in milliseconds
+   * @param type Gesture type (output)
+   * @param time Gesture timestamp (output)
+   * @return true if a gesture was returned; call again until false
+   */
+  bool tick(unsigned long now, Type &type, unsigned long &time)
+  {
+    if (pending_ != Type::None)
+    {
+      type = pending_;
+      time = pendingTime_;
+      pending_ = Type::None;
+      return true;
+    }
+
+    switch (state_)
+    {
+    case State::Down:
+      if (longPressMs_ > 0 && (long)(now - pressTime_) >= (long)longPressMs_)
+      {
+        state_ = State::LongHeld;
+        nextRepeat_ = pressTime_ + longPressMs_ + holdRepeatMs_;
+        type = Type::LongPress;
+        time = pressTime_ + longPressMs_;
+        return true;
+      }
+      break;
+    case State::LongHeld:
+      if (holdRepeatMs_ > 0 && (long)(now - nextRepeat_) >= 0)
+      {
+        type = Type::Hold;
+        time = nextRepeat_;
+        nextRepeat_ += holdRepeatMs_;
+        return true;
+      }
+      break;
+    case State::WaitSecond:
+      if ((long)(now - releaseTime_) >= (long)doubleTapMs_)
+      {
+        state_ = State::Idle;
+        type = Type::Tap;
+        time = pressTime_;
+        return true;
+      }
+      break;
+    default:
+      break;
+    }
+    return false;
+  }
+
+private:
+  enum class State : uint8_t
+  {
+    Idle,
+    Down,       ///< Pressed, long press not reached yet
+    LongHeld,   ///< Long press reported, repeating holds
+    WaitSecond, ///< Tapped once, waiting for a second press
+    SecondDown  ///< Second press of a double tap
+  };
+
+  unsigned long longPressMs_;
+  unsigned long doubleTapMs_;
+  unsigned long holdRepeatMs_;
+  State state_;
+  Type pending_; ///< Gesture completed inside press()/release(), returned by the next tick()
+  unsigned long pressTime_;
+  unsigned long releaseTime_;
+  unsigned long nextRepeat_;
+  unsigned long pendingTime_;
+
+  void report(Type type, unsigned long time)
+  {
+    pending_ = type;
+    pendingTime_ = time;
+  }
+};
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "config.h"
+#include "udp_transport.h"
+#include <stdint.h>
+
+/**
+ * @brief PTP-lite shared show clock for running several portals in phase
+ *
+ * One portal is the master and periodically broadcasts SYNC packets with its
+ * local time. Every follower answers with a broadcast DELAY_REQ and the
+ * master replies with a DELAY_RESP carrying its receive time, giving the
+ * usual four timestamps:
+ *
+ * ```
+ * t1 master sends SYNC       t2 follower receives SYNC
+ * t3 follower sends REQ      t4 master receives REQ
+ * offset = ((t2 - t1) - (t4 - t3)) / 2   (follower minus master)
+ * delay  = ((t2 - t1) + (t4 - t3)) / 2
+ * ```
+ *
+ * Timestamps are taken when loop() polls the socket, so a packet that waited
+ * behind a long show() inflates both delay and offset error. The follower
+ * therefore keeps the last FILTER_SAMPLES measurements and uses the one with
+ * the smallest round-trip delay (NTP clock filter). Small corrections are
+ * slewed, large ones stepped, and the shared millisecond clock never runs
+ * backwards: when a correction moves the clock back (a follower that booted
+ * before the master, a master that rebooted mid-show) the show clock keeps
+ * running at CATCH_UP_RATE_PERCENT of real time until the master's clock has
+ * caught up, so effects slow down instead of freezing.
+ *
+ * All traffic is broadcast, so nobody needs to know the master's address and
+ * several processes bound to the same port on loopback can take part.
+ *
+ * @example
+ * ```cpp
+ * WiFiUdpTransport udp;
+ * ClockSync clock(&udp, ClockSync::Role::Follower, ESP.getChipId());
+ * clock.begin();
+ *
+ * void loop() {
+ *     clock.update(micros64());
+ *     portal.update(clock.nowMs(micros64()));
+ * }
+ * ```
+ */
+class ClockSync
+{
+public:
+  enum class Role : uint8_t
+  {
+    Master,
+    Follower
+  };
+
+  enum class PacketType : uint8_t
+  {
+    Sync = 1,
+    DelayRequest = 2,
+    DelayResponse = 3
+  };
+
+  static constexpr size_t PACKET_BYTES = 28;
+  static constexpr uint8_t VERSION = 1;
+  static constexpr int FILTER_SAMPLES = 8;
+
+  /**
+   * @brief Construct a new ClockSync
+   * @param transport UDP transport (must remain valid)
+   * @param role Master or follower
+   * @param nodeId Identifier unique among the portals (e.g. chip ID)
+   * @param broadcastIP Destination for all packets (network byte order)
+   */
+  ClockSync(IUdpTransport *transport, Role role, uint32_t nodeId,
+            uint32_t broadcastIP = IUdpTransport::BROADCAST_IP)
+      : transport_(transport), role_(role), nodeId_(nodeId), broadcastIP_(broadcastIP), port_(0),
+        started_(false), locked_(false), sequence_(0), lastSyncSent_(0), pendingSeq_(0),
+        awaitingResponse_(false), t1_(0), t2_(0), t3_(0), offsetMicros_(0), lastSampleTime_(0),
+        lastDelayMicros_(0), sampleCount_(0), sampleIndex_(0), filled_(0), showMicros_(0), lastLocalMicros_(0),
+        hasShowClock_(false) {}
+
+  /**
+   * @brief Start listening on the sync port
+   * @param port UDP port shared by all portals
+   * @return true if the socket was opened
+   */
+  bool begin(uint16_t port = PortalConfig::ClockSync::PORT)
+  {
+    port_ = port;
+    started_ = transport_ && transport_->begin(port);
+    return started_;
+  }
+
+  /**
+   * @brief Process sync traffic; call every loop() iteration
+   * @param localMicros Local monotonic time in microseconds
+   */
+  void update(uint64_t localMicros)
+  {
+    if (!started_)
+      return;
+
+    for (int i = 0; i < MAX_PACKETS_PER_UPDATE; i++)
+    {
+      int size = transport_->parsePacket();
+      if (size <= 0)
+        break;
+      uint8_t packet[PACKET_BYTES];
+      if (size != (int)PACKET_BYTES || transport_->read(packet, PACKET_BYTES) != (int)PACKET_BYTES ||
+          packet[0] != 'C' || packet[1] != 'S' || packet[3] != VERSION)
+        continue;
+      handlePacket(packet, localMicros);
+    }
+
+    if (role_ == Role::Master &&
+        (sequence_ == 0 || localMicros - lastSyncSent_ >= PortalConfig::ClockSync::SYNC_INTERVAL_MS * 1000ULL))
+    {
+      sequence_++;
+      lastSyncSent_ = localMicros;
+      send(PacketType::Sync, nodeId_, sequence_, localMicros, 0);
+    }
+  }
+
+  /**
+   * @brief Shared clock in microseconds
+   * @param localMicros Local monotonic time in microseconds
+   */
+  uint64_t nowMicros(uint64_t localMicros) const
+  {
+    return localMicros - (uint64_t)offsetMicros_;
+  }
+
+  /**
+   * @brief Shared, monotonic show clock in milliseconds
+   * @param localMicros Local monotonic time in microseconds
+   * @return Master time in ms (local time until the first sync)
+   */
+  unsigned long nowMs(uint64_t localMicros)
+  {
+    uint64_t shared = nowMicros(localMicros);
+    if (!hasShowClock_)
+    {
+      showMicros_ = shared;
+      hasShowClock_ = true;
+    }
+    else
+    {
+      uint64_t elapsed = localMicros - lastLocalMicros_;
+      uint64_t slowed = showMicros_ + elapsed * PortalConfig::ClockSync::CATCH_UP_RATE_PERCENT / 100;
+      // Follow the shared clock, but run slower rather than back when it is behind
+      showMicros_ = (int64_t)(shared - slowed) > 0 ? shared : slowed;
+    }
+    lastLocalMicros_ = localMicros;
+    return (unsigned long)(showMicros_ / 1000ULL);
+  }
+
+  /**
+   * @brief Check whether the follower has a recent offset measurement
+   * @param localMicros Local monotonic time in microseconds
+   * @return true for the master, or a follower synced within LOCK_TIMEOUT_MS
+   */
+  bool isLocked(uint64_t localMicros) const
+  {
+    if (role_ == Role::Master)
+      return started_;
+    return locked_ && localMicros - lastSampleTime_ < PortalConfig::ClockSync::LOCK_TIMEOUT_MS * 1000ULL;
+  }
+
+  /**
+   * @brief Change the role; call before begin()
+   * @param role Master or follower
+   */
+  void setRole(Role role)
+  {
+    role_ = role;
+  }
+
+  Role getRole() const { return role_; }
+  int64_t getOffsetMicros() const { return offsetMicros_; }
+  uint32_t getLastDelayMicros() const { return lastDelayMicros_; }
+  unsigned long getSampleCount() const { return sampleCount_; }
+
+private:
+  static constexpr int MAX_PACKETS_PER_UPDATE = 8;
+
+  struct Sample
+  {
+    int64_t offset;
+    int64_t delay;
+  };
+
+  IUdpTransport *transport_;
+  Role role_;
+  uint32_t nodeId_;
+  uint32_t broadcastIP_;
+  uint16_t port_;
+  bool started_;
+  bool locked_;
+  uint32_t sequence_;
+  uint64_t lastSyncSent_;
+  uint32_t pendingSeq_;
+  bool awaitingResponse_;
+  uint64_t t1_;
+  uint64_t t2_;
+  uint64_t t3_;
+  int64_t offsetMicros_;
+  uint64_t lastSampleTime_;
+  uint32_t lastDelayMicros_;
+  unsigned long sampleCount_;
+  int sampleIndex_;
+  int filled_;
+  Sample samples_[FILTER_SAMPLES];
+  uint64_t showMicros_; // Show clock behind nowMs()
+  uint64_t lastLocalMicros_;
+  bool hasShowClock_;
+
+  static void write32(uint8_t *p, uint32_t v)
+  {
+    for (int i = 0; i < 4; i++)
+      p[i] = (uint8_t)(v >> (8 * i));
+  }
+
+  static void write64(uint8_t *p, uint64_t v)
+  {
+    for (int i = 0; i < 8; i++)
+      p[i] = (uint8_t)(v >> (8 * i));
+  }
+
+  static uint32_t read32(const uint8_t *p)
+  {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  static uint64_t read64(const uint8_t *p)
+  {
+    return (uint64_t)read32(p) | ((uint64_t)read32(p + 4) << 32);
+  }
+
+  void send(PacketType type, uint32_t node, uint32_t seq, uint64_t a, uint64_t b)
+  {
+    uint8_t packet[PACKET_BYTES];
+    packet[0] = 'C';
+    packet[1] = 'S';
+    packet[2] = static_cast<uint8_t>(type);
+    packet[3] = VERSION;
+    write32(packet + 4, node);
+    write32(packet + 8, seq);
+    write64(packet + 12, a);
+    write64(packet + 20, b);
+    transport_->send(broadcastIP_, port_, packet, PACKET_BYTES);
+  }
+
+  void handlePacket(const uint8_t *packet, uint64_t localMicros)
+  {
+    PacketType type = static_cast<PacketType>(packet[2]);
+    uint32_t node = read32(packet + 4);
+    uint32_t seq = read32(packet + 8);
+    uint64_t a = read64(packet + 12);
+    uint64_t b = read64(packet + 20);
+
+    if (role_ == Role::Master)
+    {
+      // t4 is stamped on receipt; the follower's t3 is echoed back
+      if (type == PacketType::DelayRequest && node != nodeId_)
+        send(PacketType::DelayResponse, node, seq, a, localMicros);
+      return;
+    }
+
+    if (type == PacketType::Sync)
+    {
+      t1_ = a;
+      t2_ = localMicros;
+      t3_ = localMicros;
+      pendingSeq_ = seq;
+      awaitingResponse_ = true;
+      send(PacketType::DelayRequest, nodeId_, seq, t3_, 0);
+    }
+    else if (type == PacketType::DelayResponse && node == nodeId_ && awaitingResponse_ &&
+             seq == pendingSeq_ && a == t3_)
+    {
+      awaitingResponse_ = false;
+      addSample((int64_t)(t2_ - t1_), (int64_t)(b - t3_), localMicros);
+    }
+  }
+
+  /**
+   * @brief Add a measurement and steer the applied offset
+   * @param forward t2 - t1 (master to follower, including offset)
+   * @param backward t4 - t3 (follower to master, excluding offset)
+   */
+  void addSample(int64_t forward, int64_t backward, uint64_t localMicros)
+  {
+    const int64_t stepThreshold = (int64_t)PortalConfig::ClockSync::STEP_THRESHOLD_MS * 1000;
+    const int64_t maxSlew = (int64_t)PortalConfig::ClockSync::MAX_SLEW_US;
+
+    Sample sample = {(forward - backward) / 2, (forward + backward) / 2};
+    int64_t jump = sample.offset - offsetMicros_;
+    if (jump > stepThreshold || jump < -stepThreshold)
+      filled_ = 0; // Master restarted or a clock jumped: old samples are meaningless
+
+    samples_[sampleIndex_] = sample;
+    sampleIndex_ = (sampleIndex_ + 1) % FILTER_SAMPLES;
+    if (filled_ < FILTER_SAMPLES)
+      filled_++;
+    sampleCount_++;
+    lastDelayMicros_ = (uint32_t)(sample.delay > 0 ? sample.delay : 0);
+    lastSampleTime_ = localMicros;
+
+    // The newest filled_ entries end just before sampleIndex_
+    Sample best = sample;
+    for (int i = 1; i < filled_; i++)
+    {
+      const Sample &candidate = samples_[(sampleIndex_ - 1 - i + FILTER_SAMPLES) % FILTER_SAMPLES];
+      if (candidate.delay < best.delay)
+        best = candidate;
+    }
+
+    int64_t error = best.offset - offsetMicros_;
+    if (!locked_ || error > stepThreshold || error < -stepThreshold)
+    {
+      offsetMicros_ = best.offset;
+      locked_ = true;
+    }
+    else
+    {
+      offsetMicros_ += error > maxSlew ? maxSlew : (error < -maxSlew ? -maxSlew : error);
+    }
+  }
+};
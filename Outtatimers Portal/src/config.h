@@ -13,7 +13,10 @@
  */
 
 // WiFi Enable Flag (for preprocessor)
-#define ENABLE_WIFI_CONTROL 1 // Set to 1 to enable WiFi control
+#define ENABLE_WIFI_CONTROL 1    // Set to 1 to enable WiFi control
+#define ENABLE_INNER_RING 0      // Set to 1 to drive a second, inner ring
+#define ENABLE_SHIFT_INPUTS 0    // Set to 1 to read the buttons through 74HC165 shift registers
+#define ENABLE_SERIAL_COMMANDS 1 // Set to 1 to accept binary commands from a show PC on USB serial
 
 namespace PortalConfig
 {
@@ -21,14 +24,32 @@ namespace PortalConfig
   namespace Hardware
   {
     constexpr int LED_PIN = 4;                    // GPIO4 (D2 on Lolin D1)
-    constexpr int NUM_LEDS = 800;                 // Total LED count in strip
+    constexpr int NUM_LEDS = 800;                 // Default LED count (runtime setting, see /set_leds)
+    constexpr int MAX_NUM_LEDS = 1200;            // Largest runtime LED count the build supports
     constexpr uint8_t DEFAULT_BRIGHTNESS = 255;   // Maximum brightness
     constexpr uint8_t DIAGNOSTIC_BRIGHTNESS = 25; // ~10% for startup diagnostics
 
+    // Optional inner ring (ENABLE_INNER_RING)
+    constexpr int INNER_LED_PIN = 5;    // GPIO5 (D1 on Lolin D1)
+    constexpr int INNER_NUM_LEDS = 120; // LED count of the inner ring
+
+    // Per-LED RAM budgets, checked at compile time
+    constexpr int MAX_LEDS_PER_RING = 2048;         // Largest ring a single driver/effect may drive
+    constexpr unsigned long LED_RAM_BUDGET = 32768; // Bytes for all driver and effect buffers together
+
     // Button pin assignments
     constexpr int BUTTON1_PIN = 14; // GPIO14 (D5) - Portal toggle
     constexpr int BUTTON2_PIN = 12; // GPIO12 (D6) - Malfunction trigger
     constexpr int BUTTON3_PIN = 13; // GPIO13 (D7) - Fade out
+    constexpr int BUTTON4_PIN = 0;  // GPIO0 (D3) - Mode (tap) and dimming (hold); keep released during boot
+
+    // Button edge capture
+    constexpr bool BUTTON_INTERRUPTS = true; // Timestamp edges in a pin ISR instead of polling
+
+    // 74HC165 input expander (ENABLE_SHIFT_INPUTS). It uses the SPI pins
+    // GPIO12/14, so the buttons move to expander inputs A-C.
+    constexpr int SHIFT_LATCH_PIN = 16; // GPIO16 (D0) - parallel load
+    constexpr int SHIFT_CHIPS = 1;      // Chained chips, 8 inputs each (max 4)
 
     // Status LED (on-board LED)
     constexpr int STATUS_LED_PIN = 2;            // GPIO2 (D4) - On-board LED on most ESP8266 boards
@@ -49,8 +70,20 @@ namespace PortalConfig
   namespace Timing
   {
     constexpr unsigned long UPDATE_INTERVAL_MS = 10;   // ~100 FPS update rate
+    constexpr unsigned long ROTATION_STEP_MS = 24;     // Clock time per rotation step (the 800-LED frame period)
     constexpr unsigned long DEBOUNCE_INTERVAL_MS = 50; // Button debounce time
 
+    // Button gestures (0 disables a gesture)
+    constexpr unsigned long LONG_PRESS_MS = 800;  // Hold time for a long press
+    constexpr unsigned long DOUBLE_TAP_MS = 0;    // Second-tap window; delays single taps by this much
+    constexpr unsigned long HOLD_REPEAT_MS = 150; // Repeat interval while held after a long press
+    constexpr uint8_t DIM_STEP = 16;              // Max brightness step per dim command
+    constexpr uint8_t DIM_MIN = 16;               // Dimming turns back up at this max brightness
+
+    constexpr unsigned long SHIFT_SAMPLE_MS = 10; // Expander sampling; 4 agreeing samples debounce
+
+    constexpr unsigned long LATENCY_REPORT_MS = 30000; // Serial input latency report (0 = off)
+
     // Startup sequence timing
     constexpr unsigned long STARTUP_INITIAL_DELAY_MS = 100;
     constexpr unsigned long STARTUP_COLOR_DURATION_MS = 500;
@@ -107,6 +140,54 @@ namespace PortalConfig
     constexpr uint8_t MALFUNCTION_BRIGHTNESS_OFFSET = 85;
   }
 
+  // Web UI live preview configuration
+  namespace Preview
+  {
+    constexpr int BINS = 100;                            // Ring is downsampled to this many preview pixels
+    constexpr unsigned long MIN_FRAME_INTERVAL_MS = 100; // Capture at most 10 preview frames per second
+  }
+
+  // Lighting console input (E1.31 / Art-Net)
+  namespace Dmx
+  {
+    constexpr uint16_t E131_PORT = 5568;                // sACN unicast port
+    constexpr uint16_t ARTNET_PORT = 6454;              // Art-Net port (a second socket; both accept either format)
+    constexpr uint16_t E131_START_UNIVERSE = 1;         // sACN universes are 1-based
+    constexpr uint16_t ARTNET_START_UNIVERSE = 0;       // Art-Net universes are 0-based
+    constexpr int PIXELS_PER_UNIVERSE = 170;            // 510 of 512 channels as RGB triplets
+    constexpr unsigned long TAKEOVER_TIMEOUT_MS = 2500; // E1.31 network data loss timeout
+  }
+
+  // On-device show timeline
+  namespace Timeline
+  {
+    constexpr const char *DEFAULT_CUE_FILE = "/show.cue"; // Cue list loaded at boot
+  }
+
+  // Persistent settings on LittleFS
+  namespace Storage
+  {
+    constexpr const char *CONFIG_LOG_PATH = "/config.log";      // Append-only settings log
+    constexpr const char *CONFIG_TMP_PATH = "/config.tmp";      // Compaction target, renamed over the log
+    constexpr unsigned int MAX_CONFIG_LOG_BYTES = 480;          // Compact once the log would exceed this
+    constexpr unsigned long CONFIG_WRITE_DEBOUNCE_MS = 2000;    // Settings must be quiet this long before a write
+    constexpr int PRESET_SLOTS = 8;                             // Number of saved looks
+    constexpr const char *PRESET_PATH_FORMAT = "/preset%d.bin"; // Per-slot file (slot number substituted)
+    constexpr const char *PRESET_TMP_PATH = "/preset.tmp";      // Save target, renamed over the slot file
+  }
+
+  // Multi-portal shared show clock
+  namespace ClockSync
+  {
+    constexpr uint16_t PORT = 7002;                 // UDP port shared by all portals (broadcast)
+    constexpr bool IS_MASTER = false;               // Default role (runtime setting, see /set_clock_role)
+    constexpr unsigned long SYNC_INTERVAL_MS = 250; // Master SYNC broadcast period
+    constexpr unsigned long LOCK_TIMEOUT_MS = 5000; // Follower counts as unlocked without samples for this long
+    constexpr unsigned long STEP_THRESHOLD_MS = 50; // Larger errors are stepped instead of slewed
+    constexpr unsigned long MAX_SLEW_US = 1000;     // Largest correction applied per sample
+    constexpr unsigned CATCH_UP_RATE_PERCENT = 50;  // Show clock rate while the master's clock catches up
+  }
+
   // Mathematical Constants
   namespace Math
   {
@@ -120,11 +201,19 @@ namespace PortalConfig
     High = 1
   };
 
+  // Binary serial command console (ENABLE_SERIAL_COMMANDS)
+  namespace SerialConsole
+  {
+    constexpr unsigned long BAUD_RATE = 115200; // Shared with the log output
+    constexpr int MAX_BYTES_PER_UPDATE = 128;   // Parser budget per loop() iteration
+  }
+
   // WiFi Configuration
   namespace WiFi
   {
     constexpr int HTTP_PORT = 80;                    // Web server port
     constexpr unsigned long WIFI_TIMEOUT_MS = 10000; // WiFi connection timeout
+    constexpr uint16_t CUE_UDP_PORT = 7001;          // Low-latency UDP cue trigger port
 
     // WiFi credentials are loaded from wifi_credentials.h (git-ignored)
     // Copy wifi_credentials.h.template to wifi_credentials.h and configure
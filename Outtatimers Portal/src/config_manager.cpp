@@ -5,4 +5,9 @@ uint8_t ConfigManager::maxBrightness = 255;
 uint8_t ConfigManager::hueMin = 160;
 uint8_t ConfigManager::hueMax = 200;
 bool ConfigManager::effectNeedsRegeneration = false;
-int ConfigManager::portalMode = 0;
\ No newline at end of file
+int ConfigManager::portalMode = 0;
+int ConfigManager::ledCount = PortalConfig::Hardware::NUM_LEDS;
+bool ConfigManager::clockMaster = PortalConfig::ClockSync::IS_MASTER;
+uint32_t ConfigManager::version = 0;
+int ConfigManager::openTransactions = 0;
+ConfigManager::Snapshot ConfigManager::published = {0, 2, 255, 160, 200, 0};
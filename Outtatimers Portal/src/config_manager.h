@@ -1,17 +1,68 @@
 #pragma once
 
 #include <stdint.h>
+#include "config.h"
+#ifndef UNIT_TEST
 #include <Arduino.h>
+#else
+// Arduino-style constrain() for host builds
+#ifndef constrain
+#define constrain(x, a, b) ((x) < (a) ? (a) : ((x) > (b) ? (b) : (x)))
+#endif
+#endif
 
 /**
  * @brief Configuration manager for runtime parameters
  *
  * This class provides a simple way to store and retrieve configuration
  * parameters that can be modified at runtime.
+ *
+ * Setters and getters work on the staged values. Effects instead read an
+ * immutable Snapshot taken once per frame with capture(), so a frame never
+ * mixes old and new values. Writers that change several values at once wrap
+ * them in a Transaction; capture() does not publish while one is open.
+ *
+ * @example
+ * ```cpp
+ * {
+ *     ConfigManager::Transaction transaction;
+ *     ConfigManager::setHueMin(10);
+ *     ConfigManager::setHueMax(40);
+ * } // published together at the next capture()
+ *
+ * const ConfigManager::Snapshot frame = ConfigManager::capture();
+ * ```
  */
 class ConfigManager
 {
 public:
+  /// Shortest ring the gradient effect can lay its drivers on
+  static constexpr int MIN_LED_COUNT = PortalConfig::Effects::MAX_DRIVER_DISTANCE + 1;
+
+  /**
+   * @brief Immutable view of all parameters, as published at a frame start
+   */
+  struct Snapshot
+  {
+    uint32_t version; ///< getVersion() at the time of publishing
+    int rotationSpeed;
+    uint8_t maxBrightness;
+    uint8_t hueMin;
+    uint8_t hueMax;
+    int portalMode;
+  };
+
+  /**
+   * @brief Scope guard grouping several setter calls into one publish
+   */
+  struct Transaction
+  {
+    Transaction() { openTransactions++; }
+    ~Transaction() { openTransactions--; }
+    Transaction(const Transaction &) = delete;
+    Transaction &operator=(const Transaction &) = delete;
+  };
+
   /**
    * @brief Initialize the configuration manager
    */
@@ -23,7 +74,31 @@ public:
     hueMin = 160;        // Default minimum hue (blue)
     hueMax = 200;        // Default maximum hue (purple)
     portalMode = 0;      // Default to classic mode
+    ledCount = PortalConfig::Hardware::NUM_LEDS;
+    clockMaster = PortalConfig::ClockSync::IS_MASTER;
     effectNeedsRegeneration = false;
+    version++;
+    publish();
+  }
+
+  /**
+   * @brief Publish staged changes (unless a Transaction is open) and return
+   * the current snapshot; call once at the start of each frame
+   * @return Snapshot valid until the next capture()
+   */
+  static const Snapshot &capture()
+  {
+    if (openTransactions == 0 && published.version != version)
+      publish();
+    return published;
+  }
+
+  /**
+   * @brief Last published snapshot, without publishing
+   */
+  static const Snapshot &current()
+  {
+    return published;
   }
 
   /**
@@ -42,6 +117,7 @@ public:
   static void setRotationSpeed(int speed)
   {
     rotationSpeed = constrain(speed, 0, 10);
+    version++;
   }
 
   /**
@@ -60,6 +136,7 @@ public:
   static void setMaxBrightness(uint8_t brightness)
   {
     maxBrightness = constrain(brightness, 0, 255);
+    version++;
   }
 
   /**
@@ -79,6 +156,7 @@ public:
   {
     hueMin = constrain(minHue, 0, 255);
     effectNeedsRegeneration = true;
+    version++;
   }
 
   /**
@@ -98,6 +176,7 @@ public:
   {
     hueMax = constrain(maxHue, 0, 255);
     effectNeedsRegeneration = true;
+    version++;
   }
 
   /**
@@ -106,7 +185,17 @@ public:
    */
   static bool needsEffectRegeneration()
   {
-    return effectNeedsRegeneration;
+    // Hold back while a Transaction is open so the gradient is regenerated
+    // from the same values the next snapshot will carry
+    return effectNeedsRegeneration && openTransactions == 0;
+  }
+
+  /**
+   * @brief Ask the effect to regenerate its gradient on the next frame
+   */
+  static void requestEffectRegeneration()
+  {
+    effectNeedsRegeneration = true;
   }
 
   /**
@@ -134,13 +223,85 @@ public:
   {
     portalMode = constrain(mode, 0, 1);
     effectNeedsRegeneration = true;
+    version++;
+  }
+
+  /**
+   * @brief Get the configured LED count of the main ring
+   *
+   * Buffers are sized once at boot, so a new count takes effect after the
+   * next restart.
+   * @return LED count (MIN_LED_COUNT to MAX_NUM_LEDS)
+   */
+  static int getLedCount()
+  {
+    return ledCount;
+  }
+
+  /**
+   * @brief Set the LED count of the main ring (applied at the next boot)
+   * @param count LED count (MIN_LED_COUNT to MAX_NUM_LEDS)
+   */
+  static void setLedCount(int count)
+  {
+    ledCount = constrain(count, MIN_LED_COUNT, PortalConfig::Hardware::MAX_NUM_LEDS);
+    version++;
+  }
+
+  /**
+   * @brief Whether this portal is the show clock master
+   *
+   * The clock role is chosen once at boot, so a change takes effect after
+   * the next restart. Exactly one portal on stage should be the master.
+   * @return true for master, false for follower
+   */
+  static bool isClockMaster()
+  {
+    return clockMaster;
+  }
+
+  /**
+   * @brief Set the show clock role (applied at the next boot)
+   * @param master true for master, false for follower
+   */
+  static void setClockMaster(bool master)
+  {
+    clockMaster = master;
+    version++;
+  }
+
+  /**
+   * @brief Get the configuration version
+   *
+   * Incremented by every setter, so observers (e.g. persistence) can detect
+   * changes without comparing each value.
+   * @return Monotonic change counter
+   */
+  static uint32_t getVersion()
+  {
+    return version;
   }
 
 private:
+  static void publish()
+  {
+    published.version = version;
+    published.rotationSpeed = rotationSpeed;
+    published.maxBrightness = maxBrightness;
+    published.hueMin = hueMin;
+    published.hueMax = hueMax;
+    published.portalMode = portalMode;
+  }
+
   static int rotationSpeed;
   static uint8_t maxBrightness;
   static uint8_t hueMin;
   static uint8_t hueMax;
   static bool effectNeedsRegeneration;
   static int portalMode;
+  static int ledCount;
+  static bool clockMaster;
+  static uint32_t version;
+  static int openTransactions;
+  static Snapshot published;
 };
\ No newline at end of file
@@ -0,0 +1,311 @@
+#pragma once
+
+#include "config.h"
+#include "config_manager.h"
+#include "crc16.h"
+#include "file_store.h"
+
+/**
+ * @brief Persists ConfigManager settings in an append-only log on LittleFS
+ *
+ * Every change is appended as a small fixed-size record; the last valid
+ * record per key wins. Records are CRC-checked, so a write torn by a power
+ * cut only loses that record (the log is repaired on the next boot).
+ *
+ * Record layout (6 bytes):
+ * ```
+ * [0]    0xA5 magic
+ * [1]    key (ConfigStore::Key)
+ * [2..3] value, int16 little endian
+ * [4..5] CRC-16/CCITT over bytes 0..3
+ * ```
+ *
+ * - Boot restores everything with a single read of the whole log
+ * - Writes are debounced: settings must be unchanged for
+ *   CONFIG_WRITE_DEBOUNCE_MS, so dragging a slider causes one write
+ * - Only keys that differ from the last persisted value are appended
+ * - When the log would outgrow MAX_CONFIG_LOG_BYTES it is compacted to one
+ *   record per key, written to a temp file and renamed over the log
+ *
+ * @example
+ * ```cpp
+ * LittleFSFileStore files;
+ * ConfigStore configStore(&files);
+ *
+ * ConfigManager::begin();
+ * files.begin();
+ * configStore.load();
+ *
+ * void loop() { configStore.update(millis()); }
+ * ```
+ */
+class ConfigStore
+{
+public:
+  enum class Key : uint8_t
+  {
+    RotationSpeed = 1,
+    MaxBrightness,
+    HueMin,
+    HueMax,
+    PortalMode,
+    LedCount,
+    ClockMaster
+  };
+
+  static constexpr int KEY_COUNT = 7;
+  static constexpr size_t RECORD_BYTES = 6;
+  static constexpr uint8_t RECORD_MAGIC = 0xA5;
+  static constexpr size_t MAX_LOG_BYTES = PortalConfig::Storage::MAX_CONFIG_LOG_BYTES;
+
+  static_assert(MAX_LOG_BYTES >= KEY_COUNT * RECORD_BYTES * 2, "Config log must hold at least two full snapshots");
+
+  /**
+   * @brief Construct a new ConfigStore
+   * @param files File store (must remain valid)
+   * @param path Log file path
+   * @param tempPath Compaction scratch file path
+   */
+  ConfigStore(IFileStore *files,
+              const char *path = PortalConfig::Storage::CONFIG_LOG_PATH,
+              const char *tempPath = PortalConfig::Storage::CONFIG_TMP_PATH)
+      : files_(files), path_(path), tempPath_(tempPath), logSize_(0), seenVersion_(0), dirty_(false),
+        lastChange_(0), writeCount_(0), compactionCount_(0), corruptCount_(0)
+  {
+    for (int i = 0; i < KEY_COUNT; i++)
+      persisted_[i] = 0;
+  }
+
+  /**
+   * @brief Restore the saved settings into ConfigManager
+   *
+   * Call after ConfigManager::begin() so missing keys keep their defaults.
+   * @return Number of valid records read, or -1 if no log exists yet
+   */
+  int load()
+  {
+    files_->remove(tempPath_); // Leftover of an interrupted compaction; the log itself is intact
+
+    long size = files_->size(path_);
+    if (size < 0)
+    {
+      snapshotPersisted();
+      logSize_ = 0;
+      return -1;
+    }
+
+    uint8_t log[MAX_LOG_BYTES];
+    size_t wanted = (size_t)size < MAX_LOG_BYTES ? (size_t)size : MAX_LOG_BYTES;
+    size_t length = files_->read(path_, 0, log, wanted);
+
+    int values[KEY_COUNT];
+    bool present[KEY_COUNT] = {false};
+    int valid = 0;
+    int corrupt = 0;
+    size_t offset = 0;
+    for (; offset + RECORD_BYTES <= length; offset += RECORD_BYTES)
+    {
+      const uint8_t *record = log + offset;
+      int index = record[1] - 1;
+      if (record[0] != RECORD_MAGIC || index < 0 || index >= KEY_COUNT ||
+          crc16(record, 4) != (uint16_t)(record[4] | (record[5] << 8)))
+      {
+        corrupt++;
+        continue;
+      }
+      values[index] = (int16_t)(record[2] | (record[3] << 8));
+      present[index] = true;
+      valid++;
+    }
+    if (offset != (size_t)size)
+      corrupt++; // Torn tail or log larger than expected
+    corruptCount_ += corrupt;
+
+    {
+      ConfigManager::Transaction transaction;
+      for (int i = 0; i < KEY_COUNT; i++)
+      {
+        if (present[i])
+          apply(static_cast<Key>(i + 1), values[i]);
+      }
+      ConfigManager::clearEffectRegenerationFlag();
+    }
+    snapshotPersisted();
+    logSize_ = length;
+
+    if (corrupt > 0)
+      compact(); // Rewrite so later appends stay record-aligned
+    return valid;
+  }
+
+  /**
+   * @brief Track changes and write them once settings are quiet
+   * @param now Current timestamp in milliseconds
+   * @return true if a flush was attempted
+   */
+  bool update(unsigned long now)
+  {
+    uint32_t version = ConfigManager::getVersion();
+    if (version != seenVersion_)
+    {
+      seenVersion_ = version;
+      lastChange_ = now;
+      dirty_ = true;
+    }
+
+    if (!dirty_ || now - lastChange_ < PortalConfig::Storage::CONFIG_WRITE_DEBOUNCE_MS)
+      return false;
+
+    if (!flush())
+      lastChange_ = now; // Back off a full debounce period before retrying
+    return true;
+  }
+
+  /**
+   * @brief Write pending changes immediately (e.g. before a reboot)
+   * @return true if the log is up to date
+   */
+  bool flush()
+  {
+    uint8_t records[KEY_COUNT * RECORD_BYTES];
+    size_t length = 0;
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+      Key key = static_cast<Key>(i + 1);
+      int value = current(key);
+      if (value != persisted_[i])
+      {
+        encode(key, value, records + length);
+        length += RECORD_BYTES;
+      }
+    }
+
+    bool ok = true;
+    if (length > 0)
+    {
+      if (logSize_ + length > MAX_LOG_BYTES)
+        ok = compact();
+      else if ((ok = files_->append(path_, records, length)))
+        logSize_ += length;
+      else
+        logSize_ = MAX_LOG_BYTES; // Unknown tail state: force a compaction next time
+
+      if (ok)
+      {
+        snapshotPersisted();
+        writeCount_++;
+      }
+    }
+    dirty_ = !ok;
+    return ok;
+  }
+
+  /**
+   * @brief Encode one log record
+   * @param key Setting
+   * @param value Setting value
+   * @param out Output buffer of RECORD_BYTES
+   */
+  static void encode(Key key, int value, uint8_t *out)
+  {
+    out[0] = RECORD_MAGIC;
+    out[1] = static_cast<uint8_t>(key);
+    out[2] = (uint8_t)(value & 0xFF);
+    out[3] = (uint8_t)((value >> 8) & 0xFF);
+    uint16_t crc = crc16(out, 4);
+    out[4] = (uint8_t)(crc & 0xFF);
+    out[5] = (uint8_t)(crc >> 8);
+  }
+
+  bool isDirty() const { return dirty_; }
+  size_t getLogSize() const { return logSize_; }
+  unsigned long getWriteCount() const { return writeCount_; }
+  unsigned long getCompactionCount() const { return compactionCount_; }
+  unsigned long getCorruptCount() const { return corruptCount_; }
+
+private:
+  IFileStore *files_;
+  const char *path_;
+  const char *tempPath_;
+  size_t logSize_;
+  uint32_t seenVersion_;
+  bool dirty_;
+  unsigned long lastChange_;
+  int persisted_[KEY_COUNT];
+  unsigned long writeCount_;
+  unsigned long compactionCount_;
+  unsigned long corruptCount_;
+
+  static int current(Key key)
+  {
+    switch (key)
+    {
+    case Key::RotationSpeed:
+      return ConfigManager::getRotationSpeed();
+    case Key::MaxBrightness:
+      return ConfigManager::getMaxBrightness();
+    case Key::HueMin:
+      return ConfigManager::getHueMin();
+    case Key::HueMax:
+      return ConfigManager::getHueMax();
+    case Key::PortalMode:
+      return ConfigManager::getPortalMode();
+    case Key::LedCount:
+      return ConfigManager::getLedCount();
+    case Key::ClockMaster:
+      return ConfigManager::isClockMaster() ? 1 : 0;
+    }
+    return 0;
+  }
+
+  static void apply(Key key, int value)
+  {
+    switch (key)
+    {
+    case Key::RotationSpeed:
+      ConfigManager::setRotationSpeed(value);
+      break;
+    case Key::MaxBrightness:
+      ConfigManager::setMaxBrightness(constrain(value, 0, 255));
+      break;
+    case Key::HueMin:
+      ConfigManager::setHueMin(constrain(value, 0, 255));
+      break;
+    case Key::HueMax:
+      ConfigManager::setHueMax(constrain(value, 0, 255));
+      break;
+    case Key::PortalMode:
+      ConfigManager::setPortalMode(value);
+      break;
+    case Key::LedCount:
+      ConfigManager::setLedCount(value);
+      break;
+    case Key::ClockMaster:
+      ConfigManager::setClockMaster(value != 0);
+      break;
+    }
+  }
+
+  void snapshotPersisted()
+  {
+    for (int i = 0; i < KEY_COUNT; i++)
+      persisted_[i] = current(static_cast<Key>(i + 1));
+    seenVersion_ = ConfigManager::getVersion();
+  }
+
+  /**
+   * @brief Replace the log with one record per key
+   */
+  bool compact()
+  {
+    uint8_t records[KEY_COUNT * RECORD_BYTES];
+    for (int i = 0; i < KEY_COUNT; i++)
+      encode(static_cast<Key>(i + 1), current(static_cast<Key>(i + 1)), records + i * RECORD_BYTES);
+
+    if (!files_->write(tempPath_, records, sizeof(records)) || !files_->rename(tempPath_, path_))
+      return false;
+    logSize_ = sizeof(records);
+    compactionCount_++;
+    return true;
+  }
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief CRC-16/CCITT-FALSE used by the on-flash record formats
+ * @param data Bytes to checksum
+ * @param length Number of bytes
+ * @param crc Running value, to checksum data in several pieces
+ * @return Updated CRC
+ */
+static inline uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
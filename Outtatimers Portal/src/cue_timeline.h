@@ -0,0 +1,429 @@
+#pragma once
+
+#include "config.h"
+#include "config_manager.h"
+#include "input_manager.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef UNIT_TEST
+#include <LittleFS.h>
+#endif
+
+/**
+ * @brief On-device show timeline that fires cues against millis()
+ *
+ * A cue list is loaded from LittleFS (default `/show.cue`) and executed
+ * inside loop(), so a running show needs no network round trips at all.
+ * Commands and parameter cues are emitted as regular input events (source
+ * "Timeline"), parameters with their values in the event arguments.
+ *
+ * Cue file format, one cue per line, times in milliseconds from show start:
+ * ```
+ * # time  action       arguments
+ * 0       toggle
+ * 1500    speed        4
+ * 2000    hue          180 220
+ * 2500    brightness   200
+ * 3000    mode         1
+ * 9000    malfunction
+ * 12000   fadeout
+ * ```
+ * Lines may be in any order; they are sorted by time on load.
+ *
+ * Transport control: start() plays from the current position, stop() pauses
+ * and keeps the position, seek() jumps to a position. Seeking re-applies the
+ * most recent parameter cues before the new position (but not commands), so
+ * the look matches what a full run-through would show.
+ *
+ * @example
+ * ```cpp
+ * CueTimeline timeline;
+ * timeline.loadFromFile("/show.cue");
+ * inputManager.addInputSource(&timeline);
+ * timeline.start(millis());
+ * ```
+ */
+class CueTimeline : public IInputSource
+{
+public:
+  /**
+   * @brief Cue actions
+   */
+  enum class Action : uint8_t
+  {
+    TogglePortal = static_cast<uint8_t>(InputManager::Command::TogglePortal),
+    TriggerMalfunction = static_cast<uint8_t>(InputManager::Command::TriggerMalfunction),
+    FadeOut = static_cast<uint8_t>(InputManager::Command::FadeOut),
+    SetSpeed = static_cast<uint8_t>(InputManager::Command::SetSpeed),
+    SetBrightness = static_cast<uint8_t>(InputManager::Command::SetBrightness),
+    SetHue = static_cast<uint8_t>(InputManager::Command::SetHue),
+    SetMode = static_cast<uint8_t>(InputManager::Command::SetMode)
+  };
+
+  /**
+   * @brief Single timeline entry
+   */
+  struct Cue
+  {
+    uint32_t atMs; ///< Offset from show start
+    Action action; ///< What to do
+    int16_t arg1;  ///< First argument (value, hue min, mode)
+    int16_t arg2;  ///< Second argument (hue max)
+  };
+
+  static constexpr int MAX_CUES = 128;
+  static constexpr size_t MAX_LINE = 64;
+
+  CueTimeline() : cueCount_(0), nextCue_(0), running_(false), startTime_(0), position_(0),
+                  eventQueueHead_(0), eventQueueTail_(0), firedCount_(0),
+                  heldBackCount_(0) {}
+
+  /**
+   * @brief Load a cue list from LittleFS
+   *
+   * Lines longer than MAX_LINE - 1 characters are rejected as a whole.
+   * @param path File path
+   * @return Number of cues loaded, or -1 if the file could not be opened
+   */
+  int loadFromFile(const char *path = PortalConfig::Timeline::DEFAULT_CUE_FILE)
+  {
+#ifndef UNIT_TEST
+    File file = LittleFS.open(path, "r");
+    if (!file)
+      return -1;
+
+    clear();
+    char line[MAX_LINE];
+    while (file.available())
+    {
+      size_t length = file.readBytesUntil('\n', line, sizeof(line) - 1);
+      line[length] = '\0';
+      if (length == sizeof(line) - 1)
+      {
+        // Stopped at the buffer: unless the newline follows, the line is too
+        // long; skip the rest of it so it does not turn into a cue of its own
+        int next = file.read();
+        if (next >= 0 && next != '\n')
+        {
+          while (file.available() && file.read() != '\n')
+            ;
+          continue;
+        }
+      }
+      parseLine(line);
+    }
+    file.close();
+    sortCues();
+    return cueCount_;
+#else
+    (void)path;
+    return -1;
+#endif
+  }
+
+  /**
+   * @brief Load a cue list from a text buffer (same format as the file)
+   * @param text NUL-terminated cue list
+   * @return Number of cues loaded
+   */
+  int loadFromString(const char *text)
+  {
+    clear();
+    char line[MAX_LINE];
+    while (*text)
+    {
+      size_t length = strcspn(text, "\n");
+      if (length < sizeof(line))
+      {
+        memcpy(line, text, length);
+        line[length] = '\0';
+        parseLine(line);
+      }
+      text += length;
+      if (*text == '\n')
+        text++;
+    }
+    sortCues();
+    return cueCount_;
+  }
+
+  /**
+   * @brief Start (or resume) playback from the current position
+   * @param now Current timestamp in milliseconds
+   */
+  void start(unsigned long now)
+  {
+    if (running_)
+      return;
+    startTime_ = now - position_;
+    running_ = true;
+  }
+
+  /**
+   * @brief Pause playback, keeping the current position
+   *
+   * Cues fired but not yet collected by the InputManager are discarded.
+   * @param now Current timestamp in milliseconds
+   */
+  void stop(unsigned long now)
+  {
+    if (!running_)
+      return;
+    position_ = now - startTime_;
+    running_ = false;
+    discardQueued();
+  }
+
+  /**
+   * @brief Jump to a position in the show
+   * @param positionMs Target position in milliseconds from show start (callers
+   * clamp negative input to 0)
+   * @param now Current timestamp in milliseconds
+   */
+  void seek(uint32_t positionMs, unsigned long now)
+  {
+    position_ = positionMs;
+    startTime_ = now - positionMs;
+    discardQueued(); // Fired from the old position; the cues after the new one fire again
+
+    // Chase parameter state up to the new position
+    int lastSpeed = -1, lastBrightness = -1, lastHue = -1, lastMode = -1;
+    nextCue_ = 0;
+    while (nextCue_ < cueCount_ && cues_[nextCue_].atMs < positionMs)
+    {
+      switch (cues_[nextCue_].action)
+      {
+      case Action::SetSpeed:
+        lastSpeed = nextCue_;
+        break;
+      case Action::SetBrightness:
+        lastBrightness = nextCue_;
+        break;
+      case Action::SetHue:
+        lastHue = nextCue_;
+        break;
+      case Action::SetMode:
+        lastMode = nextCue_;
+        break;
+      default:
+        break;
+      }
+      nextCue_++;
+    }
+    const int chased[] = {lastSpeed, lastBrightness, lastHue, lastMode};
+    ConfigManager::Transaction transaction;
+    for (int index : chased)
+    {
+      if (index >= 0)
+        applyParameter(cues_[index]);
+    }
+  }
+
+  bool update(unsigned long currentTime) override
+  {
+    if (!running_)
+      return hasEvents();
+
+    position_ = currentTime - startTime_;
+    // A full queue holds the remaining due cues back until the next update
+    while (nextCue_ < cueCount_ && cues_[nextCue_].atMs <= position_)
+    {
+      if (isQueueFull())
+      {
+        heldBackCount_++;
+        break;
+      }
+      fire(cues_[nextCue_]);
+      nextCue_++;
+    }
+    return hasEvents();
+  }
+
+  bool hasEvents() const override
+  {
+    return eventQueueHead_ != eventQueueTail_;
+  }
+
+  InputEvent getNextEvent() override
+  {
+    if (!hasEvents())
+    {
+      return {0, EventType::Released, 0, "none"};
+    }
+
+    InputEvent event = eventQueue_[eventQueueHead_];
+    eventQueueHead_ = (eventQueueHead_ + 1) % MAX_EVENTS;
+    return event;
+  }
+
+  const char *getSourceName() const override
+  {
+    return "Timeline";
+  }
+
+  bool isRunning() const { return running_; }
+  uint32_t getPosition() const { return position_; }
+  int getCueCount() const { return cueCount_; }
+  int getNextCueIndex() const { return nextCue_; }
+  unsigned long getFiredCount() const { return firedCount_; }
+  /**
+   * @brief Updates in which due cues waited for room in the event queue
+   */
+  unsigned long getHeldBackCount() const { return heldBackCount_; }
+  const Cue &getCue(int index) const { return cues_[index]; }
+
+  /**
+   * @brief Time of the last cue, i.e. the show length
+   */
+  uint32_t getDuration() const
+  {
+    return cueCount_ > 0 ? cues_[cueCount_ - 1].atMs : 0;
+  }
+
+private:
+  static constexpr int MAX_EVENTS = 16;
+
+  Cue cues_[MAX_CUES];
+  int cueCount_;
+  int nextCue_;
+  bool running_;
+  unsigned long startTime_;
+  uint32_t position_;
+  InputEvent eventQueue_[MAX_EVENTS];
+  int eventQueueHead_;
+  int eventQueueTail_;
+  unsigned long firedCount_;
+  unsigned long heldBackCount_;
+
+  void clear()
+  {
+    cueCount_ = 0;
+    nextCue_ = 0;
+    running_ = false;
+    position_ = 0;
+    discardQueued();
+  }
+
+  /**
+   * @brief Drop fired cues that have not been collected yet
+   */
+  void discardQueued()
+  {
+    eventQueueHead_ = eventQueueTail_;
+  }
+
+  /**
+   * @brief Parse one cue line; comments (#) and blank lines are ignored
+   * @return true if a cue was added
+   */
+  bool parseLine(char *line)
+  {
+    char *comment = strchr(line, '#');
+    if (comment)
+      *comment = '\0';
+
+    char *save = nullptr;
+    char *timeToken = strtok_r(line, " \t\r", &save);
+    char *actionToken = strtok_r(nullptr, " \t\r", &save);
+    if (!timeToken || !actionToken || cueCount_ >= MAX_CUES)
+      return false;
+
+    char *end = nullptr;
+    unsigned long atMs = strtoul(timeToken, &end, 10);
+    if (*end != '\0')
+      return false;
+
+    char *arg1Token = strtok_r(nullptr, " \t\r", &save);
+    char *arg2Token = strtok_r(nullptr, " \t\r", &save);
+    Cue cue = {(uint32_t)atMs, Action::TogglePortal,
+               (int16_t)(arg1Token ? atoi(arg1Token) : 0),
+               (int16_t)(arg2Token ? atoi(arg2Token) : 0)};
+
+    if (strcmp(actionToken, "toggle") == 0)
+      cue.action = Action::TogglePortal;
+    else if (strcmp(actionToken, "malfunction") == 0)
+      cue.action = Action::TriggerMalfunction;
+    else if (strcmp(actionToken, "fadeout") == 0)
+      cue.action = Action::FadeOut;
+    else if (strcmp(actionToken, "speed") == 0 && arg1Token)
+      cue.action = Action::SetSpeed;
+    else if (strcmp(actionToken, "brightness") == 0 && arg1Token)
+      cue.action = Action::SetBrightness;
+    else if (strcmp(actionToken, "hue") == 0 && arg1Token && arg2Token)
+      cue.action = Action::SetHue;
+    else if (strcmp(actionToken, "mode") == 0 && arg1Token)
+      cue.action = Action::SetMode;
+    else
+      return false;
+
+    cues_[cueCount_++] = cue;
+    return true;
+  }
+
+  /**
+   * @brief Stable insertion sort by time (cue lists are short and mostly sorted)
+   */
+  void sortCues()
+  {
+    for (int i = 1; i < cueCount_; i++)
+    {
+      Cue cue = cues_[i];
+      int j = i - 1;
+      while (j >= 0 && cues_[j].atMs > cue.atMs)
+      {
+        cues_[j + 1] = cues_[j];
+        j--;
+      }
+      cues_[j + 1] = cue;
+    }
+  }
+
+  void fire(const Cue &cue)
+  {
+    firedCount_++;
+    queueEvent({.inputId = static_cast<int>(cue.action),
+                .type = EventType::Pressed,
+                .timestamp = startTime_ + cue.atMs,
+                .sourceName = "Timeline",
+                .arg1 = cue.arg1,
+                .arg2 = cue.arg2});
+  }
+
+  static void applyParameter(const Cue &cue)
+  {
+    switch (cue.action)
+    {
+    case Action::SetSpeed:
+      ConfigManager::setRotationSpeed(cue.arg1);
+      break;
+    case Action::SetBrightness:
+      ConfigManager::setMaxBrightness(constrain(cue.arg1, 0, 255));
+      break;
+    case Action::SetHue:
+    {
+      ConfigManager::Transaction transaction;
+      ConfigManager::setHueMin(constrain(cue.arg1, 0, 255));
+      ConfigManager::setHueMax(constrain(cue.arg2, 0, 255));
+      break;
+    }
+    case Action::SetMode:
+      ConfigManager::setPortalMode(cue.arg1);
+      break;
+    default:
+      break;
+    }
+  }
+
+  bool isQueueFull() const
+  {
+    return (eventQueueTail_ + 1) % MAX_EVENTS == eventQueueHead_;
+  }
+
+  void queueEvent(const InputEvent &event)
+  {
+    // update() only fires when there is room, so nothing is dropped here
+    eventQueue_[eventQueueTail_] = event;
+    eventQueueTail_ = (eventQueueTail_ + 1) % MAX_EVENTS;
+  }
+};
@@ -85,3 +85,157 @@ private:
   int _stableState;            ///< Current stable state
   int _lastRead;               ///< Last raw reading
 };
+
+/**
+ * @brief Debounces timestamped edges captured by an interrupt handler
+ *
+ * Unlike Debounce, which needs the pin sampled regularly, this works on the
+ * edges themselves: a level is accepted once no further edge followed it for
+ * the debounce interval. The accepted change is dated to the first edge of
+ * its bounce burst, i.e. when the contact actually closed or opened, no
+ * matter how late update() got to process it.
+ *
+ * @example
+ * ```cpp
+ * EdgeDebounce debouncer(50);
+ *
+ * // For every captured edge, in order:
+ * debouncer.edge(level, edgeTime);
+ * // Then once per loop:
+ * if (debouncer.poll(millis()))
+ *     handleChange(debouncer.getState(), debouncer.getChangeTime());
+ * ```
+ *
+ * @note Call poll() after every edge() so no settled change is skipped
+ */
+class EdgeDebounce
+{
+public:
+  /**
+   * @brief Construct a new EdgeDebounce object
+   * @param intervalMs Quiet time after the last edge before a level is accepted
+   * @param initialState Stable level to start from
+   */
+  explicit EdgeDebounce(unsigned_long_t intervalMs = PortalConfig::Timing::DEBOUNCE_INTERVAL_MS, int initialState = HIGH)
+      : _interval(intervalMs), _stableState(initialState), _pendingState(initialState), _pending(false),
+        _lastEdge(0), _burstStart(0), _changeTime(0) {}
+
+  /**
+   * @brief Feed one captured edge
+   * @param level Pin level after the edge
+   * @param time Edge timestamp in milliseconds
+   * @return true if the edge settled an earlier change (read it before the next edge)
+   */
+  bool edge(int level, unsigned_long_t time)
+  {
+    bool changed = poll(time);
+    if (!_pending)
+    {
+      if (level == _stableState)
+        return changed; // Duplicate of the stable level
+      _burstStart = time;
+      _pending = true;
+    }
+    _pendingState = level;
+    _lastEdge = time;
+    return changed;
+  }
+
+  /**
+   * @brief Accept a pending level once it has been quiet for the interval
+   * @param now Current timestamp in milliseconds
+   * @return true if the stable state changed
+   */
+  bool poll(unsigned_long_t now)
+  {
+    if (!_pending || (long)(now - _lastEdge) < (long)_interval)
+      return false;
+    _pending = false;
+    if (_pendingState == _stableState)
+      return false; // Bounced back: no change
+    _stableState = _pendingState;
+    _changeTime = _burstStart;
+    return true;
+  }
+
+  /**
+   * @brief Get the current stable state
+   */
+  int getState() const { return _stableState; }
+
+  /**
+   * @brief Time of the first edge of the last accepted change
+   */
+  unsigned_long_t getChangeTime() const { return _changeTime; }
+
+private:
+  unsigned_long_t _interval;   ///< Required quiet time in milliseconds
+  int _stableState;            ///< Current stable state
+  int _pendingState;           ///< Level after the latest edge
+  bool _pending;               ///< An edge burst is in progress
+  unsigned_long_t _lastEdge;   ///< Timestamp of the latest edge
+  unsigned_long_t _burstStart; ///< Timestamp of the first edge of the burst
+  unsigned_long_t _changeTime; ///< Time of the last accepted change
+};
+
+/**
+ * @brief Debounces up to 32 inputs at once with vertical counters
+ *
+ * Each bit of the sampled word is one input. Two 32-bit words hold a 2-bit
+ * counter per input, one counter bit per word, so all inputs are debounced
+ * together in a handful of bitwise operations. An input changes state once
+ * it has differed from its stable state in SAMPLES consecutive samples;
+ * any sample agreeing with the stable state resets its counter.
+ *
+ * The debounce time is SAMPLES times the sampling interval, so sample at a
+ * fixed rate (e.g. every 10 ms for 40 ms).
+ *
+ * @example
+ * ```cpp
+ * VerticalDebounce inputs;
+ *
+ * // Every 10 ms:
+ * uint32_t changed = inputs.sample(GPI);
+ * uint32_t pressed = changed & ~inputs.getState(); // active low
+ * ```
+ *
+ * @performance O(1), independent of the number of inputs
+ */
+class VerticalDebounce
+{
+public:
+  static constexpr int SAMPLES = 4;
+
+  /**
+   * @brief Construct a new VerticalDebounce object
+   * @param initialState Stable state of all inputs to start from
+   */
+  explicit VerticalDebounce(uint32_t initialState = 0)
+      : _state(initialState), _count0(0xFFFFFFFFu), _count1(0xFFFFFFFFu) {}
+
+  /**
+   * @brief Feed one sample of all inputs
+   * @param raw Raw input bits
+   * @return Bits whose stable state changed with this sample
+   */
+  uint32_t sample(uint32_t raw)
+  {
+    uint32_t delta = raw ^ _state;
+    // Count down from 3 where the input differs, reset to 3 where it agrees
+    _count0 = ~(_count0 & delta);
+    _count1 = _count0 ^ (_count1 & delta);
+    uint32_t changed = delta & _count0 & _count1; // Counter wrapped past 0
+    _state ^= changed;
+    return changed;
+  }
+
+  /**
+   * @brief Get the stable state of all inputs
+   */
+  uint32_t getState() const { return _state; }
+
+private:
+  uint32_t _state;  ///< Debounced input bits
+  uint32_t _count0; ///< Low bit of each input's counter
+  uint32_t _count1; ///< High bit of each input's counter
+};
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "config.h"
+#include "input_manager.h"
+#include "led_driver.h"
+#include "udp_transport.h"
+#include <string.h>
+
+/**
+ * @brief Lighting console input: E1.31 (sACN) and Art-Net universes over UDP
+ *
+ * E1.31 is received on its own port (5568) and Art-Net on a second transport
+ * bound to 6454, the port Art-Net consoles send to. Either socket accepts
+ * both formats, so a console configured for the "wrong" port still works.
+ *
+ * Each received universe is copied straight from the UDP stack into the
+ * driver buffer: only the protocol header is read into a scratch buffer, the
+ * DMX slots are then read directly into `ILEDDriver::getBuffer()` at the
+ * universe's pixel offset. Universe `start + k` drives pixels
+ * `k * PIXELS_PER_UNIVERSE ...`, so 800 LEDs span 5 universes.
+ *
+ * While packets keep arriving the source is "active" and the main loop shows
+ * console frames instead of running the built-in effects. Once no data has
+ * been received for TAKEOVER_TIMEOUT_MS (or an E1.31 source sends
+ * Stream_Terminated) control is handed back to the effects.
+ *
+ * The source emits no command events; it only implements IInputSource so the
+ * InputManager polls it alongside the other sources.
+ *
+ * @example
+ * ```cpp
+ * WiFiUdpTransport e131Udp, artNetUdp;
+ * DmxInputSource dmx(&e131Udp, &driver, NUM_LEDS, &artNetUdp);
+ * dmx.begin();
+ * inputManager.addInputSource(&dmx);
+ *
+ * if (dmx.isActive(now)) {
+ *     if (dmx.consumeFrame()) driver.show();
+ * } else {
+ *     portal.update(now);
+ * }
+ * ```
+ */
+class DmxInputSource : public IInputSource
+{
+public:
+  static constexpr size_t ARTNET_HEADER_BYTES = 18;
+  static constexpr size_t E131_HEADER_BYTES = 126;
+  static constexpr size_t E131_SYNC_BYTES = 49;
+  static constexpr int MAX_UNIVERSES = 32;
+  static constexpr int MAX_PACKETS_PER_UPDATE = 16;
+  static constexpr size_t UNIVERSE_BYTES = PortalConfig::Dmx::PIXELS_PER_UNIVERSE * 3;
+
+  static_assert(sizeof(CRGB) == 3, "DMX slots are copied directly into the CRGB buffer");
+  static_assert(UNIVERSE_BYTES <= 512, "A universe carries at most 512 slots");
+
+  /**
+   * @brief Construct a new DmxInputSource
+   * @param transport UDP transport for E1.31 (must remain valid)
+   * @param driver LED driver whose buffer receives the pixel data
+   * @param numLeds Number of LEDs in the driver buffer
+   * @param artNetTransport Optional second transport for the Art-Net port
+   */
+  DmxInputSource(IUdpTransport *transport, ILEDDriver *driver, int numLeds, IUdpTransport *artNetTransport = nullptr)
+      : transport_(transport), artNetTransport_(artNetTransport), current_(transport), driver_(driver), active_(false), frameReady_(false),
+        lastPacketTime_(0), receivedMask_(0), sequenceMask_(0), packetCount_(0), rejectedCount_(0)
+  {
+    setLength(numLeds);
+  }
+
+  /**
+   * @brief Change the LED count (e.g. once the runtime count is known)
+   * @param numLeds Number of LEDs in the driver buffer
+   */
+  void setLength(int numLeds)
+  {
+    numLeds_ = numLeds;
+    universeCount_ = (numLeds_ + PortalConfig::Dmx::PIXELS_PER_UNIVERSE - 1) / PortalConfig::Dmx::PIXELS_PER_UNIVERSE;
+    if (universeCount_ > MAX_UNIVERSES)
+      universeCount_ = MAX_UNIVERSES;
+    completeMask_ = universeCount_ >= 32 ? 0xFFFFFFFFu : ((1u << universeCount_) - 1);
+    receivedMask_ = 0;
+  }
+
+  /**
+   * @brief Start listening for console data
+   * @param port UDP port of the E1.31 transport
+   * @param artNetPort UDP port of the Art-Net transport (if one is attached)
+   * @return true if at least one socket was opened
+   */
+  bool begin(uint16_t port = PortalConfig::Dmx::E131_PORT, uint16_t artNetPort = PortalConfig::Dmx::ARTNET_PORT)
+  {
+    bool e131 = transport_ && transport_->begin(port);
+    bool artNet = artNetTransport_ && artNetTransport_->begin(artNetPort);
+    return e131 || artNet;
+  }
+
+  bool update(unsigned long currentTime) override
+  {
+    receive(transport_, currentTime);
+    receive(artNetTransport_, currentTime);
+
+    if (active_ && currentTime - lastPacketTime_ >= PortalConfig::Dmx::TAKEOVER_TIMEOUT_MS)
+      release();
+    return false;
+  }
+
+  bool hasEvents() const override { return false; }
+
+  InputEvent getNextEvent() override
+  {
+    return {0, EventType::Released, 0, "none"};
+  }
+
+  const char *getSourceName() const override
+  {
+    return "DmxInput";
+  }
+
+  /**
+   * @brief Check whether the console currently owns the ring
+   * @param now Current timestamp in milliseconds
+   * @return true while console data is fresher than the takeover timeout
+   */
+  bool isActive(unsigned long now) const
+  {
+    return active_ && now - lastPacketTime_ < PortalConfig::Dmx::TAKEOVER_TIMEOUT_MS;
+  }
+
+  /**
+   * @brief Check and clear the "complete frame received" flag
+   * @return true if the driver buffer holds a new frame to show()
+   */
+  bool consumeFrame()
+  {
+    bool ready = frameReady_;
+    frameReady_ = false;
+    return ready;
+  }
+
+  /**
+   * @brief Number of universes needed to cover the strip
+   */
+  int getUniverseCount() const { return universeCount_; }
+
+  /**
+   * @brief Number of accepted data packets
+   */
+  unsigned long getPacketCount() const { return packetCount_; }
+
+  /**
+   * @brief Number of malformed, out-of-order or out-of-range packets
+   */
+  unsigned long getRejectedCount() const { return rejectedCount_; }
+
+private:
+  IUdpTransport *transport_;
+  IUdpTransport *artNetTransport_;
+  IUdpTransport *current_; // Transport of the packet being parsed
+  ILEDDriver *driver_;
+  int numLeds_;
+  int universeCount_;
+  bool active_;
+  bool frameReady_;
+  unsigned long lastPacketTime_;
+  uint32_t completeMask_;
+  uint32_t receivedMask_;
+  uint32_t sequenceMask_;
+  uint8_t lastSequence_[MAX_UNIVERSES];
+  unsigned long packetCount_;
+  unsigned long rejectedCount_;
+  uint8_t header_[E131_HEADER_BYTES];
+
+  static uint16_t readBE16(const uint8_t *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+  static uint32_t readBE32(const uint8_t *p) { return ((uint32_t)readBE16(p) << 16) | readBE16(p + 2); }
+
+  void receive(IUdpTransport *transport, unsigned long now)
+  {
+    if (transport == nullptr)
+      return;
+    current_ = transport;
+    for (int i = 0; i < MAX_PACKETS_PER_UPDATE; i++)
+    {
+      int size = transport->parsePacket();
+      if (size <= 0)
+        break;
+      handlePacket((size_t)size, now);
+    }
+  }
+
+  void handlePacket(size_t size, unsigned long now)
+  {
+    if (size < ARTNET_HEADER_BYTES || current_->read(header_, ARTNET_HEADER_BYTES) != (int)ARTNET_HEADER_BYTES)
+    {
+      rejectedCount_++;
+      return;
+    }
+
+    if (memcmp(header_, "Art-Net", 8) == 0)
+      handleArtNet(size, now);
+    else if (readBE16(header_) == 0x0010 && memcmp(header_ + 4, "ASC-E1.17", 9) == 0)
+      handleE131(size, now);
+    else
+      rejectedCount_++;
+  }
+
+  void handleArtNet(size_t size, unsigned long now)
+  {
+    uint16_t opcode = (uint16_t)(header_[8] | (header_[9] << 8));
+    if (opcode == 0x5200) // OpSync
+    {
+      if (active_)
+        frameReady_ = true;
+      return;
+    }
+    if (opcode != 0x5000) // OpDmx
+    {
+      rejectedCount_++;
+      return;
+    }
+
+    uint16_t universe = (uint16_t)(((header_[15] & 0x7F) << 8) | header_[14]);
+    size_t length = readBE16(header_ + 16);
+    if (length > size - ARTNET_HEADER_BYTES)
+      length = size - ARTNET_HEADER_BYTES;
+    // Art-Net sequence 0 means "sequencing disabled"
+    writeUniverse((int)universe - PortalConfig::Dmx::ARTNET_START_UNIVERSE, header_[12], header_[12] != 0, length, now);
+  }
+
+  void handleE131(size_t size, unsigned long now)
+  {
+    size_t headerBytes = size < E131_HEADER_BYTES ? size : E131_HEADER_BYTES;
+    size_t rest = headerBytes - ARTNET_HEADER_BYTES;
+    if (current_->read(header_ + ARTNET_HEADER_BYTES, rest) != (int)rest || size < E131_SYNC_BYTES)
+    {
+      rejectedCount_++;
+      return;
+    }
+
+    uint32_t rootVector = readBE32(header_ + 18);
+    uint32_t framingVector = readBE32(header_ + 40);
+    if (rootVector == 0x00000008 && framingVector == 0x00000001) // Universe synchronization
+    {
+      if (active_)
+        frameReady_ = true;
+      return;
+    }
+    if (rootVector != 0x00000004 || framingVector != 0x00000002 || size < E131_HEADER_BYTES ||
+        header_[117] != 0x02 || header_[125] != 0x00) // DMP set property, null start code
+    {
+      rejectedCount_++;
+      return;
+    }
+
+    if (header_[112] & 0x40) // Stream_Terminated: the source is going away
+    {
+      release();
+      return;
+    }
+    if (header_[112] & 0x80) // Preview data is not meant for live output
+      return;
+
+    uint16_t universe = readBE16(header_ + 113);
+    uint16_t valueCount = readBE16(header_ + 123);
+    size_t length = valueCount > 0 ? valueCount - 1 : 0;
+    if (length > size - E131_HEADER_BYTES)
+      length = size - E131_HEADER_BYTES;
+    writeUniverse((int)universe - PortalConfig::Dmx::E131_START_UNIVERSE, header_[111], true, length, now);
+  }
+
+  /**
+   * @brief Copy one universe's slots straight into the driver buffer
+   */
+  void writeUniverse(int index, uint8_t sequence, bool checkSequence, size_t length, unsigned long now)
+  {
+    if (index < 0 || index >= universeCount_)
+    {
+      rejectedCount_++;
+      return;
+    }
+
+    uint32_t bit = 1u << index;
+    if (checkSequence && (sequenceMask_ & bit))
+    {
+      // E1.31 6.7.2: discard packets 0..19 sequence numbers behind the last one
+      int8_t diff = (int8_t)(sequence - lastSequence_[index]);
+      if (diff <= 0 && diff > -20)
+      {
+        rejectedCount_++;
+        return;
+      }
+    }
+    lastSequence_[index] = sequence;
+    sequenceMask_ |= bit;
+
+    int pixelStart = index * PortalConfig::Dmx::PIXELS_PER_UNIVERSE;
+    size_t maxBytes = (size_t)(numLeds_ - pixelStart) * 3;
+    if (length > UNIVERSE_BYTES)
+      length = UNIVERSE_BYTES;
+    if (length > maxBytes)
+      length = maxBytes;
+    current_->read(reinterpret_cast<uint8_t *>(driver_->getBuffer() + pixelStart), length);
+
+    // A frame is complete once every universe has arrived; a repeated universe
+    // means one went missing, so show what we have rather than stall
+    if (receivedMask_ & bit)
+    {
+      frameReady_ = true;
+      receivedMask_ = 0;
+    }
+    receivedMask_ |= bit;
+    if (receivedMask_ == completeMask_)
+    {
+      frameReady_ = true;
+      receivedMask_ = 0;
+    }
+
+    active_ = true;
+    lastPacketTime_ = now;
+    packetCount_++;
+  }
+
+  void release()
+  {
+    active_ = false;
+    frameReady_ = false;
+    receivedMask_ = 0;
+    sequenceMask_ = 0;
+  }
+};
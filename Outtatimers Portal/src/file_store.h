@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef UNIT_TEST
+#include <LittleFS.h>
+#endif
+
+/**
+ * @brief Minimal file access used by the persistence code
+ *
+ * Wraps the handful of LittleFS operations the config log and presets need,
+ * so they can run against flash on the device and against an in-memory
+ * store on the host (see test/mock_file_store.h).
+ */
+class IFileStore
+{
+public:
+  /**
+   * @brief Mount the file system
+   * @return true on success
+   */
+  virtual bool begin() = 0;
+
+  /**
+   * @brief Size of a file
+   * @param path File path
+   * @return Size in bytes, or -1 if the file does not exist
+   */
+  virtual long size(const char *path) = 0;
+
+  /**
+   * @brief Read part of a file
+   * @param path File path
+   * @param offset Byte offset to start reading at
+   * @param buffer Destination buffer
+   * @param length Maximum number of bytes to read
+   * @return Number of bytes read
+   */
+  virtual size_t read(const char *path, size_t offset, uint8_t *buffer, size_t length) = 0;
+
+  /**
+   * @brief Append to a file, creating it if needed
+   * @return true if all bytes were written
+   */
+  virtual bool append(const char *path, const uint8_t *data, size_t length) = 0;
+
+  /**
+   * @brief Replace a file's contents
+   * @return true if all bytes were written
+   */
+  virtual bool write(const char *path, const uint8_t *data, size_t length) = 0;
+
+  /**
+   * @brief Atomically rename a file, replacing the destination
+   * @return true on success
+   */
+  virtual bool rename(const char *from, const char *to) = 0;
+
+  /**
+   * @brief Delete a file
+   * @return true if the file was removed
+   */
+  virtual bool remove(const char *path) = 0;
+
+  virtual ~IFileStore() {}
+};
+
+#ifndef UNIT_TEST
+
+/**
+ * @brief IFileStore on the ESP8266 LittleFS partition
+ */
+class LittleFSFileStore : public IFileStore
+{
+public:
+  bool begin() override { return LittleFS.begin(); }
+
+  long size(const char *path) override
+  {
+    File file = LittleFS.open(path, "r");
+    if (!file)
+      return -1;
+    long bytes = (long)file.size();
+    file.close();
+    return bytes;
+  }
+
+  size_t read(const char *path, size_t offset, uint8_t *buffer, size_t length) override
+  {
+    File file = LittleFS.open(path, "r");
+    if (!file)
+      return 0;
+    size_t bytes = 0;
+    if (file.seek(offset, SeekSet))
+      bytes = file.read(buffer, length);
+    file.close();
+    return bytes;
+  }
+
+  bool append(const char *path, const uint8_t *data, size_t length) override
+  {
+    return writeMode(path, "a", data, length);
+  }
+
+  bool write(const char *path, const uint8_t *data, size_t length) override
+  {
+    return writeMode(path, "w", data, length);
+  }
+
+  bool rename(const char *from, const char *to) override { return LittleFS.rename(from, to); }
+  bool remove(const char *path) override { return LittleFS.remove(path); }
+
+private:
+  static bool writeMode(const char *path, const char *mode, const uint8_t *data, size_t length)
+  {
+    File file = LittleFS.open(path, mode);
+    if (!file)
+      return false;
+    size_t written = file.write(data, length);
+    file.close();
+    return written == length;
+  }
+};
+
+#endif
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "config.h"
+#include "led_driver.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Rate-limited, delta-encoded snapshot of the LED ring for the web UI
+ *
+ * The driver buffer is downsampled to PortalConfig::Preview::BINS averaged
+ * pixels, quantized to RGB565 and encoded as either a keyframe or a delta
+ * against the previous capture. Capturing happens at most once every
+ * MIN_FRAME_INTERVAL_MS; requests arriving faster are answered from the cached
+ * frame, so polling clients can never push the cost above the cap.
+ *
+ * Frame layout (little endian):
+ * ```
+ * [0]    'P' magic
+ * [1]    flags (bit0 = keyframe)
+ * [2..3] sequence number of this frame
+ * [4..5] base sequence the delta applies to (equals seq for keyframes)
+ * [6]    bin count
+ * [7]    run count (deltas only)
+ * keyframe payload: bin count x RGB565
+ * delta payload:    runs of {start, length, length x RGB565}
+ * ```
+ *
+ * @example
+ * ```cpp
+ * FramePreview preview(&driver, NUM_LEDS);
+ * uint8_t frame[FramePreview::MAX_FRAME_BYTES];
+ * size_t len = preview.encode(millis(), clientSeq, true, frame, sizeof(frame));
+ * ```
+ *
+ * @note Not thread-safe; call from the main loop (e.g. an HTTP handler)
+ * @performance O(numLeds) per capture, O(BINS) per encode
+ */
+class FramePreview
+{
+public:
+  static constexpr int BINS = PortalConfig::Preview::BINS;
+  static constexpr size_t HEADER_BYTES = 8;
+  static constexpr size_t MAX_FRAME_BYTES = HEADER_BYTES + BINS * 2;
+  static constexpr uint8_t MAGIC = 'P';
+  static constexpr uint8_t FLAG_KEYFRAME = 0x01;
+
+  static_assert(BINS > 0 && BINS <= 255, "Preview bin count must fit in one byte");
+
+  /**
+   * @brief Construct a new FramePreview
+   * @param driver LED driver whose buffer is previewed
+   * @param numLeds Number of LEDs in the driver buffer
+   */
+  FramePreview(ILEDDriver *driver, int numLeds)
+      : driver_(driver), numLeds_(numLeds), seq_(0), hasFrame_(false), hasPrevious_(false), lastCapture_(0), captureCount_(0) {}
+
+  /**
+   * @brief Change the previewed LED count (e.g. once the runtime count is known)
+   * @param numLeds Number of LEDs in the driver buffer
+   */
+  void setLength(int numLeds)
+  {
+    numLeds_ = numLeds;
+    hasFrame_ = false;
+    hasPrevious_ = false;
+  }
+
+  /**
+   * @brief Encode the latest preview frame for a client
+   * @param now Current timestamp in milliseconds
+   * @param clientSeq Sequence number of the frame the client currently holds
+   * @param clientHasFrame false if the client holds no frame yet
+   * @param out Output buffer (at least MAX_FRAME_BYTES)
+   * @param outSize Size of the output buffer
+   * @return Number of bytes written, 0 if the buffer is too small
+   */
+  size_t encode(unsigned long now, uint16_t clientSeq, bool clientHasFrame, uint8_t *out, size_t outSize)
+  {
+    if (out == nullptr || outSize < MAX_FRAME_BYTES)
+      return 0;
+
+    if (!hasFrame_ || now - lastCapture_ >= PortalConfig::Preview::MIN_FRAME_INTERVAL_MS)
+      capture(now);
+
+    if (clientHasFrame && clientSeq == seq_)
+      return writeHeader(out, 0, seq_, seq_, 0); // Nothing new since the last poll
+
+    if (clientHasFrame && clientSeq == (uint16_t)(seq_ - 1) && hasPrevious_)
+    {
+      size_t len = encodeDelta(out);
+      if (len > 0)
+        return len;
+    }
+    return encodeKeyframe(out);
+  }
+
+  /**
+   * @brief Get the sequence number of the most recent capture
+   * @return Frame sequence number
+   */
+  uint16_t getSequence() const { return seq_; }
+
+  /**
+   * @brief Get the number of captures performed so far
+   * @return Capture count (for rate-limit diagnostics)
+   */
+  unsigned long getCaptureCount() const { return captureCount_; }
+
+  /**
+   * @brief Pack an 8-bit RGB color into RGB565
+   */
+  static uint16_t toRGB565(uint8_t r, uint8_t g, uint8_t b)
+  {
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+  }
+
+private:
+  ILEDDriver *driver_;
+  int numLeds_;
+  uint16_t seq_;
+  bool hasFrame_;
+  bool hasPrevious_;
+  unsigned long lastCapture_;
+  unsigned long captureCount_;
+  uint16_t current_[BINS];
+  uint16_t previous_[BINS];
+
+  /**
+   * @brief Downsample the driver buffer into the current frame
+   * @param now Capture timestamp
+   */
+  void capture(unsigned long now)
+  {
+    if (hasFrame_)
+    {
+      for (int i = 0; i < BINS; i++)
+        previous_[i] = current_[i];
+      hasPrevious_ = true;
+    }
+
+    const CRGB *leds = driver_ ? driver_->getBuffer() : nullptr;
+    for (int bin = 0; bin < BINS; bin++)
+    {
+      int start = (int)((long)bin * numLeds_ / BINS);
+      int end = (int)((long)(bin + 1) * numLeds_ / BINS);
+      if (end <= start)
+        end = start + 1;
+
+      uint32_t r = 0, g = 0, b = 0;
+      int count = 0;
+      for (int i = start; i < end && leds != nullptr && i < numLeds_; i++)
+      {
+        r += leds[i].r;
+        g += leds[i].g;
+        b += leds[i].b;
+        count++;
+      }
+      current_[bin] = count > 0 ? toRGB565(r / count, g / count, b / count) : 0;
+    }
+
+    seq_ = hasFrame_ ? (uint16_t)(seq_ + 1) : seq_;
+    hasFrame_ = true;
+    lastCapture_ = now;
+    captureCount_++;
+  }
+
+  size_t writeHeader(uint8_t *out, uint8_t flags, uint16_t seq, uint16_t baseSeq, uint8_t runs) const
+  {
+    out[0] = MAGIC;
+    out[1] = flags;
+    out[2] = (uint8_t)(seq & 0xFF);
+    out[3] = (uint8_t)(seq >> 8);
+    out[4] = (uint8_t)(baseSeq & 0xFF);
+    out[5] = (uint8_t)(baseSeq >> 8);
+    out[6] = (uint8_t)BINS;
+    out[7] = runs;
+    return HEADER_BYTES;
+  }
+
+  static size_t writePixel(uint8_t *out, size_t pos, uint16_t pixel)
+  {
+    out[pos] = (uint8_t)(pixel & 0xFF);
+    out[pos + 1] = (uint8_t)(pixel >> 8);
+    return pos + 2;
+  }
+
+  size_t encodeKeyframe(uint8_t *out) const
+  {
+    size_t pos = writeHeader(out, FLAG_KEYFRAME, seq_, seq_, 0);
+    for (int i = 0; i < BINS; i++)
+      pos = writePixel(out, pos, current_[i]);
+    return pos;
+  }
+
+  /**
+   * @brief Encode changed runs against the previous capture
+   * @return Bytes written, or 0 if a keyframe would be smaller
+   */
+  size_t encodeDelta(uint8_t *out) const
+  {
+    size_t pos = HEADER_BYTES;
+    int runs = 0;
+    int i = 0;
+    while (i < BINS)
+    {
+      if (current_[i] == previous_[i])
+      {
+        i++;
+        continue;
+      }
+      int start = i;
+      while (i < BINS && current_[i] != previous_[i])
+        i++;
+      int length = i - start;
+
+      if (pos + 2 + length * 2 >= MAX_FRAME_BYTES || runs == 255)
+        return 0;
+      out[pos++] = (uint8_t)start;
+      out[pos++] = (uint8_t)length;
+      for (int j = start; j < start + length; j++)
+        pos = writePixel(out, pos, current_[j]);
+      runs++;
+    }
+    writeHeader(out, 0, seq_, (uint16_t)(seq_ - 1), (uint8_t)runs);
+    return pos;
+  }
+};
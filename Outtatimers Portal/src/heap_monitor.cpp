@@ -0,0 +1,103 @@
+/**
+ * @file heap_monitor.cpp
+ * @brief Implementation of heap and stack watermark tracking
+ */
+
+#include "heap_monitor.h"
+
+#ifndef UNIT_TEST
+#include <Arduino.h>
+#else
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#endif
+
+HeapMonitor::Stats HeapMonitor::stats_ = {0, 0, 0, 0, 0, 0, 0, 0};
+bool HeapMonitor::armed_ = false;
+size_t HeapMonitor::liveBytes_ = 0;
+size_t HeapMonitor::baselineBytes_ = 0;
+
+void HeapMonitor::begin()
+{
+  armed_ = false;
+  stats_ = {0, 0, 0, 0, 0, 0, 0, 0};
+#ifndef UNIT_TEST
+  stats_.heapFreeLow = UINT32_MAX;
+  stats_.stackFreeLow = UINT32_MAX;
+  baselineBytes_ = ESP.getFreeHeap(); // Free bytes: growth shows as a drop
+#else
+  baselineBytes_ = liveBytes_; // Bytes in use: growth shows as a rise
+#endif
+  sample();
+  armed_ = true;
+}
+
+void HeapMonitor::sample()
+{
+#ifndef UNIT_TEST
+  uint32_t free = ESP.getFreeHeap();
+  stats_.heapFree = free;
+  if (free < stats_.heapFreeLow)
+    stats_.heapFreeLow = free;
+  if (free < baselineBytes_ && baselineBytes_ - free > stats_.heapGrowthHigh)
+    stats_.heapGrowthHigh = baselineBytes_ - free;
+  stats_.maxFreeBlock = ESP.getMaxFreeBlockSize();
+  stats_.fragmentation = ESP.getHeapFragmentation();
+  if (stats_.fragmentation > stats_.fragmentationHigh)
+    stats_.fragmentationHigh = stats_.fragmentation;
+  uint32_t stackFree = ESP.getFreeContStack(); // Painted stack: already a high water mark
+  if (stackFree < stats_.stackFreeLow)
+    stats_.stackFreeLow = stackFree;
+#endif
+}
+
+void HeapMonitor::recordAllocation(size_t bytes)
+{
+  liveBytes_ += bytes;
+  if (!armed_)
+    return;
+  stats_.allocations++;
+  if (liveBytes_ > baselineBytes_ && liveBytes_ - baselineBytes_ > stats_.heapGrowthHigh)
+    stats_.heapGrowthHigh = (uint32_t)(liveBytes_ - baselineBytes_);
+}
+
+void HeapMonitor::recordFree(size_t bytes)
+{
+  liveBytes_ -= bytes;
+}
+
+#ifdef UNIT_TEST
+// Host allocation hook: every block carries its size in a header so
+// releases can be accounted as well
+namespace
+{
+  constexpr size_t HEADER_BYTES = alignof(std::max_align_t);
+
+  void *trackedAlloc(size_t bytes)
+  {
+    unsigned char *block = static_cast<unsigned char *>(std::malloc(bytes + HEADER_BYTES));
+    if (block == nullptr)
+      throw std::bad_alloc();
+    *reinterpret_cast<size_t *>(block) = bytes;
+    HeapMonitor::recordAllocation(bytes);
+    return block + HEADER_BYTES;
+  }
+
+  void trackedFree(void *p)
+  {
+    if (p == nullptr)
+      return;
+    unsigned char *block = static_cast<unsigned char *>(p) - HEADER_BYTES;
+    HeapMonitor::recordFree(*reinterpret_cast<size_t *>(block));
+    std::free(block);
+  }
+}
+
+void *operator new(size_t bytes) { return trackedAlloc(bytes); }
+void *operator new[](size_t bytes) { return trackedAlloc(bytes); }
+void operator delete(void *p) noexcept { trackedFree(p); }
+void operator delete[](void *p) noexcept { trackedFree(p); }
+void operator delete(void *p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void *p, size_t) noexcept { trackedFree(p); }
+#endif
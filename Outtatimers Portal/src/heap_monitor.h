@@ -0,0 +1,88 @@
+/**
+ * @file heap_monitor.h
+ * @brief Heap and stack watermark tracking
+ *
+ * After setup() the firmware's own code is meant to run without touching
+ * the heap, so hours of shows cannot fragment it into a reset. Only the
+ * web server's per-request Strings come and go, and are freed again once
+ * the request has been answered. HeapMonitor records how
+ * close the device got: free heap low water mark, fragmentation, largest
+ * free block and the stack high water mark.
+ *
+ * On the device the figures come from the ESP8266 heap statistics, sampled
+ * once per loop(). In host builds (UNIT_TEST) heap_monitor.cpp replaces the
+ * global operator new/delete, so every allocation is counted and tests can
+ * assert that a code path allocates nothing.
+ */
+
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @class HeapMonitor
+ * @brief Records heap and stack watermarks after setup()
+ *
+ * @example
+ * ```cpp
+ * void setup() { ...; HeapMonitor::begin(); }
+ * void loop()  { ...; HeapMonitor::sample(); }
+ * ```
+ */
+class HeapMonitor
+{
+public:
+  struct Stats
+  {
+    uint32_t heapFree;         ///< Free heap at the last sample
+    uint32_t heapFreeLow;      ///< Lowest free heap since begin() (low water mark)
+    uint32_t heapGrowthHigh;   ///< Most heap in use beyond the level at begin() (high water mark)
+    uint32_t maxFreeBlock;     ///< Largest allocatable block at the last sample
+    uint8_t fragmentation;     ///< Heap fragmentation at the last sample, percent
+    uint8_t fragmentationHigh; ///< Worst fragmentation since begin(), percent
+    uint32_t stackFreeLow;     ///< Least free stack seen (stack high water mark)
+    uint32_t allocations;      ///< Allocations since begin() (host builds only)
+  };
+
+  /**
+   * @brief Mark the end of setup(): take the baseline and reset watermarks
+   */
+  static void begin();
+
+  /**
+   * @brief Update the watermarks; call once per loop()
+   */
+  static void sample();
+
+  /**
+   * @brief Watermarks recorded since begin()
+   */
+  static const Stats &getStats() { return stats_; }
+
+  /**
+   * @brief Allocations since begin(); always 0 on the device
+   */
+  static uint32_t getAllocationsSinceSetup() { return stats_.allocations; }
+
+  /**
+   * @brief Record an allocation (called by the host operator new hook)
+   * @param bytes Size of the allocation
+   */
+  static void recordAllocation(size_t bytes);
+
+  /**
+   * @brief Record a release (called by the host operator delete hook)
+   * @param bytes Size of the released allocation
+   */
+  static void recordFree(size_t bytes);
+
+private:
+  static Stats stats_;
+  static bool armed_;
+  static size_t liveBytes_;
+  static size_t baselineBytes_;
+};
+
+#endif // HEAP_MONITOR_H
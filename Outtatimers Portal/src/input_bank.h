@@ -0,0 +1,153 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef UNIT_TEST
+#include <Arduino.h>
+#include <SPI.h>
+#endif
+
+/**
+ * @brief A group of digital inputs read in one operation
+ *
+ * Bit n of read() is input n. Banks let BankInputSource debounce many
+ * inputs per read instead of one digitalRead() per button.
+ */
+class IInputBank
+{
+public:
+  /**
+   * @brief Read all inputs of the bank
+   * @return Raw input bits (pin levels, not pressed states)
+   */
+  virtual uint32_t read() = 0;
+
+  /**
+   * @brief Number of valid bits in read()
+   */
+  virtual int getWidth() const = 0;
+
+  virtual ~IInputBank() {}
+};
+
+/**
+ * @brief Serial-in bus feeding a chain of parallel-in shift registers
+ *
+ * Kept separate from ShiftRegisterBank so the bit assembly can be tested
+ * on the host with a scripted bus.
+ */
+class IShiftInBus
+{
+public:
+  /**
+   * @brief Latch the parallel inputs and shift them out
+   * @param bytes Output, one byte per chip, nearest chip first
+   * @param count Number of chips in the chain
+   */
+  virtual void read(uint8_t *bytes, size_t count) = 0;
+
+  virtual ~IShiftInBus() {}
+};
+
+/**
+ * @brief Input bank on a chain of 74HC165 shift registers
+ *
+ * Up to four chips give 32 inputs for two data pins and a latch. The chip
+ * wired to the MCU is inputs 0-7 (its input A is input 0), the next chip
+ * in the chain inputs 8-15, and so on.
+ *
+ * @example
+ * ```cpp
+ * SpiShiftInBus bus(PortalConfig::Hardware::SHIFT_LATCH_PIN);
+ * ShiftRegisterBank bank(&bus, 2); // 16 inputs
+ * bus.begin();
+ * uint32_t levels = bank.read();
+ * ```
+ */
+class ShiftRegisterBank : public IInputBank
+{
+public:
+  static constexpr int MAX_CHIPS = 4;
+
+  /**
+   * @brief Construct a new ShiftRegisterBank
+   * @param bus Bus the chain is connected to (must remain valid)
+   * @param chips Number of chained chips (1-4)
+   */
+  ShiftRegisterBank(IShiftInBus *bus, int chips)
+      : bus_(bus), chips_(chips < 1 ? 1 : (chips > MAX_CHIPS ? MAX_CHIPS : chips)) {}
+
+  uint32_t read() override
+  {
+    uint8_t bytes[MAX_CHIPS];
+    bus_->read(bytes, (size_t)chips_);
+    uint32_t value = 0;
+    for (int i = 0; i < chips_; i++)
+      value |= (uint32_t)bytes[i] << (8 * i); // Input H is shifted out first (MSB)
+    return value;
+  }
+
+  int getWidth() const override { return chips_ * 8; }
+
+private:
+  IShiftInBus *bus_;
+  int chips_;
+};
+
+#ifndef UNIT_TEST
+
+/**
+ * @brief Input bank on the ESP8266 GPIO input register
+ *
+ * Reads GPIO0-15 with a single register load. Only the bits in the mask
+ * are reported; the rest read as 0.
+ */
+class GpioInputBank : public IInputBank
+{
+public:
+  explicit GpioInputBank(uint16_t mask) : mask_(mask) {}
+
+  uint32_t read() override { return GPI & mask_; }
+  int getWidth() const override { return 16; }
+
+private:
+  uint16_t mask_;
+};
+
+/**
+ * @brief 74HC165 chain on the hardware SPI port
+ *
+ * Serial data goes to MISO (GPIO12) and the clock to SCK (GPIO14); the
+ * chips' parallel-load pin is driven from a plain GPIO.
+ */
+class SpiShiftInBus : public IShiftInBus
+{
+public:
+  explicit SpiShiftInBus(int latchPin) : latchPin_(latchPin) {}
+
+  void begin()
+  {
+    pinMode(latchPin_, OUTPUT);
+    digitalWrite(latchPin_, HIGH);
+    SPI.begin();
+  }
+
+  void read(uint8_t *bytes, size_t count) override
+  {
+    // A low pulse on PL copies the inputs into the shift registers
+    digitalWrite(latchPin_, LOW);
+    delayMicroseconds(1);
+    digitalWrite(latchPin_, HIGH);
+
+    SPI.beginTransaction(SPISettings(1000000, MSBFIRST, SPI_MODE0));
+    for (size_t i = 0; i < count; i++)
+      bytes[i] = SPI.transfer(0);
+    SPI.endTransaction();
+  }
+
+private:
+  int latchPin_;
+};
+
+#endif
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "button_gesture.h"
 #include "config.h"
 #include "debounce.h"
-#include <functional>
+#include "latency_tracer.h"
+#include "priority_queue.h"
+#include "spsc_ring.h"
+#include <string.h>
 
 #ifndef UNIT_TEST
 #include <Arduino.h>
@@ -10,7 +14,10 @@
 extern "C" unsigned long millis();
 extern "C" int digitalRead(int pin);
 extern "C" void pinMode(int pin, int mode);
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
 constexpr int INPUT_PULLUP = 2;
+constexpr int CHANGE = 3;
+static inline int digitalPinToInterrupt(int pin) { return pin; }
 #endif
 
 /**
@@ -27,9 +34,12 @@ public:
    */
   enum class EventType
   {
-    Pressed,  ///< Input was activated (button pressed, command received)
-    Released, ///< Input was deactivated (button released)
-    LongPress ///< Input held for extended period
+    Pressed,   ///< Input was activated (button pressed, command received)
+    Released,  ///< Input was deactivated (button released)
+    LongPress, ///< Input held for extended period
+    Tap,       ///< Short press of a button with gestures
+    DoubleTap, ///< Two taps in quick succession
+    Hold       ///< Repeat while held after a long press
   };
 
   /**
@@ -41,6 +51,8 @@ public:
     EventType type;          ///< Type of event
     unsigned long timestamp; ///< When the event occurred
     const char *sourceName;  ///< Name of the input source (for debugging)
+    int16_t arg1 = 0;        ///< Command payload: value, hue min, mode
+    int16_t arg2 = 0;        ///< Command payload: hue max
   };
 
   virtual ~IInputSource() = default;
@@ -76,10 +88,36 @@ public:
  *
  * Handles physical buttons connected to GPIO pins with proper debouncing
  * and edge detection for reliable input processing.
+ *
+ * In Polling mode update() samples every pin, so a press is only seen when
+ * loop() gets around to it. In Interrupt mode a pin-change ISR timestamps
+ * every edge into a lock-free ring and update() debounces the recorded
+ * edges, so presses are neither missed nor mis-dated while loop() is busy
+ * in show() or handleClient().
+ *
+ * Buttons with a long-press or double-tap time set report gestures instead
+ * of raw presses: Tap with the button's inputId, LongPress and Hold with
+ * longPressId, DoubleTap with doubleTapId. Their Released events are still
+ * queued. A gesture whose ID is 0 is recognised but not reported.
+ *
+ * @example
+ * ```cpp
+ * ButtonInputSource buttons(configs, 3, ButtonInputSource::CaptureMode::Interrupt);
+ * buttons.begin(); // attaches the pin interrupts
+ * ```
  */
 class ButtonInputSource : public IInputSource
 {
 public:
+  /**
+   * @brief How button edges are detected
+   */
+  enum class CaptureMode
+  {
+    Polling,  ///< digitalRead() in every update()
+    Interrupt ///< Pin-change ISR records timestamped edges
+  };
+
   /**
    * @brief Button configuration
    */
@@ -90,15 +128,24 @@ public:
     bool activeLow;           ///< true if button is active low (default)
     unsigned long debounceMs; ///< Debounce interval in milliseconds
     const char *name;         ///< Human-readable name for debugging
+
+    // Gestures (optional, 0 = off)
+    unsigned long longPressMs = 0;  ///< Hold time for a long press
+    unsigned long doubleTapMs = 0;  ///< Window for a second tap (delays single taps)
+    unsigned long holdRepeatMs = 0; ///< Hold repeat interval after a long press
+    int longPressId = 0;            ///< Input ID for long press and hold repeats
+    int doubleTapId = 0;            ///< Input ID for double tap
   };
 
   /**
    * @brief Construct a new ButtonInputSource
    * @param buttons Array of button configurations
    * @param buttonCount Number of buttons in the array
+   * @param mode Edge detection mode (Interrupt needs begin())
    */
-  ButtonInputSource(const ButtonConfig *buttons, int buttonCount)
-      : buttons_(buttons), buttonCount_(buttonCount), eventQueueHead_(0), eventQueueTail_(0)
+  ButtonInputSource(const ButtonConfig *buttons, int buttonCount, CaptureMode mode = CaptureMode::Polling)
+      : buttons_(buttons), buttonCount_(buttonCount > MAX_BUTTONS ? MAX_BUTTONS : buttonCount), mode_(mode),
+        seenDrops_(0), droppedCount_(0), eventQueueHead_(0), eventQueueTail_(0)
   {
 
     // Initialize GPIO pins and debounce objects
@@ -106,12 +153,55 @@ public:
     {
       pinMode(buttons_[i].pin, INPUT_PULLUP);
       debouncers_[i] = Debounce(buttons_[i].debounceMs);
+      gestures_[i] = ButtonGesture(buttons_[i].longPressMs, buttons_[i].doubleTapMs, buttons_[i].holdRepeatMs);
       lastStates_[i] = buttons_[i].activeLow ? static_cast<int>(PortalConfig::PinState::High) : static_cast<int>(PortalConfig::PinState::Low);
     }
   }
 
+  /**
+   * @brief Attach the pin interrupts (Interrupt mode)
+   *
+   * Call on the final object, after any copy or assignment, since the ISRs
+   * keep a pointer to it.
+   */
+  void begin()
+  {
+    if (mode_ != CaptureMode::Interrupt)
+      return;
+    for (int i = 0; i < buttonCount_; i++)
+    {
+      edgeDebouncers_[i] = EdgeDebounce(buttons_[i].debounceMs, digitalRead(buttons_[i].pin));
+      pins_[i] = {this, (uint8_t)i, (uint8_t)buttons_[i].pin};
+      attachInterruptArg(digitalPinToInterrupt(buttons_[i].pin), onPinChange, &pins_[i], CHANGE);
+    }
+  }
+
+  /**
+   * @brief Record one edge; called from the pin ISR
+   * @param button Button index
+   * @param level Pin level after the edge
+   * @param time Edge timestamp in milliseconds
+   */
+  void IRAM_ATTR captureEdge(int button, int level, unsigned long time)
+  {
+    edges_.push({(uint8_t)button, (uint8_t)level, time});
+  }
+
+  /**
+   * @brief Edges lost because the ring was full (each loss forces a resync)
+   */
+  uint32_t getDroppedEdgeCount() const { return edges_.getDroppedCount(); }
+
+  /**
+   * @brief Events lost because the event queue was full
+   */
+  unsigned long getDroppedCount() const { return droppedCount_; }
+
   bool update(unsigned long currentTime) override
   {
+    if (mode_ == CaptureMode::Interrupt)
+      return updateFromEdges(currentTime) | updateGestures(currentTime);
+
     bool hasNewEvents = false;
 
     for (int i = 0; i < buttonCount_; i++)
@@ -130,13 +220,8 @@ public:
         // Determine event type based on active low/high configuration
         bool isPressed = config.activeLow ? (currentState == static_cast<int>(PortalConfig::PinState::Low)) : (currentState == static_cast<int>(PortalConfig::PinState::High));
 
-        EventType eventType = isPressed ? EventType::Pressed : EventType::Released;
-
         // Queue the event
-        queueEvent({.inputId = config.inputId,
-                    .type = eventType,
-                    .timestamp = currentTime,
-                    .sourceName = config.name});
+        queueButton(i, isPressed, currentTime);
 
         hasNewEvents = true;
       }
@@ -144,7 +229,7 @@ public:
       lastStates_[i] = currentState;
     }
 
-    return hasNewEvents;
+    return updateGestures(currentTime) | hasNewEvents;
   }
 
   bool hasEvents() const override
@@ -173,11 +258,41 @@ public:
 private:
   static constexpr int MAX_BUTTONS = 8;
   static constexpr int MAX_EVENTS = 16;
+  static constexpr size_t EDGE_RING_SIZE = 64; // ~20 bouncy presses between two updates
+
+  /**
+   * @brief Edge recorded by the ISR
+   */
+  struct Edge
+  {
+    uint8_t button;
+    uint8_t level;
+    unsigned long time;
+  };
+
+  /**
+   * @brief ISR argument identifying a button
+   */
+  struct PinSlot
+  {
+    ButtonInputSource *owner;
+    uint8_t index;
+    uint8_t pin;
+  };
 
   const ButtonConfig *buttons_;
   int buttonCount_;
+  CaptureMode mode_;
   Debounce debouncers_[MAX_BUTTONS];
   int lastStates_[MAX_BUTTONS];
+  ButtonGesture gestures_[MAX_BUTTONS];
+
+  // Interrupt mode
+  EdgeDebounce edgeDebouncers_[MAX_BUTTONS];
+  PinSlot pins_[MAX_BUTTONS];
+  SpscRing<Edge, EDGE_RING_SIZE> edges_;
+  uint32_t seenDrops_;
+  unsigned long droppedCount_;
 
   // Event queue for handling multiple rapid events
   InputEvent eventQueue_[MAX_EVENTS];
@@ -187,12 +302,144 @@ private:
   void queueEvent(const InputEvent &event)
   {
     int nextTail = (eventQueueTail_ + 1) % MAX_EVENTS;
-    if (nextTail != eventQueueHead_)
-    { // Don't overflow the queue
-      eventQueue_[eventQueueTail_] = event;
-      eventQueueTail_ = nextTail;
+    if (nextTail == eventQueueHead_)
+    {
+      droppedCount_++;
+      return;
     }
-    // If queue is full, oldest events are dropped (could add logging here)
+    eventQueue_[eventQueueTail_] = event;
+    eventQueueTail_ = nextTail;
+  }
+
+  static void IRAM_ATTR onPinChange(void *arg)
+  {
+    PinSlot *slot = static_cast<PinSlot *>(arg);
+    slot->owner->captureEdge(slot->index, digitalRead(slot->pin), millis());
+  }
+
+  /**
+   * @brief Debounce the edges recorded since the last update
+   * @param currentTime Current timestamp in milliseconds
+   * @return true if events were queued
+   */
+  bool updateFromEdges(unsigned long currentTime)
+  {
+    bool hasNewEvents = false;
+    Edge edge;
+    while (edges_.pop(edge))
+    {
+      if (edge.button < buttonCount_ && edgeDebouncers_[edge.button].edge(edge.level, edge.time))
+        hasNewEvents |= queueChange(edge.button);
+    }
+
+    // Edges were lost: the recorded levels may be stale, so resync with the pins
+    uint32_t drops = edges_.getDroppedCount();
+    if (drops != seenDrops_)
+    {
+      seenDrops_ = drops;
+      for (int i = 0; i < buttonCount_; i++)
+      {
+        if (edgeDebouncers_[i].edge(digitalRead(buttons_[i].pin), currentTime))
+          hasNewEvents |= queueChange(i);
+      }
+    }
+
+    for (int i = 0; i < buttonCount_; i++)
+    {
+      if (edgeDebouncers_[i].poll(currentTime))
+        hasNewEvents |= queueChange(i);
+    }
+    return hasNewEvents;
+  }
+
+  /**
+   * @brief Queue the accepted change of a button, dated to its first edge
+   */
+  bool queueChange(int i)
+  {
+    const ButtonConfig &config = buttons_[i];
+    int state = edgeDebouncers_[i].getState();
+    lastStates_[i] = state;
+    bool isPressed = config.activeLow ? (state == static_cast<int>(PortalConfig::PinState::Low)) : (state == static_cast<int>(PortalConfig::PinState::High));
+    queueButton(i, isPressed, edgeDebouncers_[i].getChangeTime());
+    return true;
+  }
+
+  /**
+   * @brief Queue a debounced press or release, or feed it to the gestures
+   */
+  void queueButton(int i, bool isPressed, unsigned long time)
+  {
+    const ButtonConfig &config = buttons_[i];
+    if (gestures_[i].isEnabled())
+    {
+      if (isPressed)
+      {
+        gestures_[i].press(time);
+        queueGestures(i, time);
+        return;
+      }
+      gestures_[i].release(time);
+      queueGestures(i, time);
+    }
+    queueEvent({.inputId = config.inputId,
+                .type = isPressed ? EventType::Pressed : EventType::Released,
+                .timestamp = time,
+                .sourceName = config.name});
+  }
+
+  /**
+   * @brief Queue the gestures of one button that are due
+   * @return true if events were queued
+   */
+  bool queueGestures(int i, unsigned long now)
+  {
+    const ButtonConfig &config = buttons_[i];
+    bool queued = false;
+    ButtonGesture::Type gesture;
+    unsigned long time;
+    while (gestures_[i].tick(now, gesture, time))
+    {
+      int inputId = config.inputId;
+      EventType type = EventType::Tap;
+      switch (gesture)
+      {
+      case ButtonGesture::Type::DoubleTap:
+        inputId = config.doubleTapId;
+        type = EventType::DoubleTap;
+        break;
+      case ButtonGesture::Type::LongPress:
+        inputId = config.longPressId;
+        type = EventType::LongPress;
+        break;
+      case ButtonGesture::Type::Hold:
+        inputId = config.longPressId;
+        type = EventType::Hold;
+        break;
+      default:
+        break;
+      }
+      if (inputId == 0)
+        continue;
+      queueEvent({.inputId = inputId, .type = type, .timestamp = time, .sourceName = config.name});
+      queued = true;
+    }
+    return queued;
+  }
+
+  /**
+   * @brief Queue timed gestures (long press, hold, tap after the double-tap window)
+   * @return true if events were queued
+   */
+  bool updateGestures(unsigned long currentTime)
+  {
+    bool hasNewEvents = false;
+    for (int i = 0; i < buttonCount_; i++)
+    {
+      if (gestures_[i].isEnabled())
+        hasNewEvents |= queueGestures(i, currentTime);
+    }
+    return hasNewEvents;
   }
 };
 
@@ -202,6 +449,35 @@ private:
  * This class manages different input sources (buttons, WiFi, serial, etc.)
  * and provides a unified interface for handling input events with callbacks.
  * Designed for easy extension with new input sources.
+ *
+ * Commands are dispatched through a constant table of plain function
+ * pointers indexed by command, so dispatch is one bounds check and one
+ * indirect call, with no heap or type erasure. Input IDs that are not a
+ * command, or commands without a handler, are rejected and counted rather
+ * than mapped to a default.
+ *
+ * Each update() first gathers the events of all sources into one queue,
+ * taking one event per source in turn so a burst from one source (a flood
+ * of web requests) cannot crowd out a button press, then dispatches them
+ * by priority: show cues (toggle, malfunction, fade out) first, then mode
+ * and dimming, then parameters. Within a priority events keep their order.
+ * If more commands arrive in one update than the queue holds, the least
+ * urgent, newest ones are dropped and counted.
+ *
+ * Parameter commands (SetSpeed, SetBrightness, SetHue, SetMode) carry their
+ * values in the event's arg1/arg2. They are coalesced: only the latest value
+ * of each is kept and applied after the other commands of the update.
+ * Effects read settings from a snapshot at the start of each frame, so a
+ * burst of fader moves lands on the next frame boundary as one change. Two
+ * toggles from the same source in one update cancel out and are both
+ * dropped (logged on the console).
+ *
+ * @example
+ * ```cpp
+ * static const InputManager::CommandHandler commandTable[] = {onToggle, onMalfunction, onFadeOut, onCycleMode, onDimStep};
+ * static_assert(sizeof(commandTable) / sizeof(commandTable[0]) == InputManager::COMMAND_COUNT, "One handler per command");
+ * inputManager.setCommandTable(commandTable);
+ * ```
  */
 class InputManager
 {
@@ -217,34 +493,76 @@ public:
     TogglePortal = 1,       ///< Start/stop portal effect
     TriggerMalfunction = 2, ///< Trigger malfunction effect
     FadeOut = 3,            ///< Fade out current effect
-                            // Future commands can be added here
-                            // SetBrightness = 4,
-                            // ChangeColor = 5,
-                            // etc.
+    CycleMode = 4,          ///< Switch to the next portal mode
+    DimStep = 5,            ///< Step max brightness down to DIM_MIN, then back up to full
+    SetSpeed = 6,           ///< Set rotation speed to arg1
+    SetBrightness = 7,      ///< Set max brightness to arg1
+    SetHue = 8,             ///< Set hue range to arg1..arg2
+    SetMode = 9,            ///< Set portal mode to arg1
+                            // Future commands can be added here (and to COMMAND_COUNT)
   };
 
   /**
-   * @brief Callback function type for input events
+   * @brief Number of commands; command values run from 1 to COMMAND_COUNT
+   */
+  static constexpr int COMMAND_COUNT = static_cast<int>(Command::SetMode);
+
+  /**
+   * @brief Command handler
    * @param command The logical command being executed
-   * @param source Name of the input source that triggered the command
+   * @param event Event that triggered it (source name and payload)
    */
-  using InputCallback = std::function<void(Command command, const char *source)>;
+  using CommandHandler = void (*)(Command command, const IInputSource::InputEvent &event);
 
   /**
    * @brief Construct a new InputManager
    */
-  InputManager() : callbackSet_(false) {}
+  InputManager() : table_(nullptr), callback_(nullptr), tracer_(nullptr), rejectedCount_(0), coalescedCount_(0),
+                   pendingMask_(0) {}
 
   /**
-   * @brief Set the callback function for input events
+   * @brief Dispatch each command to its own handler
+   * @param table Handlers indexed by command value - 1, nullptr to reject (must remain valid)
+   */
+  void setCommandTable(const CommandHandler (&table)[COMMAND_COUNT])
+  {
+    table_ = table;
+  }
+
+  /**
+   * @brief Dispatch every command to one handler (used when no table is set)
    * @param callback Function to call when input events occur
    */
-  void setInputCallback(InputCallback callback)
+  void setInputCallback(CommandHandler callback)
   {
     callback_ = callback;
-    callbackSet_ = true;
   }
 
+  /**
+   * @brief Stamp dispatch and effect state change of every command
+   * @param tracer Latency tracer, nullptr to stop tracing (must remain valid)
+   */
+  void setTracer(LatencyTracer *tracer)
+  {
+    tracer_ = tracer;
+  }
+
+  /**
+   * @brief Input events rejected because they named no command or no handler
+   */
+  unsigned long getRejectedCount() const { return rejectedCount_; }
+
+  /**
+   * @brief Events merged away: parameter updates superseded by a newer value
+   * and toggles cancelled by another toggle
+   */
+  unsigned long getCoalescedCount() const { return coalescedCount_; }
+
+  /**
+   * @brief Commands dropped because more arrived in one update than the queue holds
+   */
+  uint32_t getDroppedCount() const { return queue_.getDroppedCount(); }
+
   /**
    * @brief Add an input source to the manager
    * @param source Pointer to input source (must remain valid)
@@ -271,26 +589,25 @@ public:
 
     // Process events from all sources
     processEvents();
+    applyPending();
   }
 
   /**
-   * @brief Map input ID to logical command
+   * @brief Check whether a command sets a parameter (and may be coalesced)
+   */
+  static bool isParameterCommand(Command command)
+  {
+    return command >= Command::SetSpeed && command <= Command::SetMode;
+  }
+
+  /**
+   * @brief Check whether an input ID corresponds to a known command
    * @param inputId Raw input identifier
-   * @return Corresponding logical command
+   * @return true if the ID maps to a Command value
    */
-  static Command mapInputToCommand(int inputId)
+  static bool isValidCommand(int inputId)
   {
-    switch (inputId)
-    {
-    case 1:
-      return Command::TogglePortal;
-    case 2:
-      return Command::TriggerMalfunction;
-    case 3:
-      return Command::FadeOut;
-    default:
-      return Command::TogglePortal; // Default fallback
-    }
+    return inputId >= 1 && inputId <= COMMAND_COUNT;
   }
 
   /**
@@ -308,39 +625,139 @@ public:
       return "TriggerMalfunction";
     case Command::FadeOut:
       return "FadeOut";
+    case Command::CycleMode:
+      return "CycleMode";
+    case Command::DimStep:
+      return "DimStep";
+    case Command::SetSpeed:
+      return "SetSpeed";
+    case Command::SetBrightness:
+      return "SetBrightness";
+    case Command::SetHue:
+      return "SetHue";
+    case Command::SetMode:
+      return "SetMode";
     default:
       return "Unknown";
     }
   }
 
 private:
-  static constexpr int MAX_SOURCES = 4;
+  static constexpr int MAX_SOURCES = 8;
+  static constexpr int QUEUE_SIZE = 16;
 
   IInputSource *sources_[MAX_SOURCES];
   int sourceCount_ = 0;
-  InputCallback callback_;
-  bool callbackSet_;
+  const CommandHandler *table_;
+  CommandHandler callback_;
+  LatencyTracer *tracer_;
+  unsigned long rejectedCount_;
+  unsigned long coalescedCount_;
+  uint32_t pendingMask_;                             ///< Bit n set = pending_[n] holds a value
+  IInputSource::InputEvent pending_[COMMAND_COUNT]; ///< Latest parameter event per command
+  PriorityQueue<IInputSource::InputEvent, QUEUE_SIZE> queue_;
 
   void processEvents()
   {
-    if (!callbackSet_)
+    if (!table_ && !callback_)
       return;
 
-    for (int i = 0; i < sourceCount_; i++)
+    // One event per source per round, so no source can starve the others
+    bool gathered = true;
+    while (gathered)
     {
-      IInputSource *source = sources_[i];
+      gathered = false;
+      for (int i = 0; i < sourceCount_; i++)
+      {
+        if (!sources_[i]->hasEvents())
+          continue;
+        gathered = true;
+        IInputSource::InputEvent event = sources_[i]->getNextEvent();
+
+        // Presses and gestures trigger commands; releases are ignored
+        if (event.type != IInputSource::EventType::Released)
+          enqueue(event);
+      }
+    }
 
-      while (source->hasEvents())
+    IInputSource::InputEvent event;
+    while (queue_.pop(event))
+      run(static_cast<Command>(event.inputId), event);
+  }
+
+  /**
+   * @brief Dispatch order of a non-parameter command, lower first
+   */
+  static uint8_t priorityOf(Command command)
+  {
+    return command <= Command::FadeOut ? 0 : 1;
+  }
+
+  CommandHandler handlerFor(int inputId) const
+  {
+    return table_ ? table_[inputId - 1] : callback_;
+  }
+
+  void enqueue(const IInputSource::InputEvent &event)
+  {
+    if (!isValidCommand(event.inputId) || !handlerFor(event.inputId))
+    {
+      rejectedCount_++;
+      return;
+    }
+    Command command = static_cast<Command>(event.inputId);
+    uint32_t bit = 1u << (event.inputId - 1);
+    if (isParameterCommand(command))
+    {
+      // Keep only the newest value; it is applied with the other pending ones
+      if (pendingMask_ & bit)
+        coalescedCount_++;
+      pending_[event.inputId - 1] = event;
+      pendingMask_ |= bit;
+      return;
+    }
+    if (command == Command::TogglePortal)
+    {
+      // A double press of one button cancels out; toggles from different
+      // sources (button and web page) both run
+      int queued = queue_.findLast([&event](const IInputSource::InputEvent &other)
+                                   { return other.inputId == static_cast<int>(Command::TogglePortal) &&
+                                            strcmp(other.sourceName, event.sourceName) == 0; });
+      if (queued >= 0)
       {
-        IInputSource::InputEvent event = source->getNextEvent();
-
-        // Only process press events (ignore releases for now)
-        if (event.type == IInputSource::EventType::Pressed)
-        {
-          Command command = mapInputToCommand(event.inputId);
-          callback_(command, event.sourceName);
-        }
+        queue_.removeAt(queued);
+        coalescedCount_ += 2;
+#ifndef UNIT_TEST
+        Serial.printf("Input from %s: TogglePortal twice in one update, both cancelled\n", event.sourceName);
+#endif
+        return;
       }
     }
+    queue_.push(event, priorityOf(command));
+  }
+
+  /**
+   * @brief Run the handler of a command, stamped for the latency tracer
+   */
+  void run(Command command, const IInputSource::InputEvent &event)
+  {
+    if (tracer_)
+      tracer_->dispatched(event.timestamp);
+    handlerFor(static_cast<int>(command))(command, event);
+    if (tracer_)
+      tracer_->applied();
+  }
+
+  /**
+   * @brief Apply the coalesced parameter commands, in command order
+   */
+  void applyPending()
+  {
+    while (pendingMask_)
+    {
+      int index = __builtin_ctz(pendingMask_);
+      pendingMask_ &= pendingMask_ - 1;
+      run(static_cast<Command>(index + 1), pending_[index]);
+    }
   }
 };
\ No newline at end of file
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "response_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef UNIT_TEST
+extern "C" unsigned long millis();
+extern "C" unsigned long micros();
+#else
+#include <Arduino.h>
+#endif
+
+/**
+ * @brief Fixed-bucket latency histogram in microseconds
+ *
+ * Bucket edges are spaced roughly logarithmically from 250 us to 1 s, so
+ * percentiles are accurate to about a third of their value with no
+ * allocation and a constant footprint of about 100 bytes. A percentile reports the
+ * upper edge of the bucket it falls into, i.e. it never understates.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr int BUCKETS = 24;
+
+  LatencyHistogram() { reset(); }
+
+  void reset()
+  {
+    for (int i = 0; i < BUCKETS; i++)
+      counts_[i] = 0;
+    count_ = 0;
+    max_ = 0;
+  }
+
+  /**
+   * @brief Record one latency
+   * @param us Latency in microseconds
+   */
+  void record(uint32_t us)
+  {
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && us > EDGES[bucket])
+      bucket++;
+    counts_[bucket]++;
+    count_++;
+    if (us > max_)
+      max_ = us;
+  }
+
+  /**
+   * @brief Latency below which the given share of samples fall
+   * @param permille Share in 1/1000 (500 = median, 990 = p99)
+   * @return Upper bucket edge in microseconds (the maximum for the last bucket), 0 if empty
+   */
+  uint32_t percentile(uint32_t permille) const
+  {
+    if (count_ == 0)
+      return 0;
+    uint32_t rank = (uint32_t)(((uint64_t)count_ * permille + 999) / 1000);
+    if (rank == 0)
+      rank = 1;
+    uint32_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+      seen += counts_[i];
+      if (seen >= rank)
+        return (i == BUCKETS - 1 || EDGES[i] > max_) ? max_ : EDGES[i];
+    }
+    return max_;
+  }
+
+  uint32_t getCount() const { return count_; }
+  uint32_t getMax() const { return max_; }
+
+private:
+  static constexpr uint32_t EDGES[BUCKETS - 1] = {
+      250, 500, 750, 1000, 1500, 2000, 3000, 4000, 5000, 7500, 10000, 15000,
+      20000, 30000, 40000, 50000, 75000, 100000, 150000, 200000, 300000, 500000, 1000000};
+
+  uint32_t counts_[BUCKETS];
+  uint32_t count_;
+  uint32_t max_;
+};
+
+/**
+ * @brief End-to-end input latency tracing, from capture to photons
+ *
+ * Every dispatched command is followed through four stamps:
+ * - capture: the event timestamp set by its input source
+ * - dispatch: InputManager hands it to its handler
+ * - apply: the handler returned, i.e. the effect state has changed
+ * - show: the first show() after dispatch has pushed a frame to the strip
+ *
+ * Each stage's latency from capture goes into its own histogram. Capture
+ * stamps are in milliseconds (event timestamps), later stamps in
+ * microseconds, so latencies carry up to 1 ms of capture jitter.
+ *
+ * @example
+ * ```cpp
+ * LatencyTracer tracer;
+ * inputManager.setTracer(&tracer);                 // dispatch and apply stamps
+ * driver.setShowHook([]() { tracer.shown(); });    // show stamps
+ * tracer.appendJson(response);                     // p50/p90/p99 per stage
+ * ```
+ */
+class LatencyTracer
+{
+public:
+  enum class Stage
+  {
+    Dispatch, ///< Capture to dispatch
+    Apply,    ///< Capture to effect state change
+    Show,     ///< Capture to the end of the first show()
+    COUNT
+  };
+
+  static constexpr int MAX_PENDING = 8;
+
+  using ClockFn = unsigned long (*)();
+
+  /**
+   * @brief Construct a new LatencyTracer
+   * @param msClock Clock of the event timestamps
+   * @param usClock Microsecond clock for the later stamps
+   */
+  explicit LatencyTracer(ClockFn msClock = millis, ClockFn usClock = micros)
+      : msClock_(msClock), usClock_(usClock), pendingCount_(0), lastBase_(0), droppedCount_(0) {}
+
+  /**
+   * @brief Stamp a command as it is handed to its handler
+   * @param captureMs Event timestamp (millis() domain)
+   */
+  void dispatched(unsigned long captureMs)
+  {
+    unsigned long nowMs = msClock_();
+    uint32_t nowUs = (uint32_t)usClock_();
+    // Capture time moved to the micros() domain
+    uint32_t sinceCaptureUs = (long)(nowMs - captureMs) > 0 ? (uint32_t)(nowMs - captureMs) * 1000u : 0;
+    lastBase_ = nowUs - sinceCaptureUs;
+    histograms_[(int)Stage::Dispatch].record(sinceCaptureUs);
+    if (pendingCount_ < MAX_PENDING)
+      pending_[pendingCount_++] = lastBase_;
+    else
+      droppedCount_++;
+  }
+
+  /**
+   * @brief Stamp the effect state change of the last dispatched command
+   */
+  void applied()
+  {
+    histograms_[(int)Stage::Apply].record((uint32_t)usClock_() - lastBase_);
+  }
+
+  /**
+   * @brief Stamp a completed show(): closes every command dispatched before it
+   */
+  void shown()
+  {
+    if (pendingCount_ == 0)
+      return;
+    uint32_t nowUs = (uint32_t)usClock_();
+    for (int i = 0; i < pendingCount_; i++)
+      histograms_[(int)Stage::Show].record(nowUs - pending_[i]);
+    pendingCount_ = 0;
+  }
+
+  const LatencyHistogram &getHistogram(Stage stage) const { return histograms_[(int)stage]; }
+
+  /**
+   * @brief Commands not traced to show() because too many were waiting for one
+   */
+  uint32_t getDroppedCount() const { return droppedCount_; }
+
+  void reset()
+  {
+    for (LatencyHistogram &histogram : histograms_)
+      histogram.reset();
+    pendingCount_ = 0;
+    droppedCount_ = 0;
+  }
+
+  /**
+   * @brief Append count, p50, p90, p99 and max per stage as JSON (microseconds)
+   */
+  template <size_t N>
+  void appendJson(ResponseBuffer<N> &out) const
+  {
+    static const char *const NAMES[(int)Stage::COUNT] = {"dispatch", "apply", "show"};
+    out.append("{");
+    for (int i = 0; i < (int)Stage::COUNT; i++)
+    {
+      const LatencyHistogram &h = histograms_[i];
+      out.appendf("%s\"%s\":{\"count\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu}", i > 0 ? "," : "",
+                  NAMES[i], (unsigned long)h.getCount(), (unsigned long)h.percentile(500),
+                  (unsigned long)h.percentile(900), (unsigned long)h.percentile(990), (unsigned long)h.getMax());
+    }
+    out.appendf(",\"dropped\":%lu}", (unsigned long)droppedCount_);
+  }
+
+private:
+  ClockFn msClock_;
+  ClockFn usClock_;
+  LatencyHistogram histograms_[(int)Stage::COUNT];
+  uint32_t pending_[MAX_PENDING]; ///< Capture times (micros() domain) awaiting a show
+  int pendingCount_;
+  uint32_t lastBase_;
+  uint32_t droppedCount_;
+};
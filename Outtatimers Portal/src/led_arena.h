@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief One-shot bump allocator for all per-LED buffers
+ *
+ * The LED count is only known once the saved settings are loaded, so the
+ * driver and effect buffers cannot be sized at compile time. Instead one
+ * block is allocated in setup(), sized for the actual count, and every
+ * buffer is carved from it. Nothing is ever freed, so the heap is not
+ * touched again after boot and cannot fragment around the LED buffers.
+ *
+ * @example
+ * ```cpp
+ * LedArena arena;
+ * arena.begin(Driver::arenaBytes(count) + Portal::arenaBytes(count));
+ * CRGB *leds = arena.allocate<CRGB>(count);
+ * ```
+ */
+class LedArena
+{
+public:
+  static constexpr size_t ALIGNMENT = 8;
+
+  LedArena() : base_(nullptr), capacity_(0), used_(0), failedCount_(0) {}
+  ~LedArena() { free(base_); } // Only host tools ever destroy an arena
+  LedArena(const LedArena &) = delete;
+  LedArena &operator=(const LedArena &) = delete;
+
+  /**
+   * @brief Allocate the arena; call once from setup()
+   * @param bytes Capacity, normally the sum of the users' arenaBytes()
+   * @return true if the block was allocated
+   */
+  bool begin(size_t bytes)
+  {
+    if (base_ != nullptr)
+      return false;
+    base_ = static_cast<uint8_t *>(malloc(bytes));
+    if (base_ == nullptr)
+      return false;
+    capacity_ = bytes;
+    used_ = 0;
+    return true;
+  }
+
+  /**
+   * @brief Carve an array from the arena
+   * @param count Number of elements
+   * @return Pointer to uninitialized storage, or nullptr if the arena is exhausted
+   */
+  template <typename T>
+  T *allocate(size_t count)
+  {
+    static_assert(alignof(T) <= ALIGNMENT, "Type needs a stricter alignment than the arena provides");
+    size_t bytes = footprint(sizeof(T) * count);
+    if (base_ == nullptr || bytes > capacity_ - used_)
+    {
+      failedCount_++;
+      return nullptr;
+    }
+    T *p = reinterpret_cast<T *>(base_ + used_);
+    used_ += bytes;
+    return p;
+  }
+
+  /**
+   * @brief Arena bytes taken by an allocation of the given size
+   */
+  static constexpr size_t footprint(size_t bytes)
+  {
+    return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  }
+
+  size_t getCapacity() const { return capacity_; }
+  size_t getUsed() const { return used_; }
+  size_t getFree() const { return capacity_ - used_; }
+  unsigned long getFailedCount() const { return failedCount_; }
+
+private:
+  uint8_t *base_;
+  size_t capacity_;
+  size_t used_;
+  unsigned long failedCount_;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include "led_arena.h"
 
 // When building unit tests on the host, FastLED is not available. Provide a
 // minimal CRGB type and avoid including FastLED.h. For device builds, include
@@ -19,6 +20,7 @@ public:
   virtual void clear() = 0;
   virtual void show() = 0;
   virtual CRGB *getBuffer() = 0;
+  virtual int getLength() const = 0;
   virtual ~ILEDDriver() {}
 };
 
@@ -37,40 +39,78 @@ public:
   virtual void clear() = 0;
   virtual void show() = 0;
   virtual CRGB *getBuffer() = 0;
+  virtual int getLength() const = 0;
   virtual ~ILEDDriver() {}
 };
 
-// FastLED-backed driver owning a static buffer of size N
-template <int N>
+// FastLED-backed driver for up to MAX_N LEDs on data pin PIN. The LED count
+// is set at runtime and the buffer is carved from the LED arena in begin().
+// Each instance registers a separate controller and shows only its own
+// strip, so several rings (of different lengths) can run side by side.
+template <int MAX_N, uint8_t PIN = PortalConfig::Hardware::LED_PIN>
 class FastLEDDriver : public ILEDDriver
 {
 public:
-  FastLEDDriver(uint8_t pin = PortalConfig::Hardware::LED_PIN) : _pin(pin) {}
+  static_assert(MAX_N > 0 && MAX_N <= PortalConfig::Hardware::MAX_LEDS_PER_RING, "LED count outside the supported range");
+
+  explicit FastLEDDriver(LedArena *arena)
+      : _arena(arena), _controller(nullptr), _brightness(255), _length(MAX_N), buffer(nullptr), _showHook(nullptr) {}
+
+  /**
+   * @brief Set the LED count; call before begin()
+   * @param numLeds LED count, clamped to 1..MAX_N
+   */
+  void setLength(int numLeds) { _length = constrain(numLeds, 1, MAX_N); }
+
+  /**
+   * @brief Arena bytes needed for a strip of the given length
+   */
+  static constexpr size_t arenaBytes(int numLeds) { return LedArena::footprint(sizeof(CRGB) * numLeds); }
+
   void begin() override
   {
-    FastLED.addLeds<WS2812B, PortalConfig::Hardware::LED_PIN, COLOR_ORDER>(buffer, N);
-    FastLED.setBrightness(255);
-    FastLED.clear();
-    FastLED.show();
+    buffer = _arena->allocate<CRGB>(_length);
+    if (buffer == nullptr)
+    {
+      _length = 0; // Arena exhausted: stay dark rather than write anywhere
+      return;
+    }
+    _controller = &FastLED.addLeds<WS2812B, PIN, COLOR_ORDER>(buffer, _length);
+    clear();
+    show();
   }
-  void setBrightness(uint8_t b) override { FastLED.setBrightness(b); }
+  void setBrightness(uint8_t b) override { _brightness = b; }
   void setPixel(int idx, const CRGB &color) override
   {
-    if (idx >= 0 && idx < N)
+    if (idx >= 0 && idx < _length)
       buffer[idx] = color;
   }
-  void fillSolid(const CRGB &color) override { fill_solid(buffer, N, color); }
-  void clear() override { FastLED.clear(); }
-  void show() override { FastLED.show(); }
+  void fillSolid(const CRGB &color) override { fill_solid(buffer, _length, color); }
+  void clear() override { fill_solid(buffer, _length, CRGB::Black); }
+  void show() override
+  {
+    if (!_controller)
+      return;
+    _controller->showLeds(_brightness);
+    if (_showHook)
+      _showHook();
+  }
+
+  /**
+   * @brief Call a function after every frame has been pushed to the strip
+   * @param hook Function to call, nullptr for none
+   */
+  void setShowHook(void (*hook)()) { _showHook = hook; }
   CRGB *getBuffer() override { return buffer; }
+  int getLength() const override { return _length; }
 
 private:
-  uint8_t _pin;
-  static CRGB buffer[N];
+  LedArena *_arena;
+  CLEDController *_controller;
+  uint8_t _brightness;
+  int _length;
+  CRGB *buffer;
+  void (*_showHook)();
 };
 
-// Define static storage
-template <int N>
-CRGB FastLEDDriver<N>::buffer[N];
-
 #endif
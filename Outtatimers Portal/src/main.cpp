@@ -6,28 +6,99 @@
 #include "config.h"
 #include "startup_sequence.h"
 #include "input_manager.h"
+#include "portal_commands.h"
 #include "status_led.h"
 #include "config_manager.h"
+#include "config_store.h"
+#include "file_store.h"
+#include "preset_store.h"
+#include "led_arena.h"
+#include "heap_monitor.h"
+#include "latency_tracer.h"
+#if ENABLE_SHIFT_INPUTS
+#include "bank_input_source.h"
+#endif
+#if ENABLE_SERIAL_COMMANDS
+#include "serial_command_source.h"
+#endif
 #if ENABLE_WIFI_CONTROL
 #include "wifi_input_source.h"
+#include "frame_preview.h"
+#include "dmx_input_source.h"
+#include "udp_command_source.h"
+#include "cue_timeline.h"
+#include "clock_sync.h"
 #endif
 
 // LED Strip Configuration - using config constants
 #define LED_TYPE WS2812B
 
-// Static driver and portal effect using template-based class
-static FastLEDDriver<PortalConfig::Hardware::NUM_LEDS> fastDriver(PortalConfig::Hardware::LED_PIN);
-static PortalEffectTemplate<PortalConfig::Hardware::NUM_LEDS, PortalConfig::Effects::GRADIENT_STEP_DEFAULT, PortalConfig::Effects::GRADIENT_MOVE_DEFAULT> portal(&fastDriver);
-// Application state
-bool portalRunning = false;
-
+// Static driver and portal effect using template-based class. Both are sized
+// for MAX_NUM_LEDS; the configured count is carved from the arena at boot.
+typedef FastLEDDriver<PortalConfig::Hardware::MAX_NUM_LEDS> OuterDriver;
+typedef PortalEffectTemplate<PortalConfig::Hardware::MAX_NUM_LEDS, PortalConfig::Effects::GRADIENT_STEP_DEFAULT, PortalConfig::Effects::GRADIENT_MOVE_DEFAULT> OuterPortal;
+static LedArena ledArena;
+static OuterDriver fastDriver(&ledArena);
+static OuterPortal portal(&fastDriver, &ledArena);
+#if ENABLE_INNER_RING
+// Second ring on its own data pin, running the same commands as the outer one
+typedef FastLEDDriver<PortalConfig::Hardware::INNER_NUM_LEDS, PortalConfig::Hardware::INNER_LED_PIN> InnerDriver;
+typedef PortalEffectTemplate<PortalConfig::Hardware::INNER_NUM_LEDS, PortalConfig::Effects::GRADIENT_STEP_DEFAULT, PortalConfig::Effects::GRADIENT_MOVE_DEFAULT> InnerPortal;
+static InnerDriver innerDriver(&ledArena);
+static InnerPortal innerPortal(&innerDriver, &ledArena);
+static_assert(OuterDriver::arenaBytes(PortalConfig::Hardware::MAX_NUM_LEDS) + OuterPortal::RAM_BYTES +
+                      InnerDriver::arenaBytes(PortalConfig::Hardware::INNER_NUM_LEDS) + InnerPortal::RAM_BYTES <=
+                  PortalConfig::Hardware::LED_RAM_BUDGET,
+              "Both rings together exceed the LED RAM budget");
+#else
+static_assert(OuterDriver::arenaBytes(PortalConfig::Hardware::MAX_NUM_LEDS) + OuterPortal::RAM_BYTES <= PortalConfig::Hardware::LED_RAM_BUDGET,
+              "Ring exceeds the LED RAM budget");
+#endif
 // System components
 StartupSequence startupSequence;
 InputManager inputManager;
+LatencyTracer latencyTracer;
 ButtonInputSource buttonInput(nullptr, 0); // Will be initialized in setup()
+LittleFSFileStore fileStore;
+ConfigStore configStore(&fileStore);
+PresetStore presets(&fileStore, nullptr, 0); // Buffer attached once the arena is carved
+
+#if ENABLE_SHIFT_INPUTS
+// Buttons on expander inputs A-C, pulled up and switched to ground
+const int shiftInputIds[] = {static_cast<int>(InputManager::Command::TogglePortal),
+                             static_cast<int>(InputManager::Command::TriggerMalfunction),
+                             static_cast<int>(InputManager::Command::FadeOut)};
+SpiShiftInBus shiftBus(PortalConfig::Hardware::SHIFT_LATCH_PIN);
+ShiftRegisterBank shiftBank(&shiftBus, PortalConfig::Hardware::SHIFT_CHIPS);
+BankInputSource shiftInput(&shiftBank, shiftInputIds, 3, 0xFFFFFFFFu, PortalConfig::Timing::SHIFT_SAMPLE_MS,
+                           "ShiftInput");
+#endif
+
+#if ENABLE_SERIAL_COMMANDS
+HardwareSerialPort consolePort(Serial);
+SerialCommandSource serialCommands(&consolePort);
+#endif
 
 #if ENABLE_WIFI_CONTROL
 WiFiInputSource wifiInput(PortalConfig::WiFi::HTTP_PORT);
+FramePreview framePreview(&fastDriver, PortalConfig::Hardware::NUM_LEDS);
+WiFiUdpTransport dmxTransport;
+WiFiUdpTransport artNetTransport;
+DmxInputSource dmxInput(&dmxTransport, &fastDriver, PortalConfig::Hardware::NUM_LEDS, &artNetTransport);
+bool dmxTakeover = false;
+WiFiUdpTransport cueTransport;
+UdpCommandSource udpCommands(&cueTransport);
+CueTimeline timeline;
+WiFiUdpTransport clockTransport;
+ClockSync showClock(&clockTransport, ClockSync::Role::Follower, ESP.getChipId()); // Role from settings in setup()
+
+/**
+ * @brief Shared show clock in milliseconds (local time until synced)
+ */
+unsigned long showMillis()
+{
+  return showClock.nowMs(micros64());
+}
 #endif
 
 // Button configuration
@@ -36,7 +107,10 @@ const ButtonInputSource::ButtonConfig buttonConfigs[] = {
      .inputId = static_cast<int>(InputManager::Command::TogglePortal),
      .activeLow = true,
      .debounceMs = PortalConfig::Timing::DEBOUNCE_INTERVAL_MS,
-     .name = "Button1_Portal"},
+     .name = "Button1_Portal",
+     .doubleTapMs = PortalConfig::Timing::DOUBLE_TAP_MS,
+     .doubleTapId = static_cast<int>(InputManager::Command::CycleMode)},
+    // Show cue buttons have no long press, so they fire on press rather than on release
     {.pin = PortalConfig::Hardware::BUTTON2_PIN,
      .inputId = static_cast<int>(InputManager::Command::TriggerMalfunction),
      .activeLow = true,
@@ -46,79 +120,154 @@ const ButtonInputSource::ButtonConfig buttonConfigs[] = {
      .inputId = static_cast<int>(InputManager::Command::FadeOut),
      .activeLow = true,
      .debounceMs = PortalConfig::Timing::DEBOUNCE_INTERVAL_MS,
-     .name = "Button3_FadeOut"}};
-
-// PortalEffect encapsulates malfunction and gradient logic now.
+     .name = "Button3_FadeOut"},
+    {.pin = PortalConfig::Hardware::BUTTON4_PIN,
+     .inputId = static_cast<int>(InputManager::Command::CycleMode),
+     .activeLow = true,
+     .debounceMs = PortalConfig::Timing::DEBOUNCE_INTERVAL_MS,
+     .name = "Button4_ModeDim",
+     .longPressMs = PortalConfig::Timing::LONG_PRESS_MS,
+     .holdRepeatMs = PortalConfig::Timing::HOLD_REPEAT_MS,
+     .longPressId = static_cast<int>(InputManager::Command::DimStep)}};
 
 /**
- * @brief Handle input commands from any source (buttons, WiFi, etc.)
- * @param command The logical command to execute
- * @param source Name of the input source for logging
+ * @brief Connects the shared command handlers to both rings and the console
  */
-void handleInputCommand(InputManager::Command command, const char *source)
+struct FirmwareShow
 {
-  Serial.print("Input from ");
-  Serial.print(source);
-  Serial.print(": ");
-  Serial.println(InputManager::getCommandName(command));
+  static void start()
+  {
+    portal.start();
+#if ENABLE_INNER_RING
+    innerPortal.start();
+#endif
+  }
 
-  switch (command)
+  static void stop()
   {
-  case InputManager::Command::TogglePortal:
-    portalRunning = !portalRunning;
-    if (portalRunning)
-    {
-      portal.start();
-      Serial.println("Animation STARTED - Portal effect active (fade in)");
-    }
-    else
-    {
-      portal.stop();
-      Serial.println("Animation STOPPED");
-    }
-    break;
+    portal.stop();
+#if ENABLE_INNER_RING
+    innerPortal.stop();
+#endif
+  }
 
-  case InputManager::Command::TriggerMalfunction:
-    Serial.println("Portal MALFUNCTION triggered!");
+  static void triggerMalfunction()
+  {
     portal.triggerMalfunction();
-    break;
+#if ENABLE_INNER_RING
+    innerPortal.triggerMalfunction();
+#endif
+  }
 
-  case InputManager::Command::FadeOut:
-    Serial.println("Fade out triggered");
+  static void triggerFadeOut()
+  {
     portal.triggerFadeOut();
-    break;
-
-  default:
-    Serial.print("Unknown command: ");
-    Serial.println(static_cast<int>(command));
-    break;
+#if ENABLE_INNER_RING
+    innerPortal.triggerFadeOut();
+#endif
   }
+
+  static void log(const char *line) { Serial.println(line); }
+};
+typedef PortalCommands<FirmwareShow> Commands;
+
+#if ENABLE_SERIAL_COMMANDS
+/**
+ * @brief Answer a serial state query
+ *
+ * Payload: running, mode, speed, max brightness, hue min, hue max (one byte
+ * each), LED count (uint16) and settings version (uint32), little endian.
+ */
+static size_t writeState(uint8_t *payload, size_t capacity)
+{
+  if (capacity < 12)
+    return 0;
+  uint16_t ledCount = (uint16_t)fastDriver.getLength();
+  uint32_t version = ConfigManager::getVersion();
+  payload[0] = Commands::isRunning() ? 1 : 0;
+  payload[1] = (uint8_t)ConfigManager::getPortalMode();
+  payload[2] = (uint8_t)ConfigManager::getRotationSpeed();
+  payload[3] = ConfigManager::getMaxBrightness();
+  payload[4] = ConfigManager::getHueMin();
+  payload[5] = ConfigManager::getHueMax();
+  payload[6] = (uint8_t)(ledCount & 0xFF);
+  payload[7] = (uint8_t)(ledCount >> 8);
+  for (int i = 0; i < 4; i++)
+    payload[8 + i] = (uint8_t)(version >> (8 * i));
+  return 12;
 }
+#endif
 
 void setup()
 {
-  Serial.begin(115200);
+  Serial.begin(PortalConfig::SerialConsole::BAUD_RATE);
   srand(millis()); // Seed random for uniform distribution
   Serial.println("WS2812 Traveling Light Test Starting...");
 
   // Initialize status LED
   StatusLED::begin();
 
+  // Initialize configuration manager
+  ConfigManager::begin();
+  if (fileStore.begin())
+  {
+    int records = configStore.load();
+    Serial.print("Settings restored from flash: ");
+    Serial.println(records >= 0 ? records : 0);
+  }
+
+  // Size the LED arena for the configured count; no per-LED buffer is
+  // allocated after this point
+  int ledCount = ConfigManager::getLedCount();
+  size_t arenaBytes = OuterDriver::arenaBytes(ledCount) + OuterPortal::arenaBytes(ledCount);
+#if ENABLE_INNER_RING
+  arenaBytes += InnerDriver::arenaBytes(PortalConfig::Hardware::INNER_NUM_LEDS) +
+                InnerPortal::arenaBytes(PortalConfig::Hardware::INNER_NUM_LEDS);
+#endif
+  if (!ledArena.begin(arenaBytes))
+    Serial.println("LED arena allocation failed - LEDs disabled");
+  fastDriver.setLength(ledCount);
+
   // Initialize portal effect (which initializes LEDs)
-  portal.begin();
+  if (!portal.begin())
+    Serial.println("Portal effect buffers unavailable");
+#if ENABLE_INNER_RING
+  innerPortal.begin();
+#endif
+  presets.setBuffer(portal.getEffectBuffer(), portal.getEffectLength());
+  presets.setRecallCallback([]()
+                            { portal.keepEffectOnStart(); });
 
   // Initialize startup sequence
   startupSequence.begin(&fastDriver);
 
-  // Initialize configuration manager
-  ConfigManager::begin();
-
   // Initialize input system
-  buttonInput = ButtonInputSource(buttonConfigs, 3);
+#if ENABLE_SHIFT_INPUTS
+  shiftBus.begin();
+  inputManager.addInputSource(&shiftInput);
+#else
+  buttonInput = ButtonInputSource(buttonConfigs, sizeof(buttonConfigs) / sizeof(buttonConfigs[0]),
+                                  PortalConfig::Hardware::BUTTON_INTERRUPTS ? ButtonInputSource::CaptureMode::Interrupt
+                                                                            : ButtonInputSource::CaptureMode::Polling);
+  buttonInput.begin();
   inputManager.addInputSource(&buttonInput);
+#endif
+
+#if ENABLE_SERIAL_COMMANDS
+  serialCommands.setStateWriter(writeState);
+  inputManager.addInputSource(&serialCommands);
+#endif
 
 #if ENABLE_WIFI_CONTROL
   // Initialize WiFi input source
+  wifiInput.attachPreview(&framePreview);
+  wifiInput.attachTimeline(&timeline);
+  wifiInput.attachPresets(&presets);
+  wifiInput.attachArena(&ledArena);
+  wifiInput.attachLatency(&latencyTracer);
+  wifiInput.attachInputs(&inputManager, &udpCommands);
+  framePreview.setLength(fastDriver.getLength());
+  dmxInput.setLength(fastDriver.getLength());
   if (wifiInput.begin(PortalConfig::WiFi::DEFAULT_SSID, PortalConfig::WiFi::DEFAULT_PASSWORD))
   {
     inputManager.addInputSource(&wifiInput);
@@ -128,14 +277,58 @@ void setup()
     Serial.println("  http://[ip]/toggle - Toggle portal effect");
     Serial.println("  http://[ip]/malfunction - Trigger malfunction");
     Serial.println("  http://[ip]/fadeout - Fade out effect");
+    Serial.println("  http://[ip]/preview - Live ring preview");
+    Serial.println("  http://[ip]/preset?action=recall&slot=N - Recall a saved look");
+
+    if (dmxInput.begin())
+    {
+      inputManager.addInputSource(&dmxInput);
+      Serial.print("E1.31 input listening on UDP port ");
+      Serial.print(PortalConfig::Dmx::E131_PORT);
+      Serial.print(", Art-Net on ");
+      Serial.println(PortalConfig::Dmx::ARTNET_PORT);
+    }
+
+    if (udpCommands.begin())
+    {
+      inputManager.addInputSource(&udpCommands);
+      Serial.print("UDP cue triggers listening on port ");
+      Serial.println(PortalConfig::WiFi::CUE_UDP_PORT);
+    }
+
+    // LittleFS is mounted by wifiInput.begin(); the show is started over HTTP
+    int cues = timeline.loadFromFile();
+    if (cues >= 0)
+    {
+      Serial.print("Cue timeline loaded: ");
+      Serial.print(cues);
+      Serial.println(" cues (http://[ip]/timeline?action=start)");
+    }
+    inputManager.addInputSource(&timeline);
+
+    showClock.setRole(ConfigManager::isClockMaster() ? ClockSync::Role::Master : ClockSync::Role::Follower);
+    if (showClock.begin())
+    {
+      Serial.print("Show clock sync (");
+      Serial.print(ConfigManager::isClockMaster() ? "master" : "follower");
+      Serial.print(") on UDP port ");
+      Serial.println(PortalConfig::ClockSync::PORT);
+    }
   }
   else
   {
     Serial.println("WiFi connection failed - continuing with buttons only");
   }
+  portal.setClock(showMillis);
+#if ENABLE_INNER_RING
+  innerPortal.setClock(showMillis);
+#endif
 #endif
 
-  inputManager.setInputCallback(handleInputCommand);
+  inputManager.setCommandTable(Commands::table);
+  inputManager.setTracer(&latencyTracer);
+  fastDriver.setShowHook([]()
+                         { latencyTracer.shown(); });
 
   Serial.println("Setup started; running non-blocking startup diagnostics...");
   Serial.println("Button commands available:");
@@ -143,15 +336,51 @@ void setup()
   Serial.println("  Button 2: Trigger malfunction");
   Serial.println("  Button 3: Fade out");
   Serial.print("Total LEDs: ");
-  Serial.println(PortalConfig::Hardware::NUM_LEDS);
+  Serial.println(fastDriver.getLength());
+#if ENABLE_INNER_RING
+  Serial.print("Inner ring LEDs: ");
+  Serial.println(PortalConfig::Hardware::INNER_NUM_LEDS);
+#endif
   Serial.print("Circle radius: ");
-  Serial.print(PortalConfig::Hardware::NUM_LEDS / (2.0 * PortalConfig::Math::PI_F));
+  Serial.print(fastDriver.getLength() / (2.0 * PortalConfig::Math::PI_F));
   Serial.println(" LEDs");
+  Serial.print("LED arena: ");
+  Serial.print((unsigned long)ledArena.getUsed());
+  Serial.print(" / ");
+  Serial.print((unsigned long)ledArena.getCapacity());
+  Serial.println(" bytes");
+
+  // From here on the firmware runs without heap allocations of its own
+  HeapMonitor::begin();
+  Serial.print("Free heap after setup: ");
+  Serial.println(HeapMonitor::getStats().heapFree);
+}
+
+/**
+ * @brief Print the input latency percentiles now and then, if anything was traced
+ */
+static void reportLatency(unsigned long now)
+{
+  static unsigned long lastReport = 0;
+  static uint32_t lastCount = 0;
+  if (PortalConfig::Timing::LATENCY_REPORT_MS == 0 || now - lastReport < PortalConfig::Timing::LATENCY_REPORT_MS)
+    return;
+  lastReport = now;
+  uint32_t count = latencyTracer.getHistogram(LatencyTracer::Stage::Dispatch).getCount();
+  if (count == lastCount)
+    return;
+  lastCount = count;
+  static ResponseBuffer<384> report;
+  report.clear();
+  latencyTracer.appendJson(report);
+  Serial.print("Input latency (us): ");
+  Serial.println(report.c_str());
 }
 
 void loop()
 {
   unsigned long now = millis();
+  HeapMonitor::sample();
 
   // Handle non-blocking startup diagnostics
   if (!startupSequence.isComplete())
@@ -170,9 +399,48 @@ void loop()
     return; // Don't process inputs during startup
   }
 
+#if ENABLE_WIFI_CONTROL
+  showClock.update(micros64());
+#endif
+
   // Process all input sources (buttons, WiFi, etc.)
   inputManager.update(now);
+  configStore.update(now);
+  reportLatency(now);
+
+#if ENABLE_WIFI_CONTROL
+  unsigned long effectTime = showMillis();
+#else
+  unsigned long effectTime = now;
+#endif
+
+#if ENABLE_INNER_RING
+  // The inner ring has its own controller and keeps running during a takeover
+  innerPortal.update(effectTime);
+#endif
+
+#if ENABLE_WIFI_CONTROL
+  // A lighting console streaming E1.31/Art-Net owns the ring until it times out
+  bool dmxActive = dmxInput.isActive(now);
+  if (dmxActive != dmxTakeover)
+  {
+    dmxTakeover = dmxActive;
+    Serial.println(dmxActive ? "Console input ACTIVE - effects paused" : "Console input timed out - effects resumed");
+    // An idle portal draws nothing, so the last console frame would stay lit
+    if (!dmxActive && !portal.isRunning())
+    {
+      fastDriver.clear();
+      fastDriver.show();
+    }
+  }
+  if (dmxActive)
+  {
+    if (dmxInput.consumeFrame())
+      fastDriver.show();
+    return;
+  }
+#endif
 
   // Run effects
-  portal.update(now);
+  portal.update(effectTime);
 }
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "config_manager.h"
+#include "input_manager.h"
+#include <stdio.h>
+
+/**
+ * @brief Handlers of the InputManager commands, shared by the firmware and
+ * the host simulator
+ *
+ * The Show policy connects the handlers to the effects and the console.
+ * It provides static functions:
+ * - start(), stop(), triggerMalfunction(), triggerFadeOut(): drive every ring
+ * - log(const char *line): print one console line (may do nothing)
+ *
+ * @example
+ * ```cpp
+ * struct FirmwareShow
+ * {
+ *   static void start() { portal.start(); }
+ *   ...
+ *   static void log(const char *line) { Serial.println(line); }
+ * };
+ * inputManager.setCommandTable(PortalCommands<FirmwareShow>::table);
+ * ```
+ */
+template <typename Show>
+class PortalCommands
+{
+public:
+  /**
+   * @brief Whether the last toggle started the portal
+   */
+  static bool isRunning() { return running; }
+
+  static void togglePortal(InputManager::Command command, const IInputSource::InputEvent &event)
+  {
+    logCommand(command, event);
+    running = !running;
+    if (running)
+    {
+      Show::start();
+      Show::log("Animation STARTED - Portal effect active (fade in)");
+    }
+    else
+    {
+      Show::stop();
+      Show::log("Animation STOPPED");
+    }
+  }
+
+  static void triggerMalfunction(InputManager::Command command, const IInputSource::InputEvent &event)
+  {
+    logCommand(command, event);
+    Show::log("Portal MALFUNCTION triggered!");
+    Show::triggerMalfunction();
+  }
+
+  static void fadeOut(InputManager::Command command, const IInputSource::InputEvent &event)
+  {
+    logCommand(command, event);
+    Show::log("Fade out triggered");
+    Show::triggerFadeOut();
+  }
+
+  static void cycleMode(InputManager::Command command, const IInputSource::InputEvent &event)
+  {
+    logCommand(command, event);
+    ConfigManager::setPortalMode(ConfigManager::getPortalMode() == 0 ? 1 : 0);
+    Show::log(ConfigManager::getPortalMode() == 0 ? "Portal mode: Classic" : "Portal mode: Virtual Gradients");
+  }
+
+  /**
+   * @brief Step the max brightness down to DIM_MIN, then back up to full, and so on
+   */
+  static void dimStep(InputManager::Command command, const IInputSource::InputEvent &event)
+  {
+    logCommand(command, event);
+    int brightness = ConfigManager::getMaxBrightness();
+    if (brightness <= PortalConfig::Timing::DIM_MIN)
+      dimmingUp = true;
+    else if (brightness >= 255)
+      dimmingUp = false;
+    brightness += dimmingUp ? PortalConfig::Timing::DIM_STEP : -PortalConfig::Timing::DIM_STEP;
+    ConfigManager::setMaxBrightness((uint8_t)constrain(brightness, (int)PortalConfig::Timing::DIM_MIN, 255));
+    char line[32];
+    snprintf(line, sizeof(line), "Max brightness: %u", ConfigManager::getMaxBrightness());
+    Show::log(line);
+  }
+
+  // Parameter commands arrive coalesced, so these run at most once per loop
+  static void setSpeed(InputManager::Command, const IInputSource::InputEvent &event)
+  {
+    ConfigManager::setRotationSpeed(event.arg1);
+  }
+
+  static void setBrightness(InputManager::Command, const IInputSource::InputEvent &event)
+  {
+    ConfigManager::setMaxBrightness(constrain(event.arg1, 0, 255));
+  }
+
+  static void setHue(InputManager::Command, const IInputSource::InputEvent &event)
+  {
+    ConfigManager::Transaction transaction;
+    ConfigManager::setHueMin(constrain(event.arg1, 0, 255));
+    ConfigManager::setHueMax(constrain(event.arg2, 0, 255));
+  }
+
+  static void setMode(InputManager::Command, const IInputSource::InputEvent &event)
+  {
+    ConfigManager::setPortalMode(event.arg1);
+  }
+
+  // Command handlers, indexed by command value - 1
+  static constexpr InputManager::CommandHandler table[] = {
+      togglePortal,       // TogglePortal
+      triggerMalfunction, // TriggerMalfunction
+      fadeOut,            // FadeOut
+      cycleMode,          // CycleMode
+      dimStep,            // DimStep
+      setSpeed,           // SetSpeed
+      setBrightness,      // SetBrightness
+      setHue,             // SetHue
+      setMode};           // SetMode
+  static_assert(sizeof(table) / sizeof(table[0]) == InputManager::COMMAND_COUNT, "Every command needs a handler");
+
+private:
+  static bool running;
+  static bool dimmingUp;
+
+  /**
+   * @brief Log a command from any source (buttons, WiFi, etc.)
+   */
+  static void logCommand(InputManager::Command command, const IInputSource::InputEvent &event)
+  {
+    char line[64];
+    snprintf(line, sizeof(line), "Input from %s: %s", event.sourceName, InputManager::getCommandName(command));
+    Show::log(line);
+  }
+};
+
+template <typename Show>
+bool PortalCommands<Show>::running = false;
+
+template <typename Show>
+bool PortalCommands<Show>::dimmingUp = false;
@@ -2,6 +2,7 @@
 
 #include "effects.h"
 #include "led_driver.h"
+#include "led_arena.h"
 #include "config.h"
 #include "config_manager.h"
 #ifndef UNIT_TEST
@@ -14,10 +15,31 @@ extern "C" unsigned long millis();
 
 #ifdef UNIT_TEST
 // Provide small helpers to emulate Arduino behavior used in portal_effect
+#include <cstdint>
 #include <cstdlib>
-static inline int rnd(int max) { return rand() % max; }
-static inline int rndRange(int a, int b) { return a + (rand() % (b - a)); }
-static inline float rndf(int max) { return (float)(rand() % max); }
+
+// Fixed xorshift32 generator instead of rand(), whose sequence differs
+// between C libraries; seeded output (golden frames, fuzz cases) is then
+// the same on every host. Seed it with randomSeed().
+inline uint32_t testRandomState = 2463534242u;
+static inline uint32_t testRandom()
+{
+  uint32_t x = testRandomState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return testRandomState = x;
+}
+static inline void randomSeed(unsigned long seed)
+{
+  testRandomState = (uint32_t)seed * 2654435769u + 2463534242u;
+  if (testRandomState == 0)
+    testRandomState = 2463534242u;
+}
+
+static inline int rnd(int max) { return (int)(testRandom() % (uint32_t)max); }
+static inline int rndRange(int a, int b) { return a + rnd(b - a); }
+static inline float rndf(int max) { return (float)rnd(max); }
 static inline float constrainf(float v, float a, float b) { return v < a ? a : (v > b ? b : v); }
 
 // Simple CHSV -> CRGB, using hue only as index into a small palette approximation
@@ -38,27 +60,53 @@ static inline long arduino_random(long max)
 {
   if (max <= 0)
     return 0;
-  return rand() % max;
+  return (long)(testRandom() % (unsigned long)max);
 }
 static inline long arduino_random(long min, long max)
 {
   if (max <= min)
     return min;
-  return min + (rand() % (max - min));
+  return min + (long)(testRandom() % (unsigned long)(max - min));
 }
 #define random(...) arduino_random(__VA_ARGS__)
 
 // constrain macro compatibility
+#ifndef constrain
 #define constrain(x, a, b) (constrainf((x), (a), (b)))
 #endif
+#endif
 
-// Template PortalEffect uses a driver and static buffers sized at compile time
+// Template PortalEffect drives up to N LEDs; the actual count comes from the
+// driver at begin() and the per-LED buffers are carved from the LED arena, so
+// several rings of different lengths can run side by side
 template <int N, int GRADIENT_STEP, int GRADIENT_MOVE>
 class PortalEffectTemplate
 {
 public:
-  PortalEffectTemplate(ILEDDriver *driver) : _driver(driver)
+  /**
+   * @brief Arena bytes needed for a ring of the given length
+   */
+  static constexpr size_t arenaBytes(int numLeds) { return 3 * LedArena::footprint(sizeof(CRGB) * numLeds); }
+
+  /**
+   * @brief Arena bytes at the maximum LED count
+   */
+  static constexpr unsigned long RAM_BYTES = arenaBytes(N);
+
+  static_assert(N > PortalConfig::Effects::MAX_DRIVER_DISTANCE, "Ring must be longer than the driver spacing");
+  static_assert(N <= PortalConfig::Hardware::MAX_LEDS_PER_RING, "LED count outside the supported range");
+  static_assert(RAM_BYTES <= PortalConfig::Hardware::LED_RAM_BUDGET, "Effect buffers exceed the LED RAM budget");
+
+  /**
+   * @brief Millisecond time source used for effect timing
+   */
+  typedef unsigned long (*ClockFn)();
+
+  PortalEffectTemplate(ILEDDriver *driver, LedArena *arena) : _driver(driver), _arena(arena), _clock(millis)
   {
+    effectLeds = nullptr;
+    sequence1 = nullptr;
+    sequence2 = nullptr;
     NUM_LEDS = N;
     gradientPosition = 0;
     gradientPos1 = 0;
@@ -70,16 +118,75 @@ public:
     fadeOutStart = 0;
     malfunctionActive = false;
     lastUpdate = 0;
+    lastTick = 0;
+    frameTime = 0;
+    keepEffect = false;
+    frameConfig = ConfigManager::current();
+    sequenceInitialized = false;
+    lastJump = 0;
+    targetBrightness = 1.0f;
+    currentBrightness = 1.0f;
+    jumpInterval = 100;
     numGradientPoints = 0;
   }
 
-  void begin()
+  /**
+   * @brief Use a shared show clock instead of the local millis()
+   *
+   * Rotation and fades are derived from this clock (and from the timestamps
+   * passed to update()), so portals following the same clock stay in phase.
+   * @param clock Function returning the current time in milliseconds
+   */
+  void setClock(ClockFn clock) { _clock = clock; }
+
+  /**
+   * @brief Generated gradient the classic effect rotates (for presets)
+   */
+  CRGB *getEffectBuffer() { return effectLeds; }
+  int getEffectLength() const { return NUM_LEDS; }
+
+  /**
+   * @brief Keep the current effect buffer on the next start() instead of
+   * generating a new random gradient (used after a preset recall)
+   */
+  void keepEffectOnStart() { keepEffect = true; }
+
+  /**
+   * @brief Start the driver and carve the effect buffers for its LED count
+   * @return false if the arena could not hold the buffers (the ring stays dark)
+   */
+  bool begin()
   {
     _driver->begin();
     _leds = _driver->getBuffer();
-    // effectLeds are static arrays
+    int length = _driver->getLength();
+    if (_leds == nullptr || length <= PortalConfig::Effects::MAX_DRIVER_DISTANCE || length > N)
+      return false;
+
+    NUM_LEDS = length;
+    effectLeds = _arena->allocate<CRGB>(NUM_LEDS);
+    sequence1 = _arena->allocate<CRGB>(NUM_LEDS);
+    sequence2 = _arena->allocate<CRGB>(NUM_LEDS);
+    if (sequence2 == nullptr)
+    {
+      effectLeds = nullptr;
+      return false;
+    }
+    for (int i = 0; i < NUM_LEDS; i++)
+      effectLeds[i] = CRGB(0, 0, 0);
+    return true;
   }
 
+  /**
+   * @brief Whether begin() set up the buffers
+   */
+  bool isReady() const { return effectLeds != nullptr; }
+
+  /**
+   * @brief Whether an effect (animation, fade-out or malfunction) is drawing frames
+   */
+  bool isRunning() const { return animationActive || fadeOutActive || malfunctionActive; }
+
   void setBrightness(uint8_t b) { _driver->setBrightness(b); }
   void fillSolid(const CRGB &c)
   {
@@ -94,13 +201,24 @@ public:
 
   void start()
   {
-    if (!animationActive)
+    if (!animationActive && isReady())
     {
       animationActive = true;
       fadeInActive = true;
-      fadeInStart = millis();
-      gradientPosition = 0;
-      generatePortalEffect((CRGB *)effectLeds);
+      unsigned long now = _clock();
+      frameConfig = ConfigManager::capture();
+      fadeInStart = now;
+      frameTime = now;
+      // Anchor the rotation to absolute time so every portal on the same
+      // clock shows the same position, regardless of when it was started
+      lastTick = now / PortalConfig::Timing::ROTATION_STEP_MS;
+      gradientPosition = (int)(((unsigned long)frameConfig.rotationSpeed * lastTick) % NUM_LEDS);
+      int halfStep = (int)(((unsigned long)(frameConfig.rotationSpeed / 2) * lastTick) % NUM_LEDS);
+      gradientPos1 = halfStep;
+      gradientPos2 = (NUM_LEDS - halfStep) % NUM_LEDS;
+      if (!keepEffect)
+        generatePortalEffect(effectLeds);
+      keepEffect = false;
     }
   }
 
@@ -116,7 +234,7 @@ public:
     if (!fadeOutActive && (animationActive || malfunctionActive))
     {
       fadeOutActive = true;
-      fadeOutStart = millis();
+      fadeOutStart = _clock();
       fadeInActive = false;
       animationActive = false;
       malfunctionActive = false;
@@ -125,7 +243,7 @@ public:
 
   void triggerMalfunction()
   {
-    if (!malfunctionActive)
+    if (!malfunctionActive && isReady())
     {
       malfunctionActive = true;
       animationActive = false;
@@ -138,9 +256,12 @@ public:
     {
       if (now - lastUpdate >= 10)
       {
+        // All parameters for this frame come from one snapshot
+        frameConfig = ConfigManager::capture();
+
         if (animationActive && ConfigManager::needsEffectRegeneration())
         {
-          if (ConfigManager::getPortalMode() == 0)
+          if (frameConfig.portalMode == 0)
           {
             generatePortalEffect(effectLeds);
           }
@@ -149,20 +270,31 @@ public:
           ConfigManager::clearEffectRegenerationFlag();
         }
 
-        int speed = ConfigManager::getRotationSpeed();
-        if (ConfigManager::getPortalMode() == 0)
-          gradientPosition = (gradientPosition + speed) % NUM_LEDS;
+        // Advance by elapsed rotation steps rather than by rendered frames,
+        // so a slow show() or a clock correction doesn't change the phase.
+        // A step lasts one frame of the 800-LED strip (ROTATION_STEP_MS), so a
+        // speed setting turns the ring as fast as when it stepped per frame
+        frameTime = now;
+        unsigned long tick = now / PortalConfig::Timing::ROTATION_STEP_MS;
+        unsigned long ticks = (long)(tick - lastTick) > 0 ? tick - lastTick : 0;
+        lastTick = tick;
+        int speed = frameConfig.rotationSpeed;
+        if (frameConfig.portalMode == 0)
+          gradientPosition = (int)((gradientPosition + (unsigned long)speed * ticks) % NUM_LEDS);
         else
         {
           // Move at half speed for virtual gradient effect
           // Ensure balanced speeds for wave effect
-          gradientPos1 = (gradientPos1 + speed / 2) % NUM_LEDS;
-          gradientPos2 = (gradientPos2 - speed / 2 + NUM_LEDS) % NUM_LEDS;
+          int step = (int)(((unsigned long)(speed / 2) * ticks) % NUM_LEDS);
+          gradientPos1 = (gradientPos1 + step) % NUM_LEDS;
+          gradientPos2 = (gradientPos2 - step + NUM_LEDS) % NUM_LEDS;
         }
+        if (malfunctionActive)
+          gradientPosition = (int)((gradientPosition + (unsigned long)GRADIENT_MOVE * ticks) % NUM_LEDS);
 
         if (fadeOutActive || animationActive)
         {
-          if (ConfigManager::getPortalMode() == 0)
+          if (frameConfig.portalMode == 0)
             portalEffect();
           else
             virtualGradientEffect();
@@ -175,14 +307,32 @@ public:
   }
 
 private:
+  static constexpr int MAX_DRIVERS = N / PortalConfig::Effects::MIN_DRIVER_DISTANCE + 2;
+
   ILEDDriver *_driver;
+  LedArena *_arena;
+  ClockFn _clock;
   CRGB *_leds;
 #ifdef UNIT_TEST
 public:
-  CRGB *testGeneratePortalEffect(CRGB *effectLeds) { return generatePortalEffect(effectLeds); }
+  CRGB *testGeneratePortalEffect(CRGB *sequence, bool useBlackDrivers = false, uint8_t hue = 0)
+  {
+    generatePortalEffect(sequence, useBlackDrivers, hue);
+    return sequence;
+  }
   int testGetDriverIndex(int i) { return driverIndices[i]; }
+  int testGetGradientPos1() const { return gradientPos1; }
+  int testGetGradientPos2() const { return gradientPos2; }
+  static int testLayoutDrivers(int numLeds, int minDist, int maxDist, int *indices, int capacity)
+  {
+    return layoutDrivers(numLeds, minDist, maxDist, indices, capacity);
+  }
+  static uint8_t testRandomHue(uint8_t hueMin, uint8_t hueMax) { return randomHue(hueMin, hueMax); }
 #endif
-  CRGB effectLeds[N]; // Changed from static to instance storage
+  CRGB *effectLeds; // Generated gradient, carved from the arena
+  CRGB *sequence1;  // Virtual gradient mode, clockwise sequence
+  CRGB *sequence2;  // Virtual gradient mode, counterclockwise sequence
+  int driverIndices[MAX_DRIVERS + 1];
   int numGradientPoints;
 
   int NUM_LEDS;
@@ -196,6 +346,17 @@ public:
   unsigned long fadeOutStart;
   bool malfunctionActive;
   unsigned long lastUpdate;
+  unsigned long lastTick;              // Last rotation step, in ROTATION_STEP_MS units of the clock
+  unsigned long frameTime;             // Timestamp of the frame being rendered
+  bool keepEffect;                     // Skip generation on the next start()
+  ConfigManager::Snapshot frameConfig; // Parameters of the frame being rendered
+  bool sequenceInitialized;            // Virtual gradient sequences generated
+  unsigned long lastJump;              // Malfunction: last brightness jump
+  float targetBrightness;              // Malfunction: brightness being approached
+  float currentBrightness;             // Malfunction: current flicker brightness
+  int jumpInterval;                    // Malfunction: time until the next jump
+
+  static bool isBlack(const CRGB &c) { return (c.r | c.g | c.b) == 0; }
 
   void generateVirtualGradients()
   {
@@ -204,22 +365,20 @@ public:
     // This function is called when effect regeneration is needed
   }
 
+  /**
+   * @brief Random hue in [hueMin, hueMax], wrapping past 255 when hueMin > hueMax
+   * (e.g. min=250, max=10 for a range crossing red)
+   */
+  static uint8_t randomHue(uint8_t hueMin, uint8_t hueMax)
+  {
+    // 0..255 spans 256 hues, which does not fit the range length in 8 bits
+    int length = hueMin <= hueMax ? hueMax - hueMin + 1 : 256 - hueMin + hueMax + 1;
+    return (uint8_t)(hueMin + random(length));
+  }
+
   CRGB getRandomDriverColorInternal()
   {
-    // Handle hue range with wrap-around (e.g., min=250, max=10 for crossing 0/255)
-    uint8_t hueMin = ConfigManager::getHueMin();
-    uint8_t hueMax = ConfigManager::getHueMax();
-    uint8_t length;
-    if (hueMin <= hueMax)
-    {
-      length = hueMax - hueMin + 1;
-    }
-    else
-    {
-      length = 256 - hueMin + hueMax + 1;
-    }
-    uint8_t offset = random(length);
-    uint8_t hue = (hueMin + offset) % 256;
+    uint8_t hue = randomHue(frameConfig.hueMin, frameConfig.hueMax);
 
     uint8_t sat = PortalConfig::Effects::PORTAL_SAT_BASE + random(PortalConfig::Effects::PORTAL_SAT_RANGE);
     if (random(PortalConfig::Effects::PORTAL_LOW_SAT_PROBABILITY) == 0)
@@ -228,30 +387,60 @@ public:
     return CHSV(hue, sat, val);
   }
 
-  CRGB *generateDriverColors(CRGB *driverColors, int &numDrivers, bool useBlackDrivers = false, uint8_t hue = 0)
+  /**
+   * @brief Place gradient drivers around a ring of numLeds LEDs
+   *
+   * The first driver sits on LED 0 and the next ones follow at random steps
+   * of minDist..maxDist. indices[count] = numLeds closes the ring, so the
+   * last segment blends back into the first driver. Every segment is at
+   * least minDist long (unless the ring itself is shorter) and at most
+   * maxDist, or 2 * minDist - 1 when the spacing range is too narrow to
+   * split the remainder.
+   * @param indices Output, capacity entries
+   * @return Number of drivers placed, at most capacity - 1
+   */
+  static int layoutDrivers(int numLeds, int minDist, int maxDist, int *indices, int capacity)
   {
-    const int minDist = PortalConfig::Effects::MIN_DRIVER_DISTANCE;
-    const int maxDist = PortalConfig::Effects::MAX_DRIVER_DISTANCE;
-    static int driverIndices[N];
-    numDrivers = 0;
+    if (minDist < 1)
+      minDist = 1;
+    if (maxDist < minDist)
+      maxDist = minDist;
+    int count = 0;
     int idx = 0;
-    while (idx < NUM_LEDS - minDist && numDrivers < N - 1)
+    while (count < capacity - 1)
     {
-      driverIndices[numDrivers] = idx;
-      driverColors[numDrivers] = getRandomDriverColorInternal();
-      numDrivers++;
-      int step = minDist + random(maxDist - minDist + 1);
-      if (idx + step > NUM_LEDS - minDist)
+      indices[count++] = idx;
+      int remaining = numLeds - idx;
+      if (remaining <= maxDist || remaining < 2 * minDist)
         break;
+      // Never leave less than minDist for the closing segment
+      int step = minDist + random(maxDist - minDist + 1);
+      if (step > remaining - minDist)
+        step = remaining - minDist;
       idx += step;
     }
-    driverIndices[numDrivers] = NUM_LEDS;
-    driverColors[numDrivers] = driverColors[0];
-    numDrivers++;
+    indices[count] = numLeds;
+    return count;
+  }
+
+  /**
+   * @brief Lay out the drivers and pick their colors
+   * @param driverColors Output, MAX_DRIVERS entries; the closing entry repeats
+   * the first color so the ring has no seam
+   * @param numDrivers Output, number of driverIndices entries including the closing one
+   */
+  CRGB *generateDriverColors(CRGB *driverColors, int &numDrivers, bool useBlackDrivers = false, uint8_t hue = 0)
+  {
+    int placed = layoutDrivers(NUM_LEDS, PortalConfig::Effects::MIN_DRIVER_DISTANCE,
+                               PortalConfig::Effects::MAX_DRIVER_DISTANCE, driverIndices, MAX_DRIVERS);
+    for (int i = 0; i < placed; i++)
+      driverColors[i] = getRandomDriverColorInternal();
+    driverColors[placed] = driverColors[0];
+    numDrivers = placed + 1;
 
     if (useBlackDrivers)
     {
-      for (int i = 0; i < numDrivers; i++)
+      for (int i = 0; i < placed; i++)
       {
         if (i % 2 != 0)
         {
@@ -264,6 +453,7 @@ public:
                                  PortalConfig::Effects::PORTAL_VAL_BASE + random(PortalConfig::Effects::PORTAL_VAL_RANGE));
         }
       }
+      driverColors[placed] = driverColors[0];
     }
 
     return driverColors;
@@ -271,27 +461,11 @@ public:
 
   void generatePortalEffect(CRGB *sequence, bool useBlackDrivers = false, uint8_t hue = 0)
   {
-    CRGB driverColors[N];
+    // Colors and positions come from the same layout in driverIndices
+    CRGB driverColors[MAX_DRIVERS];
     int numDrivers = 0;
     generateDriverColors(driverColors, numDrivers, useBlackDrivers, hue);
 
-    static int driverIndices[N];
-    const int minDist = PortalConfig::Effects::MIN_DRIVER_DISTANCE;
-    const int maxDist = PortalConfig::Effects::MAX_DRIVER_DISTANCE;
-    int idx = 0;
-    numDrivers = 0;
-    while (idx < NUM_LEDS - minDist && numDrivers < N - 1)
-    {
-      driverIndices[numDrivers] = idx;
-      numDrivers++;
-      int step = minDist + random(maxDist - minDist + 1);
-      if (idx + step > NUM_LEDS - minDist)
-        break;
-      idx += step;
-    }
-    driverIndices[numDrivers] = NUM_LEDS;
-    numDrivers++;
-
     for (int d = 0; d < numDrivers - 1; d++)
     {
       int start = driverIndices[d];
@@ -302,10 +476,7 @@ public:
       for (int i = 0; i < segLen; i++)
       {
         float ratio = (segLen == 1) ? 0.0f : (float)i / (segLen - 1);
-        CRGB col = interpolateColor(c1, c2, ratio);
-        int pos = start + i;
-        if (pos >= 0 && pos < NUM_LEDS)
-          sequence[pos] = col; // Store brightness in sequence array
+        sequence[start + i] = interpolateColor(c1, c2, ratio);
       }
     }
   }
@@ -315,8 +486,7 @@ public:
     float fadeScale = 1.0f;
     if (fadeInActive)
     {
-      unsigned long now = millis();
-      float t = (now - fadeInStart) / (float)PortalConfig::Timing::FADE_IN_DURATION_MS;
+      float t = (frameTime - fadeInStart) / (float)PortalConfig::Timing::FADE_IN_DURATION_MS;
       fadeScale = constrain(t, 0.0f, 1.0f);
       if (fadeScale >= 1.0f)
       {
@@ -326,8 +496,7 @@ public:
     }
     else if (fadeOutActive)
     {
-      unsigned long now = millis();
-      float t = (now - fadeOutStart) / (float)PortalConfig::Timing::FADE_OUT_DURATION_MS;
+      float t = (frameTime - fadeOutStart) / (float)PortalConfig::Timing::FADE_OUT_DURATION_MS;
       fadeScale = 1.0f - constrain(t, 0.0f, 1.0f);
       if (fadeScale <= 0.0f)
       {
@@ -345,18 +514,13 @@ public:
       if (fadeScale < 1.0f)
         _driver->getBuffer()[i].nscale8((uint8_t)(fadeScale * 255));
     }
-    _driver->setBrightness(ConfigManager::getMaxBrightness());
+    _driver->setBrightness(frameConfig.maxBrightness);
     _driver->show();
   }
 
   void portalMalfunctionEffect()
   {
-    unsigned long now = millis();
-    static unsigned long lastJump = 0;
-    static float targetBrightness = 1.0f;
-    static float currentBrightness = 1.0f;
-    static int jumpInterval = 100;
-    gradientPosition = (gradientPosition + GRADIENT_MOVE) % NUM_LEDS;
+    unsigned long now = frameTime;
 
     if (now - lastJump > (unsigned long)jumpInterval)
     {
@@ -387,8 +551,7 @@ public:
     float fadeScale = 1.0f;
     if (fadeInActive)
     {
-      unsigned long now = millis();
-      float t = (now - fadeInStart) / (float)PortalConfig::Timing::FADE_IN_DURATION_MS;
+      float t = (frameTime - fadeInStart) / (float)PortalConfig::Timing::FADE_IN_DURATION_MS;
       fadeScale = constrain(t, 0.0f, 1.0f);
       if (fadeScale >= 1.0f)
       {
@@ -398,8 +561,7 @@ public:
     }
     else if (fadeOutActive)
     {
-      unsigned long now = millis();
-      float t = (now - fadeOutStart) / (float)PortalConfig::Timing::FADE_OUT_DURATION_MS;
+      float t = (frameTime - fadeOutStart) / (float)PortalConfig::Timing::FADE_OUT_DURATION_MS;
       fadeScale = 1.0f - constrain(t, 0.0f, 1.0f);
       if (fadeScale <= 0.0f)
       {
@@ -412,72 +574,68 @@ public:
       }
     }
 
-    uint8_t hue1 = ConfigManager::getHueMin();
-    uint8_t hue2 = ConfigManager::getHueMax();
+    uint8_t hue1 = frameConfig.hueMin;
+    uint8_t hue2 = frameConfig.hueMax;
 
     // Create virtual sequences with sparse drivers
-    static CRGB sequence1[PortalConfig::Hardware::NUM_LEDS];
-    static CRGB sequence2[PortalConfig::Hardware::NUM_LEDS];
-    static bool sequenceInitialized = false;
-
     if (!sequenceInitialized)
     {
-      generatePortalEffect((CRGB *)sequence1, true, (uint8_t)ConfigManager::getHueMin());
-      generatePortalEffect((CRGB *)sequence2, true, (uint8_t)ConfigManager::getHueMax());
+      generatePortalEffect(sequence1, true, frameConfig.hueMin);
+      generatePortalEffect(sequence2, true, frameConfig.hueMax);
 
       // Seed random once
-      randomSeed(millis());
+      randomSeed(_clock());
 
       sequenceInitialized = true;
     }
 
-    for (int i = 0; i < PortalConfig::Hardware::NUM_LEDS; i++)
+    for (int i = 0; i < NUM_LEDS; i++)
     {
       // Gradient 1: clockwise rotation
-      int pos1 = (i + gradientPos1) % PortalConfig::Hardware::NUM_LEDS;
+      int pos1 = (i + gradientPos1) % NUM_LEDS;
       uint8_t bright1 = sequence1[pos1].b;
 
       // Interpolate between drivers for sequence 1
-      int nextDriver1 = (pos1 + 10) % PortalConfig::Hardware::NUM_LEDS;
-      while (sequence1[nextDriver1] == 0 && nextDriver1 != pos1)
+      int nextDriver1 = (pos1 + 10) % NUM_LEDS;
+      while (isBlack(sequence1[nextDriver1]) && nextDriver1 != pos1)
       {
-        nextDriver1 = (nextDriver1 + 1) % PortalConfig::Hardware::NUM_LEDS;
+        nextDriver1 = (nextDriver1 + 1) % NUM_LEDS;
       }
 
       if (nextDriver1 != pos1)
       {
-        int dist1 = (nextDriver1 - pos1 + PortalConfig::Hardware::NUM_LEDS) % PortalConfig::Hardware::NUM_LEDS;
-        if (dist1 > PortalConfig::Hardware::NUM_LEDS / 2)
+        int dist1 = (nextDriver1 - pos1 + NUM_LEDS) % NUM_LEDS;
+        if (dist1 > NUM_LEDS / 2)
         {
-          dist1 = PortalConfig::Hardware::NUM_LEDS - dist1;
+          dist1 = NUM_LEDS - dist1;
         }
 
-        float ratio1 = (float)(i - pos1 + PortalConfig::Hardware::NUM_LEDS) / dist1;
+        float ratio1 = (float)(i - pos1 + NUM_LEDS) / dist1;
         bright1 = (sequence1[pos1].b * (1.0f - ratio1) + sequence1[nextDriver1].b * ratio1);
       }
 
       CRGB color1 = CHSV(hue1, 255, bright1);
 
       // Gradient 2: counterclockwise rotation
-      int pos2 = (i + gradientPos2) % PortalConfig::Hardware::NUM_LEDS;
+      int pos2 = (i + gradientPos2) % NUM_LEDS;
       uint8_t bright2 = sequence2[pos2].b;
 
       // Interpolate between drivers for sequence 2
-      int nextDriver2 = (pos2 + 10 + PortalConfig::Hardware::NUM_LEDS) % PortalConfig::Hardware::NUM_LEDS;
-      while (sequence2[nextDriver2] == 0 && nextDriver2 != pos2)
+      int nextDriver2 = (pos2 + 10 + NUM_LEDS) % NUM_LEDS;
+      while (isBlack(sequence2[nextDriver2]) && nextDriver2 != pos2)
       {
-        nextDriver2 = (nextDriver2 - 1 + PortalConfig::Hardware::NUM_LEDS) % PortalConfig::Hardware::NUM_LEDS;
+        nextDriver2 = (nextDriver2 - 1 + NUM_LEDS) % NUM_LEDS;
       }
 
       if (nextDriver2 != pos2)
       {
-        int dist2 = (pos2 - nextDriver2 + PortalConfig::Hardware::NUM_LEDS) % PortalConfig::Hardware::NUM_LEDS;
-        if (dist2 > PortalConfig::Hardware::NUM_LEDS / 2)
+        int dist2 = (pos2 - nextDriver2 + NUM_LEDS) % NUM_LEDS;
+        if (dist2 > NUM_LEDS / 2)
         {
-          dist2 = PortalConfig::Hardware::NUM_LEDS - dist2;
+          dist2 = NUM_LEDS - dist2;
         }
 
-        float ratio2 = (float)(i - pos2 + PortalConfig::Hardware::NUM_LEDS) / dist2;
+        float ratio2 = (float)(i - pos2 + NUM_LEDS) / dist2;
         bright2 = (sequence2[pos2].b * (1.0f - ratio2) + sequence2[nextDriver2].b * ratio2);
       }
 
@@ -499,7 +657,7 @@ public:
         _driver->getBuffer()[i].nscale8((uint8_t)(fadeScale * 255));
     }
 
-    _driver->setBrightness(ConfigManager::getMaxBrightness());
+    _driver->setBrightness(frameConfig.maxBrightness);
     _driver->show();
   }
 };
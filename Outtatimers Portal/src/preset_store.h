@@ -0,0 +1,219 @@
+#pragma once
+
+#include "config.h"
+#include "config_manager.h"
+#include "crc16.h"
+#include "file_store.h"
+#include "led_driver.h"
+#include <stdio.h>
+
+/**
+ * @brief Saved looks: parameters plus the generated gradient, per slot
+ *
+ * A preset stores the ConfigManager parameters together with the rendered
+ * effect buffer, so recalling it streams the exact gradient back into the
+ * effect's buffer: no regeneration, no new random drivers, and the switch
+ * completes between two frames.
+ *
+ * File layout (`/presetN.bin`):
+ * ```
+ * [0..1]   'P' 'S' magic
+ * [2]      format version (1)
+ * [3]      slot
+ * [4..5]   LED count, little endian
+ * [6..10]  speed, brightness, hue min, hue max, mode
+ * [11]     reserved (0)
+ * [12..13] CRC-16 of the pixel data
+ * [14..15] CRC-16 of bytes 0..13
+ * [16..]   LED count x RGB
+ * ```
+ * Saves go to a temp file that is renamed over the slot, so an interrupted
+ * save keeps the previous preset.
+ *
+ * @example
+ * ```cpp
+ * PresetStore presets(&files, portal.getEffectBuffer(), portal.getEffectLength());
+ * presets.setRecallCallback([]() { portal.keepEffectOnStart(); });
+ * presets.save(0);
+ * presets.recall(0);
+ * ```
+ */
+class PresetStore
+{
+public:
+  typedef void (*RecallCallback)();
+
+  static constexpr int SLOT_COUNT = PortalConfig::Storage::PRESET_SLOTS;
+  static constexpr size_t HEADER_BYTES = 16;
+  static constexpr uint8_t VERSION = 1;
+
+  static_assert(sizeof(CRGB) == 3, "Presets stream raw RGB triplets into the effect buffer");
+
+  /**
+   * @brief Construct a new PresetStore
+   * @param files File store (must remain valid)
+   * @param effect Effect buffer presets are captured from and recalled into
+   * @param numLeds Length of the effect buffer
+   */
+  PresetStore(IFileStore *files, CRGB *effect, int numLeds)
+      : files_(files), effect_(effect), numLeds_(numLeds), onRecall_(nullptr) {}
+
+  /**
+   * @brief Point the store at the effect buffer once it has been allocated
+   * @param effect Effect buffer presets are captured from and recalled into
+   * @param numLeds Length of the effect buffer
+   */
+  void setBuffer(CRGB *effect, int numLeds)
+  {
+    effect_ = effect;
+    numLeds_ = numLeds;
+  }
+
+  /**
+   * @brief Set a callback run after a successful recall
+   * @param callback Function to call (e.g. to keep the buffer on start)
+   */
+  void setRecallCallback(RecallCallback callback)
+  {
+    onRecall_ = callback;
+  }
+
+  /**
+   * @brief Save the current parameters and effect buffer to a slot
+   * @param slot Slot index (0 to SLOT_COUNT-1)
+   * @return true if the preset was written
+   */
+  bool save(int slot)
+  {
+    if (!isValidSlot(slot) || effect_ == nullptr)
+      return false;
+
+    const uint8_t *pixels = reinterpret_cast<const uint8_t *>(effect_);
+    size_t pixelBytes = (size_t)numLeds_ * 3;
+    uint8_t header[HEADER_BYTES];
+    header[0] = 'P';
+    header[1] = 'S';
+    header[2] = VERSION;
+    header[3] = (uint8_t)slot;
+    header[4] = (uint8_t)(numLeds_ & 0xFF);
+    header[5] = (uint8_t)(numLeds_ >> 8);
+    header[6] = (uint8_t)ConfigManager::getRotationSpeed();
+    header[7] = ConfigManager::getMaxBrightness();
+    header[8] = ConfigManager::getHueMin();
+    header[9] = ConfigManager::getHueMax();
+    header[10] = (uint8_t)ConfigManager::getPortalMode();
+    header[11] = 0;
+    write16(header + 12, crc16(pixels, pixelBytes));
+    write16(header + 14, crc16(header, 14));
+
+    char path[PATH_BYTES];
+    slotPath(slot, path, sizeof(path));
+    const char *temp = PortalConfig::Storage::PRESET_TMP_PATH;
+    return files_->write(temp, header, HEADER_BYTES) && files_->append(temp, pixels, pixelBytes) &&
+           files_->rename(temp, path);
+  }
+
+  /**
+   * @brief Recall a preset: parameters and effect buffer
+   *
+   * The pixel data is read straight into the effect buffer. If it fails its
+   * checksum the effect is asked to regenerate and the parameters are left
+   * unchanged.
+   * @param slot Slot index
+   * @return true if the preset was applied
+   */
+  bool recall(int slot)
+  {
+    if (!isValidSlot(slot) || effect_ == nullptr)
+      return false;
+
+    char path[PATH_BYTES];
+    slotPath(slot, path, sizeof(path));
+    uint8_t header[HEADER_BYTES];
+    if (files_->read(path, 0, header, HEADER_BYTES) != HEADER_BYTES || !isValidHeader(header, slot))
+      return false;
+
+    uint8_t *pixels = reinterpret_cast<uint8_t *>(effect_);
+    size_t pixelBytes = (size_t)numLeds_ * 3;
+    if (files_->read(path, HEADER_BYTES, pixels, pixelBytes) != pixelBytes ||
+        crc16(pixels, pixelBytes) != read16(header + 12))
+    {
+      ConfigManager::requestEffectRegeneration(); // Buffer was overwritten with bad data
+      return false;
+    }
+
+    {
+      ConfigManager::Transaction transaction;
+      ConfigManager::setRotationSpeed(header[6]);
+      ConfigManager::setMaxBrightness(header[7]);
+      ConfigManager::setHueMin(header[8]);
+      ConfigManager::setHueMax(header[9]);
+      ConfigManager::setPortalMode(header[10]);
+      ConfigManager::clearEffectRegenerationFlag(); // The stored gradient already matches
+    }
+    if (onRecall_)
+      onRecall_();
+    return true;
+  }
+
+  /**
+   * @brief Check whether a slot holds a preset for this ring
+   */
+  bool exists(int slot)
+  {
+    if (!isValidSlot(slot))
+      return false;
+    char path[PATH_BYTES];
+    slotPath(slot, path, sizeof(path));
+    uint8_t header[HEADER_BYTES];
+    return files_->read(path, 0, header, HEADER_BYTES) == HEADER_BYTES && isValidHeader(header, slot);
+  }
+
+  /**
+   * @brief Delete a preset
+   * @return true if the slot was cleared
+   */
+  bool remove(int slot)
+  {
+    if (!isValidSlot(slot))
+      return false;
+    char path[PATH_BYTES];
+    slotPath(slot, path, sizeof(path));
+    return files_->remove(path);
+  }
+
+  static bool isValidSlot(int slot) { return slot >= 0 && slot < SLOT_COUNT; }
+
+  /**
+   * @brief File path of a slot
+   */
+  static void slotPath(int slot, char *out, size_t size)
+  {
+    snprintf(out, size, PortalConfig::Storage::PRESET_PATH_FORMAT, slot);
+  }
+
+private:
+  static constexpr size_t PATH_BYTES = 24;
+
+  IFileStore *files_;
+  CRGB *effect_;
+  int numLeds_;
+  RecallCallback onRecall_;
+
+  bool isValidHeader(const uint8_t *header, int slot) const
+  {
+    return header[0] == 'P' && header[1] == 'S' && header[2] == VERSION && header[3] == slot &&
+           (header[4] | (header[5] << 8)) == numLeds_ && crc16(header, 14) == read16(header + 14);
+  }
+
+  static void write16(uint8_t *p, uint16_t v)
+  {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+  }
+
+  static uint16_t read16(const uint8_t *p)
+  {
+    return (uint16_t)(p[0] | (p[1] << 8));
+  }
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Fixed-capacity queue ordered by priority, FIFO within a priority
+ *
+ * Lower priority values are more urgent and are popped first. Items are
+ * kept sorted on insertion, which is cheap for the handful of entries an
+ * input queue holds. When full, a new item evicts the newest item of a
+ * less urgent priority; if there is none, the new item itself is dropped.
+ * Either way the loss is counted.
+ *
+ * @tparam T Trivially copyable item type
+ * @tparam CAPACITY Maximum number of items
+ */
+template <typename T, int CAPACITY>
+class PriorityQueue
+{
+public:
+  static_assert(CAPACITY > 0 && CAPACITY <= 255, "Counts are 8 bits wide");
+
+  PriorityQueue() : count_(0), dropped_(0) {}
+
+  /**
+   * @brief Insert an item behind all items of the same or a more urgent priority
+   * @return false if the item was dropped because the queue was full
+   */
+  bool push(const T &item, uint8_t priority)
+  {
+    int position = count_;
+    while (position > 0 && priorities_[position - 1] > priority)
+      position--;
+
+    if (count_ == CAPACITY)
+    {
+      dropped_++;
+      if (position == CAPACITY)
+        return false;
+      count_--; // Evict the least urgent, newest item
+    }
+
+    for (int i = count_; i > position; i--)
+    {
+      items_[i] = items_[i - 1];
+      priorities_[i] = priorities_[i - 1];
+    }
+    items_[position] = item;
+    priorities_[position] = priority;
+    count_++;
+    return true;
+  }
+
+  /**
+   * @brief Remove the most urgent, oldest item
+   * @return false if the queue was empty
+   */
+  bool pop(T &item)
+  {
+    if (count_ == 0)
+      return false;
+    item = items_[0];
+    removeAt(0);
+    return true;
+  }
+
+  /**
+   * @brief Index of the newest item matching a predicate
+   * @return Index for removeAt(), -1 if none matches
+   */
+  template <typename Match>
+  int findLast(Match match) const
+  {
+    for (int i = count_ - 1; i >= 0; i--)
+    {
+      if (match(items_[i]))
+        return i;
+    }
+    return -1;
+  }
+
+  void removeAt(int index)
+  {
+    for (int i = index; i < count_ - 1; i++)
+    {
+      items_[i] = items_[i + 1];
+      priorities_[i] = priorities_[i + 1];
+    }
+    count_--;
+  }
+
+  bool isEmpty() const { return count_ == 0; }
+  size_t size() const { return count_; }
+  static constexpr size_t capacity() { return CAPACITY; }
+
+  /**
+   * @brief Items dropped or evicted because the queue was full
+   */
+  uint32_t getDroppedCount() const { return dropped_; }
+
+private:
+  T items_[CAPACITY];
+  uint8_t priorities_[CAPACITY];
+  uint8_t count_;
+  uint32_t dropped_;
+};
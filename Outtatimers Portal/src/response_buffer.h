@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @brief Fixed-capacity text buffer for HTTP responses
+ *
+ * Replaces String concatenation in the request handlers so formatting a
+ * response never touches the heap. (ESP8266WebServer itself still builds
+ * short-lived Strings for the request arguments and the reply it sends.)
+ * Text that does not fit is cut off and the buffer remembers that it
+ * overflowed.
+ *
+ * @example
+ * ```cpp
+ * ResponseBuffer<128> json;
+ * json.append("{\"speed\":").appendf("%d", speed).append("}");
+ * server.send(200, "application/json", json.c_str());
+ * ```
+ */
+template <size_t CAPACITY>
+class ResponseBuffer
+{
+public:
+  static_assert(CAPACITY > 1, "Response buffer needs room for text and terminator");
+
+  ResponseBuffer() { clear(); }
+
+  /**
+   * @brief Empty the buffer for the next response
+   */
+  void clear()
+  {
+    length_ = 0;
+    overflowed_ = false;
+    data_[0] = '\0';
+  }
+
+  /**
+   * @brief Append literal text
+   */
+  ResponseBuffer &append(const char *text)
+  {
+    size_t n = strlen(text);
+    size_t room = CAPACITY - 1 - length_;
+    if (n > room)
+    {
+      n = room;
+      overflowed_ = true;
+    }
+    memcpy(data_ + length_, text, n);
+    length_ += n;
+    data_[length_] = '\0';
+    return *this;
+  }
+
+  /**
+   * @brief Append printf-formatted text
+   */
+  ResponseBuffer &appendf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+  {
+    size_t room = CAPACITY - length_;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(data_ + length_, room, format, args);
+    va_end(args);
+    if (n < 0)
+      n = 0;
+    if ((size_t)n >= room)
+    {
+      n = (int)(room - 1);
+      overflowed_ = true;
+    }
+    length_ += (size_t)n;
+    return *this;
+  }
+
+  const char *c_str() const { return data_; }
+  size_t length() const { return length_; }
+  bool overflowed() const { return overflowed_; }
+
+private:
+  char data_[CAPACITY];
+  size_t length_;
+  bool overflowed_;
+};
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "config.h"
+#include "input_manager.h"
+#include "serial_port.h"
+
+/**
+ * @brief Framed binary command input source for a show PC on USB serial
+ *
+ * Parses frames byte by byte as they arrive, so a partial frame simply
+ * waits for the next update() and nothing ever blocks. Commands are queued
+ * as Pressed events like every other source; rapid parameter updates (a
+ * fader sending 200 per second) are coalesced by InputManager.
+ *
+ * Frame layout:
+ * ```
+ * [0]      0xA5 sync
+ * [1]      frame type
+ * [2]      payload length N (0-32)
+ * [3..]    payload
+ * [3+N]    CRC-8 (polynomial 0x07, initial 0) over type, length and payload
+ * ```
+ * Frame types (multi-byte values little endian):
+ * - COMMAND (0x01): command byte (InputManager::Command value); parameter
+ *   commands append two signed 16-bit arguments (5 bytes). Not answered.
+ * - QUERY (0x02): no payload. Answered with STATE (0x82), whose payload is
+ *   written by the state writer.
+ * - PING (0x03): any payload. Answered with PONG (0x83) echoing it.
+ * - REJECT (0x7F): sent for a well-formed frame that was refused; the
+ *   payload is the refused frame type and an Error code.
+ *
+ * Corrupt frames are counted and dropped; the parser resynchronizes on the
+ * next sync byte, so log text on the same port is skipped as well. When
+ * the event queue is full no more bytes are read until it drains, leaving
+ * them in the UART buffer instead of losing commands.
+ *
+ * @example
+ * ```cpp
+ * HardwareSerialPort port(Serial);
+ * SerialCommandSource console(&port);
+ * console.setStateWriter(writeState);
+ * inputManager.addInputSource(&console);
+ * ```
+ */
+class SerialCommandSource : public IInputSource
+{
+public:
+  static constexpr uint8_t SYNC = 0xA5;
+  static constexpr uint8_t COMMAND = 0x01;
+  static constexpr uint8_t QUERY = 0x02;
+  static constexpr uint8_t PING = 0x03;
+  static constexpr uint8_t STATE = 0x82;
+  static constexpr uint8_t PONG = 0x83;
+  static constexpr uint8_t REJECT = 0x7F;
+  static constexpr size_t MAX_PAYLOAD = 32;
+  static constexpr size_t MAX_FRAME_BYTES = MAX_PAYLOAD + 4;
+
+  enum class Error : uint8_t
+  {
+    UnknownType = 1, ///< Frame type not understood
+    BadCommand = 2   ///< Unknown command or wrong payload length for it
+  };
+
+  /**
+   * @brief Writes the STATE payload
+   * @param payload Output buffer
+   * @param capacity Size of the output buffer (MAX_PAYLOAD)
+   * @return Number of bytes written
+   */
+  using StateWriter = size_t (*)(uint8_t *payload, size_t capacity);
+
+  /**
+   * @brief Construct a new SerialCommandSource
+   * @param port Serial port to read (must remain valid)
+   */
+  explicit SerialCommandSource(ISerialPort *port)
+      : port_(port), stateWriter_(nullptr), parseState_(ParseState::Sync), type_(0), length_(0), received_(0), crc_(0),
+        frameCount_(0), checksumErrorCount_(0), rejectedCount_(0), replyDroppedCount_(0), eventQueueHead_(0),
+        eventQueueTail_(0) {}
+
+  /**
+   * @brief Set the function that answers state queries
+   * @param writer State writer, nullptr to answer with an empty payload
+   */
+  void setStateWriter(StateWriter writer)
+  {
+    stateWriter_ = writer;
+  }
+
+  bool update(unsigned long currentTime) override
+  {
+    uint8_t byte;
+    for (int i = 0; i < PortalConfig::SerialConsole::MAX_BYTES_PER_UPDATE && !isQueueFull() &&
+                    port_->read(&byte, 1) == 1;
+         i++)
+      parse(byte, currentTime);
+    return hasEvents();
+  }
+
+  bool hasEvents() const override
+  {
+    return eventQueueHead_ != eventQueueTail_;
+  }
+
+  InputEvent getNextEvent() override
+  {
+    if (!hasEvents())
+    {
+      return {0, EventType::Released, 0, "none"};
+    }
+
+    InputEvent event = eventQueue_[eventQueueHead_];
+    eventQueueHead_ = (eventQueueHead_ + 1) % MAX_EVENTS;
+    return event;
+  }
+
+  const char *getSourceName() const override
+  {
+    return "Serial";
+  }
+
+  /**
+   * @brief Encode a frame (used by senders and tests)
+   * @param type Frame type
+   * @param payload Payload bytes
+   * @param length Payload length (at most MAX_PAYLOAD)
+   * @param out Output buffer of at least length + 4 bytes
+   * @return Frame size in bytes
+   */
+  static size_t encode(uint8_t type, const uint8_t *payload, size_t length, uint8_t *out)
+  {
+    out[0] = SYNC;
+    out[1] = type;
+    out[2] = (uint8_t)length;
+    uint8_t crc = crc8(crc8(0, type), (uint8_t)length);
+    for (size_t i = 0; i < length; i++)
+    {
+      out[3 + i] = payload[i];
+      crc = crc8(crc, payload[i]);
+    }
+    out[3 + length] = crc;
+    return length + 4;
+  }
+
+  /**
+   * @brief Encode a COMMAND frame (used by senders and tests)
+   * @param command Command to send
+   * @param arg1 First argument (parameter commands only)
+   * @param arg2 Second argument (parameter commands only)
+   * @param out Output buffer of at least 9 bytes
+   * @return Frame size in bytes
+   */
+  static size_t encodeCommand(InputManager::Command command, int16_t arg1, int16_t arg2, uint8_t *out)
+  {
+    uint8_t payload[5] = {static_cast<uint8_t>(command), (uint8_t)((uint16_t)arg1 & 0xFF),
+                          (uint8_t)((uint16_t)arg1 >> 8), (uint8_t)((uint16_t)arg2 & 0xFF),
+                          (uint8_t)((uint16_t)arg2 >> 8)};
+    return encode(COMMAND, payload, InputManager::isParameterCommand(command) ? 5 : 1, out);
+  }
+
+  /**
+   * @brief CRC-8 step, polynomial 0x07
+   */
+  static uint8_t crc8(uint8_t crc, uint8_t byte)
+  {
+    crc ^= byte;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    return crc;
+  }
+
+  unsigned long getFrameCount() const { return frameCount_; }
+  unsigned long getChecksumErrorCount() const { return checksumErrorCount_; }
+  unsigned long getRejectedCount() const { return rejectedCount_; }
+
+  /**
+   * @brief Replies not sent because the transmit buffer was full
+   */
+  unsigned long getReplyDroppedCount() const { return replyDroppedCount_; }
+
+private:
+  static constexpr int MAX_EVENTS = 16;
+
+  enum class ParseState : uint8_t
+  {
+    Sync,
+    Type,
+    Length,
+    Payload,
+    Checksum
+  };
+
+  ISerialPort *port_;
+  StateWriter stateWriter_;
+  ParseState parseState_;
+  uint8_t type_;
+  uint8_t length_;
+  uint8_t received_;
+  uint8_t crc_;
+  uint8_t payload_[MAX_PAYLOAD];
+  unsigned long frameCount_;
+  unsigned long checksumErrorCount_;
+  unsigned long rejectedCount_;
+  unsigned long replyDroppedCount_;
+
+  InputEvent eventQueue_[MAX_EVENTS];
+  int eventQueueHead_;
+  int eventQueueTail_;
+
+  void parse(uint8_t byte, unsigned long now)
+  {
+    switch (parseState_)
+    {
+    case ParseState::Sync:
+      if (byte == SYNC)
+        parseState_ = ParseState::Type;
+      break;
+    case ParseState::Type:
+      type_ = byte;
+      crc_ = crc8(0, byte);
+      parseState_ = ParseState::Length;
+      break;
+    case ParseState::Length:
+      if (byte > MAX_PAYLOAD)
+      {
+        checksumErrorCount_++; // No valid frame is this long: corrupt header
+        parseState_ = byte == SYNC ? ParseState::Type : ParseState::Sync;
+        break;
+      }
+      length_ = byte;
+      received_ = 0;
+      crc_ = crc8(crc_, byte);
+      parseState_ = length_ > 0 ? ParseState::Payload : ParseState::Checksum;
+      break;
+    case ParseState::Payload:
+      payload_[received_++] = byte;
+      crc_ = crc8(crc_, byte);
+      if (received_ == length_)
+        parseState_ = ParseState::Checksum;
+      break;
+    case ParseState::Checksum:
+      parseState_ = ParseState::Sync;
+      if (byte != crc_)
+      {
+        checksumErrorCount_++;
+        break;
+      }
+      frameCount_++;
+      handleFrame(now);
+      break;
+    }
+  }
+
+  void handleFrame(unsigned long now)
+  {
+    switch (type_)
+    {
+    case COMMAND:
+      handleCommand(now);
+      break;
+    case QUERY:
+    {
+      uint8_t state[MAX_PAYLOAD];
+      size_t length = stateWriter_ ? stateWriter_(state, sizeof(state)) : 0;
+      if (length > sizeof(state))
+        length = sizeof(state);
+      sendFrame(STATE, state, length);
+      break;
+    }
+    case PING:
+      sendFrame(PONG, payload_, length_);
+      break;
+    default:
+      reject(Error::UnknownType);
+      break;
+    }
+  }
+
+  void handleCommand(unsigned long now)
+  {
+    if (length_ == 0 || !InputManager::isValidCommand(payload_[0]) ||
+        length_ != (InputManager::isParameterCommand(static_cast<InputManager::Command>(payload_[0])) ? 5 : 1))
+    {
+      reject(Error::BadCommand);
+      return;
+    }
+
+    bool isParameter = length_ == 5;
+    queueEvent({.inputId = payload_[0],
+                .type = EventType::Pressed,
+                .timestamp = now,
+                .sourceName = "Serial",
+                .arg1 = isParameter ? (int16_t)(payload_[1] | (payload_[2] << 8)) : (int16_t)0,
+                .arg2 = isParameter ? (int16_t)(payload_[3] | (payload_[4] << 8)) : (int16_t)0});
+  }
+
+  void reject(Error error)
+  {
+    rejectedCount_++;
+    uint8_t payload[2] = {type_, static_cast<uint8_t>(error)};
+    sendFrame(REJECT, payload, sizeof(payload));
+  }
+
+  void sendFrame(uint8_t type, const uint8_t *payload, size_t length)
+  {
+    uint8_t frame[MAX_FRAME_BYTES];
+    size_t size = encode(type, payload, length, frame);
+    if (port_->availableForWrite() < (int)size)
+    {
+      replyDroppedCount_++; // Never wait for the UART; the host retries its query
+      return;
+    }
+    port_->write(frame, size);
+  }
+
+  bool isQueueFull() const
+  {
+    return (eventQueueTail_ + 1) % MAX_EVENTS == eventQueueHead_;
+  }
+
+  void queueEvent(const InputEvent &event)
+  {
+    // update() stops reading while the queue is full, so this always fits
+    eventQueue_[eventQueueTail_] = event;
+    eventQueueTail_ = (eventQueueTail_ + 1) % MAX_EVENTS;
+  }
+};
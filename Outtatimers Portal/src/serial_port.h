@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef UNIT_TEST
+#include <Arduino.h>
+#endif
+
+/**
+ * @brief Minimal non-blocking byte stream used by the serial input sources
+ *
+ * Mirrors the subset of the Arduino `HardwareSerial` API the sources need so
+ * they can run against the UART on the device and against a pseudo-terminal
+ * on the host (see test/posix_serial_port.h). Neither call ever waits.
+ */
+class ISerialPort
+{
+public:
+  /**
+   * @brief Read bytes that have already arrived
+   * @param buffer Destination buffer
+   * @param length Maximum number of bytes to read
+   * @return Number of bytes read, 0 if none are pending
+   */
+  virtual int read(uint8_t *buffer, size_t length) = 0;
+
+  /**
+   * @brief Bytes that write() accepts without waiting
+   */
+  virtual int availableForWrite() = 0;
+
+  /**
+   * @brief Queue bytes for transmission
+   * @param data Bytes to send
+   * @param length Number of bytes, at most availableForWrite()
+   * @return Number of bytes queued
+   */
+  virtual size_t write(const uint8_t *data, size_t length) = 0;
+
+  virtual ~ISerialPort() {}
+};
+
+#ifndef UNIT_TEST
+
+/**
+ * @brief HardwareSerial-backed port for the ESP8266 UART
+ */
+class HardwareSerialPort : public ISerialPort
+{
+public:
+  explicit HardwareSerialPort(HardwareSerial &serial) : serial_(serial) {}
+
+  int read(uint8_t *buffer, size_t length) override
+  {
+    int n = 0;
+    while ((size_t)n < length && serial_.available() > 0)
+      buffer[n++] = (uint8_t)serial_.read();
+    return n;
+  }
+
+  int availableForWrite() override { return serial_.availableForWrite(); }
+  size_t write(const uint8_t *data, size_t length) override { return serial_.write(data, length); }
+
+private:
+  HardwareSerial &serial_;
+};
+
+#endif
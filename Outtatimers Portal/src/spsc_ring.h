@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef UNIT_TEST
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#else
+#include <Arduino.h>
+#endif
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer
+ *
+ * Meant for handing data from an interrupt handler to loop(): the ISR only
+ * writes the tail, loop() only writes the head, so neither side needs to
+ * disable interrupts. Signal fences order the slot write before the index
+ * update (the ESP8266 is single core, so no hardware barrier is needed).
+ *
+ * One slot is kept free to tell full from empty, so the ring holds SIZE - 1
+ * items. When full, push() drops the new item and counts it.
+ *
+ * @tparam T Trivially copyable item type
+ * @tparam SIZE Number of slots, a power of two
+ */
+template <typename T, size_t SIZE>
+class SpscRing
+{
+public:
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "Ring size must be a power of two");
+  static_assert(SIZE <= 256, "Indices are 8 bits wide so the ISR updates them atomically");
+
+  SpscRing() : head_(0), tail_(0), dropped_(0) {}
+
+  /**
+   * @brief Add an item (producer side, ISR safe)
+   * @return false if the ring was full and the item was dropped
+   */
+  bool IRAM_ATTR push(const T &item)
+  {
+    uint8_t tail = tail_;
+    uint8_t next = (uint8_t)((tail + 1) & MASK);
+    if (next == head_)
+    {
+      dropped_ = dropped_ + 1;
+      return false;
+    }
+    slots_[tail] = item;
+    std::atomic_signal_fence(std::memory_order_release);
+    tail_ = next;
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest item (consumer side)
+   * @return false if the ring was empty
+   */
+  bool pop(T &item)
+  {
+    uint8_t head = head_;
+    if (head == tail_)
+      return false;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    item = slots_[head];
+    std::atomic_signal_fence(std::memory_order_release);
+    head_ = (uint8_t)((head + 1) & MASK);
+    return true;
+  }
+
+  bool isEmpty() const { return head_ == tail_; }
+  size_t size() const { return (size_t)((tail_ - head_) & MASK); }
+  static constexpr size_t capacity() { return SIZE - 1; }
+
+  /**
+   * @brief Items dropped because the ring was full
+   */
+  uint32_t getDroppedCount() const { return dropped_; }
+
+private:
+  static constexpr uint8_t MASK = (uint8_t)(SIZE - 1);
+
+  T slots_[SIZE];
+  volatile uint8_t head_;
+  volatile uint8_t tail_;
+  volatile uint32_t dropped_;
+};
@@ -10,7 +10,9 @@
 #ifndef STATUS_LED_H
 #define STATUS_LED_H
 
+#ifndef UNIT_TEST
 #include <Arduino.h>
+#endif
 #include "config.h"
 
 /**
@@ -0,0 +1,297 @@
+#pragma once
+
+#include "config.h"
+#include "input_manager.h"
+#include "udp_transport.h"
+
+/**
+ * @brief Single-datagram UDP cue trigger input source
+ *
+ * Accepts the same InputManager::Command values as the HTTP endpoints, but
+ * without TCP handshakes or HTTP parsing: one 10-byte datagram per cue is
+ * turned into a queued Pressed event on the next loop() iteration.
+ *
+ * Datagram layout (little endian):
+ * ```
+ * [0..1] 'O' 'T' magic
+ * [2]    protocol version (2)
+ * [3]    command (InputManager::Command value)
+ * [4..7] sequence number
+ * [8..9] session id (chosen at random each time the sender starts)
+ * ```
+ * Parameter commands (SetSpeed, SetBrightness, SetHue, SetMode) use a
+ * 14-byte datagram with two signed 16-bit arguments appended:
+ * ```
+ * [10..11] arg1 (value, hue min, mode)
+ * [12..13] arg2 (hue max)
+ * ```
+ *
+ * Senders may repeat a datagram to survive packet loss; duplicates are
+ * dropped using a 32-entry sliding window over sequence numbers, kept per
+ * session id for the SESSIONS most recently heard sessions. Several senders
+ * on stage each keep their own window, and a restarted sender that numbers
+ * its cues from 1 again under a new session id is not mistaken for
+ * duplicates. A sequence far behind the window of its session is too old to
+ * tell apart and is treated as a duplicate.
+ * Each accepted or duplicate datagram is acknowledged by echoing it back
+ * with the version byte's high bit set, so senders can measure round trips.
+ * A new cue that finds the event queue full is dropped without an
+ * acknowledgement, so the sender repeats it.
+ *
+ * @example
+ * ```cpp
+ * WiFiUdpTransport udp;
+ * UdpCommandSource cues(&udp);
+ * cues.begin(PortalConfig::WiFi::CUE_UDP_PORT);
+ * inputManager.addInputSource(&cues);
+ * ```
+ */
+class UdpCommandSource : public IInputSource
+{
+public:
+  static constexpr size_t DATAGRAM_BYTES = 10;
+  static constexpr size_t PARAM_DATAGRAM_BYTES = 14;
+  static constexpr uint8_t VERSION = 2;
+  static constexpr uint8_t ACK_FLAG = 0x80;
+  static constexpr uint32_t WINDOW = 32;
+  static constexpr int SESSIONS = 4;
+
+  /**
+   * @brief Construct a new UdpCommandSource
+   * @param transport UDP transport to receive on (must remain valid)
+   */
+  explicit UdpCommandSource(IUdpTransport *transport)
+      : transport_(transport), eventQueueHead_(0), eventQueueTail_(0), sessions_(), useCounter_(0), acceptedCount_(0),
+        duplicateCount_(0), rejectedCount_(0), droppedCount_(0) {}
+
+  /**
+   * @brief Start listening for cue datagrams
+   * @param port UDP port
+   * @return true if the socket was opened
+   */
+  bool begin(uint16_t port = PortalConfig::WiFi::CUE_UDP_PORT)
+  {
+    return transport_ && transport_->begin(port);
+  }
+
+  bool update(unsigned long currentTime) override
+  {
+    for (int i = 0; i < MAX_EVENTS; i++)
+    {
+      int size = transport_->parsePacket();
+      if (size <= 0)
+        break;
+      handleDatagram(size, currentTime);
+    }
+    return hasEvents();
+  }
+
+  bool hasEvents() const override
+  {
+    return eventQueueHead_ != eventQueueTail_;
+  }
+
+  InputEvent getNextEvent() override
+  {
+    if (!hasEvents())
+    {
+      return {0, EventType::Released, 0, "none"};
+    }
+
+    InputEvent event = eventQueue_[eventQueueHead_];
+    eventQueueHead_ = (eventQueueHead_ + 1) % MAX_EVENTS;
+    return event;
+  }
+
+  const char *getSourceName() const override
+  {
+    return "UdpCue";
+  }
+
+  /**
+   * @brief Encode a cue datagram (used by senders and tests)
+   * @param command Command to trigger
+   * @param session Session id of the sender run
+   * @param sequence Sequence number (increment once per cue, not per repeat)
+   * @param out Output buffer of DATAGRAM_BYTES
+   */
+  static void encode(InputManager::Command command, uint16_t session, uint32_t sequence, uint8_t *out)
+  {
+    out[0] = 'O';
+    out[1] = 'T';
+    out[2] = VERSION;
+    out[3] = static_cast<uint8_t>(command);
+    out[4] = (uint8_t)(sequence & 0xFF);
+    out[5] = (uint8_t)((sequence >> 8) & 0xFF);
+    out[6] = (uint8_t)((sequence >> 16) & 0xFF);
+    out[7] = (uint8_t)(sequence >> 24);
+    out[8] = (uint8_t)(session & 0xFF);
+    out[9] = (uint8_t)(session >> 8);
+  }
+
+  /**
+   * @brief Encode a parameter datagram (used by senders and tests)
+   * @param command Parameter command to send
+   * @param session Session id of the sender run
+   * @param sequence Sequence number
+   * @param arg1 First argument
+   * @param arg2 Second argument
+   * @param out Output buffer of PARAM_DATAGRAM_BYTES
+   */
+  static void encode(InputManager::Command command, uint16_t session, uint32_t sequence, int16_t arg1, int16_t arg2,
+                     uint8_t *out)
+  {
+    encode(command, session, sequence, out);
+    out[10] = (uint8_t)((uint16_t)arg1 & 0xFF);
+    out[11] = (uint8_t)((uint16_t)arg1 >> 8);
+    out[12] = (uint8_t)((uint16_t)arg2 & 0xFF);
+    out[13] = (uint8_t)((uint16_t)arg2 >> 8);
+  }
+
+  unsigned long getAcceptedCount() const { return acceptedCount_; }
+  unsigned long getDuplicateCount() const { return duplicateCount_; }
+  unsigned long getRejectedCount() const { return rejectedCount_; }
+  /**
+   * @brief New cues dropped (and not acknowledged) because the queue was full
+   */
+  unsigned long getDroppedCount() const { return droppedCount_; }
+
+private:
+  static constexpr int MAX_EVENTS = 8;
+
+  /**
+   * @brief Dedup window of one sender session
+   */
+  struct Session
+  {
+    bool used;
+    uint16_t id;
+    uint32_t highestSequence;
+    uint32_t window;  ///< Bit i set = highestSequence - i already seen
+    uint32_t lastUse; ///< useCounter_ when last heard, for eviction
+  };
+
+  IUdpTransport *transport_;
+  InputEvent eventQueue_[MAX_EVENTS];
+  int eventQueueHead_;
+  int eventQueueTail_;
+  Session sessions_[SESSIONS];
+  uint32_t useCounter_;
+  unsigned long acceptedCount_;
+  unsigned long duplicateCount_;
+  unsigned long rejectedCount_;
+  unsigned long droppedCount_;
+
+  void handleDatagram(int size, unsigned long now)
+  {
+    uint8_t datagram[PARAM_DATAGRAM_BYTES];
+    bool isParameter = size == (int)PARAM_DATAGRAM_BYTES;
+    if ((size != (int)DATAGRAM_BYTES && !isParameter) || transport_->read(datagram, size) != size ||
+        datagram[0] != 'O' || datagram[1] != 'T' || datagram[2] != VERSION ||
+        !InputManager::isValidCommand(datagram[3]) ||
+        isParameter != InputManager::isParameterCommand(static_cast<InputManager::Command>(datagram[3])))
+    {
+      rejectedCount_++;
+      return;
+    }
+
+    uint32_t sequence = (uint32_t)datagram[4] | ((uint32_t)datagram[5] << 8) |
+                        ((uint32_t)datagram[6] << 16) | ((uint32_t)datagram[7] << 24);
+    uint16_t session = (uint16_t)(datagram[8] | (datagram[9] << 8));
+    bool fresh = isFresh(session, sequence);
+    if (fresh && isQueueFull())
+    {
+      // Not marked and not acknowledged: the sender's repeat gets another chance
+      droppedCount_++;
+      return;
+    }
+
+    datagram[2] |= ACK_FLAG;
+    transport_->send(transport_->remoteIP(), transport_->remotePort(), datagram, size);
+
+    if (!fresh)
+    {
+      duplicateCount_++;
+      return;
+    }
+
+    markSequence(session, sequence);
+    acceptedCount_++;
+    queueEvent({.inputId = datagram[3],
+                .type = EventType::Pressed,
+                .timestamp = now,
+                .sourceName = "UdpCue",
+                .arg1 = isParameter ? (int16_t)(datagram[10] | (datagram[11] << 8)) : (int16_t)0,
+                .arg2 = isParameter ? (int16_t)(datagram[12] | (datagram[13] << 8)) : (int16_t)0});
+  }
+
+  Session *findSession(uint16_t id)
+  {
+    for (Session &s : sessions_)
+    {
+      if (s.used && s.id == id)
+        return &s;
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Check a sequence number against the dedup window of its session
+   * @return true if the sequence has not been seen before
+   */
+  bool isFresh(uint16_t session, uint32_t sequence)
+  {
+    const Session *s = findSession(session);
+    if (s == nullptr)
+      return true;
+    int32_t ahead = (int32_t)(sequence - s->highestSequence);
+    if (ahead > 0)
+      return true;
+    uint32_t behind = (uint32_t)(-ahead);
+    return behind < WINDOW && !(s->window & (1u << behind));
+  }
+
+  /**
+   * @brief Record a fresh sequence number in the dedup window of its session
+   * @param session Session id; an unknown one takes the least recently heard slot
+   * @param sequence Sequence number within the session
+   */
+  void markSequence(uint16_t session, uint32_t sequence)
+  {
+    Session *s = findSession(session);
+    if (s == nullptr)
+    {
+      s = &sessions_[0];
+      for (Session &candidate : sessions_)
+      {
+        if (!candidate.used || candidate.lastUse < s->lastUse)
+          s = &candidate;
+        if (!candidate.used)
+          break;
+      }
+      *s = {true, session, sequence, 1, 0};
+    }
+    s->lastUse = ++useCounter_;
+
+    int32_t ahead = (int32_t)(sequence - s->highestSequence);
+    if (ahead > 0)
+    {
+      s->window = (uint32_t)ahead >= WINDOW ? 0 : s->window << ahead;
+      s->window |= 1;
+      s->highestSequence = sequence;
+    }
+    else
+      s->window |= 1u << (uint32_t)(-ahead);
+  }
+
+  bool isQueueFull() const
+  {
+    return (eventQueueTail_ + 1) % MAX_EVENTS == eventQueueHead_;
+  }
+
+  void queueEvent(const InputEvent &event)
+  {
+    eventQueue_[eventQueueTail_] = event;
+    eventQueueTail_ = (eventQueueTail_ + 1) % MAX_EVENTS;
+  }
+};
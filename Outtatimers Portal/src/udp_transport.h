@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef UNIT_TEST
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#endif
+
+/**
+ * @brief Minimal datagram transport used by the UDP input sources
+ *
+ * Mirrors the subset of the Arduino `UDP` API the sources need so they can
+ * run against WiFiUDP on the device and against POSIX sockets on the host
+ * (see test/posix_udp_transport.h). Reading is incremental: parsePacket()
+ * selects the next datagram and read() consumes it piecewise, which lets a
+ * source copy payload bytes straight into their final destination.
+ *
+ * IPv4 addresses are passed as uint32_t in network byte order, the same
+ * layout IPAddress uses internally.
+ */
+class IUdpTransport
+{
+public:
+  static constexpr uint32_t BROADCAST_IP = 0xFFFFFFFFu;
+
+  /**
+   * @brief Start listening on a local port
+   * @param port UDP port to bind
+   * @return true on success
+   */
+  virtual bool begin(uint16_t port) = 0;
+
+  /**
+   * @brief Stop listening and release the socket
+   */
+  virtual void stop() = 0;
+
+  /**
+   * @brief Select the next pending datagram (non-blocking)
+   * @return Size of the datagram in bytes, 0 if none is pending
+   */
+  virtual int parsePacket() = 0;
+
+  /**
+   * @brief Read bytes from the current datagram
+   * @param buffer Destination buffer
+   * @param length Maximum number of bytes to read
+   * @return Number of bytes read
+   */
+  virtual int read(uint8_t *buffer, size_t length) = 0;
+
+  /**
+   * @brief Source address of the current datagram
+   */
+  virtual uint32_t remoteIP() const = 0;
+
+  /**
+   * @brief Source port of the current datagram
+   */
+  virtual uint16_t remotePort() const = 0;
+
+  /**
+   * @brief Send a single datagram
+   * @param ip Destination address (network byte order)
+   * @param port Destination port
+   * @param data Payload
+   * @param length Payload length
+   * @return true if the datagram was handed to the network stack
+   */
+  virtual bool send(uint32_t ip, uint16_t port, const uint8_t *data, size_t length) = 0;
+
+  virtual ~IUdpTransport() {}
+};
+
+#ifndef UNIT_TEST
+
+/**
+ * @brief WiFiUDP-backed transport for the ESP8266
+ */
+class WiFiUdpTransport : public IUdpTransport
+{
+public:
+  bool begin(uint16_t port) override { return udp_.begin(port) == 1; }
+  void stop() override { udp_.stop(); }
+  int parsePacket() override { return udp_.parsePacket(); }
+  int read(uint8_t *buffer, size_t length) override { return udp_.read(buffer, length); }
+  uint32_t remoteIP() const override { return (uint32_t)const_cast<WiFiUDP &>(udp_).remoteIP(); }
+  uint16_t remotePort() const override { return const_cast<WiFiUDP &>(udp_).remotePort(); }
+  bool send(uint32_t ip, uint16_t port, const uint8_t *data, size_t length) override
+  {
+    if (!udp_.beginPacket(IPAddress(ip), port))
+      return false;
+    udp_.write(data, length);
+    return udp_.endPacket() == 1;
+  }
+
+private:
+  WiFiUDP udp_;
+};
+
+#endif
@@ -3,13 +3,32 @@
 #include "input_manager.h"
 #include "status_led.h"
 #include "config_manager.h"
+#include "frame_preview.h"
+#include "cue_timeline.h"
+#include "udp_command_source.h"
+#include "preset_store.h"
+#include "led_arena.h"
+#include "heap_monitor.h"
+#include "latency_tracer.h"
+#include "response_buffer.h"
 
 #ifndef UNIT_TEST
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #include <LittleFS.h>
 #else
+#include <functional>
+#include <stdlib.h>
+#include <string>
+
 // Mock classes for unit testing
+class String : public std::string
+{
+public:
+  String(const char *text = "") : std::string(text) {}
+  long toInt() const { return atol(c_str()); }
+};
+
 class ESP8266WebServer
 {
 public:
@@ -17,7 +36,9 @@ public:
   void begin() {}
   void handleClient() {}
   void on(const char *path, std::function<void()> handler) {}
+  void sendHeader(const char *name, const char *value) {}
   void send(int code, const char *type, const char *content) {}
+  void send(int code, const char *type, const uint8_t *content, size_t length) {}
   bool hasArg(const char *name) { return false; }
   String arg(const char *name) { return ""; }
 };
@@ -50,7 +71,64 @@ public:
    * @param port HTTP server port (default: 80)
    */
   explicit WiFiInputSource(int port = 80)
-      : server_(port), eventQueueHead_(0), eventQueueTail_(0), isConnected_(false) {}
+      : server_(port), eventQueueHead_(0), eventQueueTail_(0), droppedCount_(0), isConnected_(false), preview_(nullptr), timeline_(nullptr),
+        presets_(nullptr), arena_(nullptr), latency_(nullptr), inputs_(nullptr), udpCues_(nullptr) {}
+
+  /**
+   * @brief Attach a frame preview to serve on /preview
+   * @param preview Preview encoder (must remain valid); call before begin()
+   */
+  void attachPreview(FramePreview *preview)
+  {
+    preview_ = preview;
+  }
+
+  /**
+   * @brief Attach a cue timeline to control on /timeline
+   * @param timeline Cue timeline (must remain valid); call before begin()
+   */
+  void attachTimeline(CueTimeline *timeline)
+  {
+    timeline_ = timeline;
+  }
+
+  /**
+   * @brief Attach preset slots to manage on /preset
+   * @param presets Preset store (must remain valid); call before begin()
+   */
+  void attachPresets(PresetStore *presets)
+  {
+    presets_ = presets;
+  }
+
+  /**
+   * @brief Attach the LED arena whose usage /status reports
+   * @param arena LED arena (must remain valid); call before begin()
+   */
+  void attachArena(const LedArena *arena)
+  {
+    arena_ = arena;
+  }
+
+  /**
+   * @brief Attach the input latency tracer to report on /latency
+   * @param latency Latency tracer (must remain valid); call before begin()
+   */
+  void attachLatency(LatencyTracer *latency)
+  {
+    latency_ = latency;
+  }
+
+  /**
+   * @brief Attach the input queues whose drop counters /status reports
+   * @param inputs Input manager (must remain valid); call before begin()
+   * @param udpCues UDP cue source, or nullptr
+   */
+  void attachInputs(const InputManager *inputs, const UdpCommandSource *udpCues)
+  {
+    inputs_ = inputs;
+    udpCues_ = udpCues;
+  }
 
   /**
    * @brief Initialize WiFi and start web server
@@ -118,6 +196,30 @@ public:
                { handleSetHue(); });
     server_.on("/set_mode", [this]()
                { handleSetMode(); });
+    server_.on("/set_leds", [this]()
+               { handleSetLeds(); });
+    server_.on("/set_clock_role", [this]()
+               { handleSetClockRole(); });
+    if (preview_)
+    {
+      server_.on("/preview", [this]()
+                 { handlePreview(); });
+    }
+    if (timeline_)
+    {
+      server_.on("/timeline", [this]()
+                 { handleTimeline(); });
+    }
+    if (presets_)
+    {
+      server_.on("/preset", [this]()
+                 { handlePreset(); });
+    }
+    if (latency_)
+    {
+      server_.on("/latency", [this]()
+                 { handleLatency(); });
+    }
     server_.on("/options", HTTP_OPTIONS, [this]()
                {
         server_.sendHeader("Access-Control-Allow-Origin", "*");
@@ -190,6 +292,81 @@ public:
     return "WiFiInput";
   }
 
+  /**
+   * @brief Commands lost because the event queue was full
+   */
+  unsigned long getDroppedCount() const { return droppedCount_; }
+
+  /**
+   * @brief Format the /config response into the shared response buffer
+   * @return JSON text, valid until the next request is formatted
+   */
+  const char *formatConfig()
+  {
+    response_.clear();
+    response_.appendf("{\"speed\":%d,\"brightness\":%u,\"hueMin\":%u,\"hueMax\":%u,\"mode\":%d,\"leds\":%d,"
+                      "\"clockRole\":\"%s\"}",
+                      ConfigManager::getRotationSpeed(), ConfigManager::getMaxBrightness(), ConfigManager::getHueMin(),
+                      ConfigManager::getHueMax(), ConfigManager::getPortalMode(), ConfigManager::getLedCount(),
+                      ConfigManager::isClockMaster() ? "master" : "follower");
+    return response_.c_str();
+  }
+
+  /**
+   * @brief Format the /status response into the shared response buffer
+   * @return Status text, valid until the next request is formatted
+   */
+  const char *formatStatus()
+  {
+    response_.clear();
+    response_.append("Portal Controller Status\n");
+    response_.append("WiFi Connected: Yes\n");
+    response_.append("IP Address: ").append(getIPAddress()).append("\n");
+    response_.append("Available Commands:\n");
+    response_.append("  /toggle - Toggle portal effect\n");
+    response_.append("  /malfunction - Trigger malfunction\n");
+    response_.append("  /fadeout - Fade out effect\n");
+    response_.append("  /config - View current configuration\n");
+    response_.append("  /set_speed?speed=0-10 - Set rotation speed\n");
+    response_.append("  /set_brightness?brightness=0-255 - Set max brightness\n");
+    response_.append("  /set_hue?min=0-255&max=0-255 - Set color hue range\n");
+    response_.append("  /set_leds?count=N - Set LED count (applies after restart)\n");
+    response_.append("  /set_clock_role?role=master|follower - Show clock role (applies after restart)\n");
+    if (preview_)
+      response_.append("  /preview?seq=N - Binary ring preview (max 10 FPS)\n");
+    if (timeline_)
+      response_.append("  /timeline?action=start|stop|seek|load&ms=N - Cue timeline control\n");
+    if (presets_)
+      response_.append("  /preset?action=save|recall|delete&slot=N - Preset slots\n");
+    if (latency_)
+      response_.append("  /latency?reset=1 - Input latency percentiles (us)\n");
+    if (arena_)
+    {
+      response_.appendf("LED Arena: %lu / %lu bytes used", (unsigned long)arena_->getUsed(),
+                        (unsigned long)arena_->getCapacity());
+      if (arena_->getFailedCount() > 0)
+        response_.appendf(", %lu failed allocations", arena_->getFailedCount());
+      response_.append("\n");
+    }
+    if (inputs_)
+    {
+      response_.appendf("Input drops: queue %lu, web %lu", (unsigned long)inputs_->getDroppedCount(), droppedCount_);
+      if (udpCues_)
+        response_.appendf(", UDP cues %lu", udpCues_->getDroppedCount());
+      if (timeline_)
+        response_.appendf("; timeline cues held back %lu", timeline_->getHeldBackCount());
+      response_.append("\n");
+    }
+    const HeapMonitor::Stats &heap = HeapMonitor::getStats();
+    response_.appendf("Heap: %lu free (low %lu, grown %lu), max block %lu, fragmentation %u%% (peak %u%%)\n",
+                      (unsigned long)heap.heapFree, (unsigned long)heap.heapFreeLow,
+                      (unsigned long)heap.heapGrowthHigh, (unsigned long)heap.maxFreeBlock,
+                      heap.fragmentation, heap.fragmentationHigh);
+    response_.appendf("Stack: %lu bytes free at the deepest point\n", (unsigned long)heap.stackFreeLow);
+
+    return response_.c_str();
+  }
+
   /**
    * @brief Get the WiFi IP address
    * @return IP address as string, or "Not Connected" if not connected
@@ -199,8 +376,10 @@ public:
 #ifndef UNIT_TEST
     if (isConnected_)
     {
-      static String ipStr = WiFi.localIP().toString();
-      return ipStr.c_str();
+      static char ipStr[16];
+      IPAddress ip = WiFi.localIP();
+      snprintf(ipStr, sizeof(ipStr), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+      return ipStr;
     }
 #endif
     return "Not Connected";
@@ -217,12 +396,22 @@ public:
 
 private:
   static constexpr int MAX_EVENTS = 8;
+  static constexpr size_t RESPONSE_BYTES = 1280;
 
   ESP8266WebServer server_;
   InputEvent eventQueue_[MAX_EVENTS];
   int eventQueueHead_;
   int eventQueueTail_;
+  unsigned long droppedCount_;
   bool isConnected_;
+  FramePreview *preview_;
+  CueTimeline *timeline_;
+  PresetStore *presets_;
+  const LedArena *arena_;
+  LatencyTracer *latency_;
+  const InputManager *inputs_;
+  const UdpCommandSource *udpCues_;
+  ResponseBuffer<RESPONSE_BYTES> response_; // Shared by all handlers; requests are served one at a time
 
   /**
    * @brief Send CORS headers for all responses
@@ -235,29 +424,14 @@ private:
   }
 
   /**
-   * @brief Read file content from LittleFS
-   * @param path File path to read
-   * @return File content as String
+   * @brief Send the shared response buffer
+   * @param code HTTP status code
+   * @param type Content type
    */
-  String readFile(const char *path)
+  void sendResponse(int code, const char *type)
   {
-#ifndef UNIT_TEST
-    File file = LittleFS.open(path, "r");
-    if (!file)
-    {
-      return "File not found";
-    }
-
-    String content = "";
-    while (file.available())
-    {
-      content += (char)file.read();
-    }
-    file.close();
-    return content;
-#else
-    return "File reading not supported in unit test mode";
-#endif
+    sendCORSHeaders();
+    server_.send(code, type, response_.c_str());
   }
 
   /**
@@ -266,9 +440,17 @@ private:
   void handleRoot()
   {
 #ifndef UNIT_TEST
-    // Serve the HTML file from the data directory
+    // Stream the HTML file from the data directory in chunks instead of
+    // reading it into memory
+    File file = LittleFS.open("/index.html", "r");
     sendCORSHeaders();
-    server_.send(200, "text/html", readFile("/index.html"));
+    if (!file)
+    {
+      server_.send(404, "text/plain", "File not found");
+      return;
+    }
+    server_.streamFile(file, "text/html");
+    file.close();
 #else
     // In unit test mode, return a simple response
     sendCORSHeaders();
@@ -282,18 +464,19 @@ private:
    */
   void handleCommand(InputManager::Command command)
   {
-    // Queue the event
-    queueEvent({.inputId = static_cast<int>(command),
-                .type = EventType::Pressed,
-                .timestamp = millis(),
-                .sourceName = "WiFi"});
+    if (!queueEvent({.inputId = static_cast<int>(command),
+                     .type = EventType::Pressed,
+                     .timestamp = millis(),
+                     .sourceName = "WiFi"}))
+    {
+      sendQueueFull();
+      return;
+    }
 
     // Send response
-    String response = "Command executed: ";
-    response += InputManager::getCommandName(command);
-
-    sendCORSHeaders();
-    server_.send(200, "text/plain", response);
+    response_.clear();
+    response_.append("Command executed: ").append(InputManager::getCommandName(command));
+    sendResponse(200, "text/plain");
   }
 
   /**
@@ -301,22 +484,135 @@ private:
    */
   void handleStatus()
   {
-    String status = "Portal Controller Status\n";
-    status += "WiFi Connected: Yes\n";
-    status += "IP Address: ";
-    status += getIPAddress();
-    status += "\n";
-    status += "Available Commands:\n";
-    status += "  /toggle - Toggle portal effect\n";
-    status += "  /malfunction - Trigger malfunction\n";
-    status += "  /fadeout - Fade out effect\n";
-    status += "  /config - View current configuration\n";
-    status += "  /set_speed?speed=0-10 - Set rotation speed\n";
-    status += "  /set_brightness?brightness=0-255 - Set max brightness\n";
-    status += "  /set_hue?min=0-255&max=0-255 - Set color hue range\n";
+    formatStatus();
+    sendResponse(200, "text/plain");
+  }
+
+  /**
+   * @brief Handle live preview request
+   *
+   * The client passes the sequence number of the frame it holds in `seq`
+   * and receives a delta against it when possible, or a keyframe otherwise.
+   */
+  void handlePreview()
+  {
+    static uint8_t frame[FramePreview::MAX_FRAME_BYTES];
+    bool clientHasFrame = server_.hasArg("seq");
+    uint16_t clientSeq = clientHasFrame ? (uint16_t)server_.arg("seq").toInt() : 0;
+    size_t length = preview_->encode(millis(), clientSeq, clientHasFrame, frame, sizeof(frame));
 
     sendCORSHeaders();
-    server_.send(200, "text/plain", status);
+    server_.sendHeader("Cache-Control", "no-store");
+    server_.send(200, "application/octet-stream", frame, length);
+  }
+
+  /**
+   * @brief Handle cue timeline transport control
+   *
+   * `action` is one of start, stop, seek (with `ms`) or load; without an
+   * action the current timeline state is returned.
+   */
+  void handleTimeline()
+  {
+    unsigned long now = millis();
+    if (server_.hasArg("action"))
+    {
+      const String &action = server_.arg("action");
+      if (action == "start")
+        timeline_->start(now);
+      else if (action == "stop")
+        timeline_->stop(now);
+      else if (action == "seek" && server_.hasArg("ms"))
+      {
+        long ms = server_.arg("ms").toInt();
+        timeline_->seek(ms > 0 ? (uint32_t)ms : 0, now);
+      }
+      else if (action == "load")
+        timeline_->loadFromFile();
+      else
+      {
+        sendCORSHeaders();
+        server_.send(400, "text/plain", "Unknown action or missing ms parameter");
+        return;
+      }
+    }
+
+    response_.clear();
+    response_.appendf("{\"running\":%s,\"position\":%lu,\"duration\":%lu,\"cues\":%d,\"next\":%d}",
+                      timeline_->isRunning() ? "true" : "false", (unsigned long)timeline_->getPosition(),
+                      (unsigned long)timeline_->getDuration(), timeline_->getCueCount(), timeline_->getNextCueIndex());
+    sendResponse(200, "application/json");
+  }
+
+  /**
+   * @brief Handle input latency report
+   *
+   * Returns the latency percentiles in microseconds per stage; `reset=1`
+   * clears them after the report.
+   */
+  void handleLatency()
+  {
+    response_.clear();
+    latency_->appendJson(response_);
+    if (server_.hasArg("reset") && server_.arg("reset") == "1")
+      latency_->reset();
+    sendResponse(200, "application/json");
+  }
+
+  /**
+   * @brief Handle preset slot requests
+   *
+   * `action` is save, recall or delete together with `slot`; without an
+   * action the occupied slots are listed. A recall applies within the
+   * current loop iteration, so the next frame already shows the new look.
+   */
+  void handlePreset()
+  {
+    if (server_.hasArg("action"))
+    {
+      // Echo only our own action names, never the client's text
+      const String &arg = server_.arg("action");
+      const char *action = nullptr;
+      if (arg == "save")
+        action = "save";
+      else if (arg == "recall")
+        action = "recall";
+      else if (arg == "delete")
+        action = "delete";
+      if (action == nullptr)
+      {
+        sendCORSHeaders();
+        server_.send(400, "text/plain", "Unknown action");
+        return;
+      }
+
+      int slot = server_.hasArg("slot") ? server_.arg("slot").toInt() : -1;
+      bool ok;
+      if (!PresetStore::isValidSlot(slot))
+        ok = false;
+      else if (action[0] == 's')
+        ok = presets_->save(slot);
+      else if (action[0] == 'r')
+        ok = presets_->recall(slot);
+      else
+        ok = presets_->remove(slot);
+
+      response_.clear();
+      response_.appendf("{\"action\":\"%s\",\"slot\":%d,\"ok\":%s}", action, slot, ok ? "true" : "false");
+      sendResponse(ok ? 200 : 404, "application/json");
+      return;
+    }
+
+    response_.clear();
+    response_.append("{\"slots\":[");
+    for (int slot = 0; slot < PresetStore::SLOT_COUNT; slot++)
+    {
+      if (slot > 0)
+        response_.append(",");
+      response_.append(presets_->exists(slot) ? "true" : "false");
+    }
+    response_.append("]}");
+    sendResponse(200, "application/json");
   }
 
   /**
@@ -324,16 +620,8 @@ private:
    */
   void handleConfig()
   {
-    String json = "{";
-    json += "\"speed\":" + String(ConfigManager::getRotationSpeed()) + ",";
-    json += "\"brightness\":" + String(ConfigManager::getMaxBrightness()) + ",";
-    json += "\"hueMin\":" + String(ConfigManager::getHueMin()) + ",";
-    json += "\"hueMax\":" + String(ConfigManager::getHueMax()) + ",";
-    json += "\"mode\":" + String(ConfigManager::getPortalMode());
-    json += "}";
-
-    sendCORSHeaders();
-    server_.send(200, "application/json", json);
+    formatConfig();
+    sendResponse(200, "application/json");
   }
 
   /**
@@ -343,11 +631,15 @@ private:
   {
     if (server_.hasArg("speed"))
     {
-      int speed = server_.arg("speed").toInt();
-      ConfigManager::setRotationSpeed(speed);
-      String response = "Rotation speed set to: " + String(speed) + " (0-10)";
-      sendCORSHeaders();
-      server_.send(200, "text/plain", response);
+      int speed = constrain((int)server_.arg("speed").toInt(), 0, 10); // Echo what is applied
+      if (!queueParameter(InputManager::Command::SetSpeed, speed))
+      {
+        sendQueueFull();
+        return;
+      }
+      response_.clear();
+      response_.appendf("Rotation speed set to: %d (0-10)", speed);
+      sendResponse(200, "text/plain");
     }
     else
     {
@@ -363,11 +655,15 @@ private:
   {
     if (server_.hasArg("brightness"))
     {
-      int brightness = server_.arg("brightness").toInt();
-      ConfigManager::setMaxBrightness(brightness);
-      String response = "Max brightness set to: " + String(brightness) + " (0-255)";
-      sendCORSHeaders();
-      server_.send(200, "text/plain", response);
+      int brightness = constrain((int)server_.arg("brightness").toInt(), 0, 255);
+      if (!queueParameter(InputManager::Command::SetBrightness, brightness))
+      {
+        sendQueueFull();
+        return;
+      }
+      response_.clear();
+      response_.appendf("Max brightness set to: %d (0-255)", brightness);
+      sendResponse(200, "text/plain");
     }
     else
     {
@@ -383,13 +679,16 @@ private:
   {
     if (server_.hasArg("min") && server_.hasArg("max"))
     {
-      int minHue = server_.arg("min").toInt();
-      int maxHue = server_.arg("max").toInt();
-      ConfigManager::setHueMin(minHue);
-      ConfigManager::setHueMax(maxHue);
-      String response = "Color hue range set to: " + String(minHue) + " - " + String(maxHue) + " (0-255)";
-      sendCORSHeaders();
-      server_.send(200, "text/plain", response);
+      int minHue = constrain((int)server_.arg("min").toInt(), 0, 255);
+      int maxHue = constrain((int)server_.arg("max").toInt(), 0, 255);
+      if (!queueParameter(InputManager::Command::SetHue, minHue, maxHue))
+      {
+        sendQueueFull();
+        return;
+      }
+      response_.clear();
+      response_.appendf("Color hue range set to: %d - %d (0-255)", minHue, maxHue);
+      sendResponse(200, "text/plain");
     }
     else
     {
@@ -398,10 +697,6 @@ private:
     }
   }
 
-  /**
-   * @brief Add event to queue
-   * @param event Event to queue
-   */
   /**
    * @brief Handle set mode request
    */
@@ -410,10 +705,14 @@ private:
     if (server_.hasArg("mode"))
     {
       int mode = server_.arg("mode").toInt();
-      ConfigManager::setPortalMode(mode);
-      String response = "Portal mode set to: " + String(mode == 0 ? "Classic" : "Virtual Gradients");
-      sendCORSHeaders();
-      server_.send(200, "text/plain", response);
+      if (!queueParameter(InputManager::Command::SetMode, mode))
+      {
+        sendQueueFull();
+        return;
+      }
+      response_.clear();
+      response_.appendf("Portal mode set to: %s", mode == 0 ? "Classic" : "Virtual Gradients");
+      sendResponse(200, "text/plain");
     }
     else
     {
@@ -422,17 +721,93 @@ private:
     }
   }
 
+  /**
+   * @brief Handle set LED count request
+   *
+   * The count is saved with the other settings, but buffers are sized at
+   * boot, so it applies after the next restart.
+   */
+  void handleSetLeds()
+  {
+    if (server_.hasArg("count"))
+    {
+      ConfigManager::setLedCount(server_.arg("count").toInt());
+      response_.clear();
+      response_.appendf("LED count set to: %d (applies after restart)", ConfigManager::getLedCount());
+      sendResponse(200, "text/plain");
+    }
+    else
+    {
+      sendCORSHeaders();
+      server_.send(400, "text/plain", "Missing count parameter");
+    }
+  }
+
+  /**
+   * @brief Handle set clock role request
+   */
+  void handleSetClockRole()
+  {
+    const char *role = nullptr;
+    if (server_.hasArg("role"))
+    {
+      if (server_.arg("role") == "master")
+        role = "master";
+      else if (server_.arg("role") == "follower")
+        role = "follower";
+    }
+    if (role)
+    {
+      ConfigManager::setClockMaster(role[0] == 'm');
+      response_.clear();
+      response_.appendf("Clock role set to: %s (applies after restart)", role);
+      sendResponse(200, "text/plain");
+    }
+    else
+    {
+      sendCORSHeaders();
+      server_.send(400, "text/plain", "Missing or unknown role parameter");
+    }
+  }
+
+  /**
+   * @brief Answer a request whose command could not be queued
+   */
+  void sendQueueFull()
+  {
+    sendCORSHeaders();
+    server_.send(503, "text/plain", "Input queue full, try again");
+  }
+
+  /**
+   * @brief Queue a parameter command; it is applied with the next input update
+   * @return False if the queue was full and the command was dropped
+   */
+  bool queueParameter(InputManager::Command command, int arg1, int arg2 = 0)
+  {
+    return queueEvent({.inputId = static_cast<int>(command),
+                .type = EventType::Pressed,
+                .timestamp = millis(),
+                .sourceName = "WiFi",
+                .arg1 = (int16_t)constrain(arg1, INT16_MIN, INT16_MAX),
+                .arg2 = (int16_t)constrain(arg2, INT16_MIN, INT16_MAX)});
+  }
+
   /**
    * @brief Add event to queue
    * @param event Event to queue
+   * @return False if the queue was full and the event was dropped
    */
-  void queueEvent(const InputEvent &event)
+  bool queueEvent(const InputEvent &event)
   {
     int nextTail = (eventQueueTail_ + 1) % MAX_EVENTS;
-    if (nextTail != eventQueueHead_)
-    { // Don't overflow
-      eventQueue_[eventQueueTail_] = event;
-      eventQueueTail_ = nextTail;
+    if (nextTail == eventQueueHead_)
+    {
+      droppedCount_++;
+      return false;
     }
+    eventQueue_[eventQueueTail_] = event;
+    eventQueueTail_ = nextTail;
+    return true;
   }
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+// In-memory IFileStore for native tests
+#pragma once
+#include "../src/file_store.h"
+#ifdef UNIT_TEST
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+class MemoryFileStore : public IFileStore
+{
+public:
+  bool begin() override { return true; }
+
+  long size(const char *path) override
+  {
+    auto it = files.find(path);
+    return it == files.end() ? -1 : (long)it->second.size();
+  }
+
+  size_t read(const char *path, size_t offset, uint8_t *buffer, size_t length) override
+  {
+    readCalls++;
+    auto it = files.find(path);
+    if (it == files.end() || offset >= it->second.size())
+      return 0;
+    size_t bytes = std::min(length, it->second.size() - offset);
+    memcpy(buffer, it->second.data() + offset, bytes);
+    return bytes;
+  }
+
+  bool append(const char *path, const uint8_t *data, size_t length) override
+  {
+    writeCalls++;
+    std::vector<uint8_t> &file = files[path];
+    size_t keep = length;
+    if (tearNextWrite > 0 && tearNextWrite < length)
+    {
+      keep = tearNextWrite; // Simulated power loss mid-write
+      tearNextWrite = 0;
+    }
+    file.insert(file.end(), data, data + keep);
+    bytesWritten += keep;
+    return keep == length;
+  }
+
+  bool write(const char *path, const uint8_t *data, size_t length) override
+  {
+    files[path].clear();
+    return append(path, data, length);
+  }
+
+  bool rename(const char *from, const char *to) override
+  {
+    auto it = files.find(from);
+    if (it == files.end())
+      return false;
+    files[to] = it->second;
+    files.erase(from);
+    return true;
+  }
+
+  bool remove(const char *path) override { return files.erase(path) > 0; }
+
+  std::map<std::string, std::vector<uint8_t>> files;
+  size_t tearNextWrite = 0;
+  int readCalls = 0;
+  int writeCalls = 0;
+  size_t bytesWritten = 0;
+};
+#endif
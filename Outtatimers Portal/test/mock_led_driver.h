@@ -12,6 +12,7 @@ public:
   MockLEDDriver(int pin = 0) {}
   void begin() override {}
   CRGB *getBuffer() override { return buffer; }
+  int getLength() const override { return length; }
   void show() override {}
   void setBrightness(uint8_t b) override { brightness = b; }
   void fillSolid(const CRGB &c) override
@@ -32,5 +33,6 @@ public:
 
   CRGB buffer[N];
   uint8_t brightness = 255;
+  int length = N; // Runtime LED count reported to the effect
 };
 #endif
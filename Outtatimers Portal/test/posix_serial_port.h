@@ -0,0 +1,56 @@
+// POSIX file descriptor ISerialPort for native tests (pseudo-terminal)
+#pragma once
+#include "../src/serial_port.h"
+#ifdef UNIT_TEST
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+class PosixSerialPort : public ISerialPort
+{
+public:
+  explicit PosixSerialPort(int fd) : fd_(fd) {}
+
+  int read(uint8_t *buffer, size_t length) override
+  {
+    ssize_t n = ::read(fd_, buffer, length);
+    return n > 0 ? (int)n : 0;
+  }
+
+  int availableForWrite() override { return 256; } // Like the ESP8266 UART TX buffer
+
+  size_t write(const uint8_t *data, size_t length) override
+  {
+    ssize_t n = ::write(fd_, data, length);
+    return n > 0 ? (size_t)n : 0;
+  }
+
+  /**
+   * @brief Open a raw, non-blocking pseudo-terminal pair
+   * @param master Output: the show PC end
+   * @param slave Output: the portal end
+   * @return true on success
+   */
+  static bool openPty(int &master, int &slave)
+  {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+      return false;
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0)
+      return false;
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(slave, F_SETFL, fcntl(slave, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+  }
+
+private:
+  int fd_;
+};
+#endif
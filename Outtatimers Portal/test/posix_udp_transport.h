@@ -0,0 +1,105 @@
+// POSIX socket IUdpTransport for native tests (loopback)
+#pragma once
+#include "../src/udp_transport.h"
+#ifdef UNIT_TEST
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+
+class PosixUdpTransport : public IUdpTransport
+{
+public:
+  PosixUdpTransport() : fd_(-1), length_(0), offset_(0), remoteIP_(0), remotePort_(0) {}
+  ~PosixUdpTransport() override { stop(); }
+
+  bool begin(uint16_t port) override
+  {
+    if (!open())
+      return false;
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    return bind(fd_, (sockaddr *)&addr, sizeof(addr)) == 0;
+  }
+
+  void stop() override
+  {
+    if (fd_ >= 0)
+      close(fd_);
+    fd_ = -1;
+  }
+
+  int parsePacket() override
+  {
+    if (fd_ < 0)
+      return 0;
+    sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(fd_, datagram_, sizeof(datagram_), 0, (sockaddr *)&from, &fromLen);
+    if (n <= 0)
+    {
+      length_ = offset_ = 0;
+      return 0;
+    }
+    length_ = (size_t)n;
+    offset_ = 0;
+    remoteIP_ = from.sin_addr.s_addr;
+    remotePort_ = ntohs(from.sin_port);
+    return (int)n;
+  }
+
+  int read(uint8_t *buffer, size_t length) override
+  {
+    size_t available = length_ - offset_;
+    size_t n = length < available ? length : available;
+    memcpy(buffer, datagram_ + offset_, n);
+    offset_ += n;
+    return (int)n;
+  }
+
+  uint32_t remoteIP() const override { return remoteIP_; }
+  uint16_t remotePort() const override { return remotePort_; }
+
+  bool send(uint32_t ip, uint16_t port, const uint8_t *data, size_t length) override
+  {
+    if (!open())
+      return false;
+    sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = ip;
+    to.sin_port = htons(port);
+    return sendto(fd_, data, length, 0, (sockaddr *)&to, sizeof(to)) == (ssize_t)length;
+  }
+
+  static uint32_t loopback() { return htonl(INADDR_LOOPBACK); }
+
+private:
+  int fd_;
+  uint8_t datagram_[1500];
+  size_t length_;
+  size_t offset_;
+  uint32_t remoteIP_;
+  uint16_t remotePort_;
+
+  bool open()
+  {
+    if (fd_ >= 0)
+      return true;
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0)
+      return false;
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+  }
+};
+#endif
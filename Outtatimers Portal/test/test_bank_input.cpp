@@ -0,0 +1,136 @@
+#include "../src/bank_input_source.h"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+extern "C" unsigned long millis() { return 0; }
+extern "C" int digitalRead(int pin) { return HIGH; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+/**
+ * @brief Scripted 74HC165 chain: levels of up to 32 inputs, shifted out like the chips would
+ */
+class MockShiftInBus : public IShiftInBus
+{
+public:
+  uint32_t levels = 0;
+  int reads = 0;
+  size_t lastCount = 0;
+
+  void read(uint8_t *bytes, size_t count) override
+  {
+    reads++;
+    lastCount = count;
+    for (size_t chip = 0; chip < count; chip++)
+    {
+      // Input H of each chip leaves first and lands in the MSB
+      uint8_t byte = 0;
+      for (int input = 7; input >= 0; input--)
+        byte = (uint8_t)(byte << 1 | ((levels >> (chip * 8 + input)) & 1));
+      bytes[chip] = byte;
+    }
+  }
+};
+
+static std::vector<IInputSource::InputEvent> drain(IInputSource &source)
+{
+  std::vector<IInputSource::InputEvent> events;
+  while (source.hasEvents())
+    events.push_back(source.getNextEvent());
+  return events;
+}
+
+int main()
+{
+  // Vertical counters match a per-input reference debouncer on every lane
+  srand(7);
+  VerticalDebounce vertical;
+  uint32_t refState = 0;
+  int refCount[32] = {0};
+  uint32_t level = 0;
+  for (int step = 0; step < 20000; step++)
+  {
+    // Mostly steady inputs with occasional bursts of bounce
+    uint32_t flips = 0;
+    for (int bit = 0; bit < 32; bit++)
+      if (rand() % 16 == 0)
+        flips |= 1u << bit;
+    level ^= flips;
+
+    uint32_t expected = 0;
+    for (int bit = 0; bit < 32; bit++)
+    {
+      bool differs = ((level ^ refState) >> bit) & 1;
+      refCount[bit] = differs ? refCount[bit] + 1 : 0;
+      if (refCount[bit] == VerticalDebounce::SAMPLES)
+      {
+        expected |= 1u << bit;
+        refCount[bit] = 0;
+      }
+    }
+    refState ^= expected;
+    assert(vertical.sample(level) == expected);
+    assert(vertical.getState() == refState);
+  }
+
+  // A change is accepted on exactly the 4th agreeing sample
+  VerticalDebounce one;
+  assert(one.sample(1) == 0 && one.sample(1) == 0 && one.sample(1) == 0);
+  assert(one.sample(1) == 1 && one.getState() == 1);
+  assert(one.sample(0) == 0 && one.sample(1) == 0); // a glitch back resets the count
+
+  // Shift register chain: chip 0 is inputs 0-7, input A is bit 0
+  MockShiftInBus bus;
+  ShiftRegisterBank bank(&bus, 4);
+  assert(bank.getWidth() == 32);
+  bus.levels = 0x80402001u;
+  assert(bank.read() == 0x80402001u);
+  assert(bus.lastCount == 4);
+  ShiftRegisterBank small(&bus, 1);
+  assert(small.read() == 0x01 && bus.lastCount == 1);
+  assert(ShiftRegisterBank(&bus, 9).getWidth() == 32);
+
+  // Bank source: active-low buttons on inputs 0, 1 and 9, the rest unmapped
+  static const int ids[] = {1, 2, 0, 0, 0, 0, 0, 0, 0, 3};
+  bus.levels = 0xFFFFFFFFu; // all released (pulled up)
+  BankInputSource source(&bank, ids, 10, 0xFFFFFFFFu, 10, "Expander");
+  assert(strcmp(source.getSourceName(), "Expander") == 0);
+  unsigned long now = 0;
+  for (int i = 0; i < 10; i++)
+    source.update(now += 10);
+  assert(!source.hasEvents());
+
+  // Press inputs 1 and 9, and wiggle unmapped input 4
+  bus.levels &= ~((1u << 1) | (1u << 9) | (1u << 4));
+  int readsBefore = bus.reads;
+  source.update(now + 3); // too early: no read at all
+  assert(bus.reads == readsBefore);
+  for (int i = 0; i < 3; i++)
+    assert(!source.update(now += 10));
+  assert(source.update(now += 10));
+  std::vector<IInputSource::InputEvent> events = drain(source);
+  assert(events.size() == 2);
+  assert(events[0].inputId == 2 && events[0].type == IInputSource::EventType::Pressed);
+  assert(events[1].inputId == 3 && events[1].type == IInputSource::EventType::Pressed);
+  assert(events[0].timestamp == now);
+  assert((source.getPressedMask() & 0x3FF) == ((1u << 1) | (1u << 9) | (1u << 4)));
+
+  // Bouncing release: accepted only once the contact settles
+  for (int i = 0; i < 6; i++)
+  {
+    bus.levels ^= 1u << 1;
+    source.update(now += 10);
+  }
+  assert(!source.hasEvents());
+  bus.levels |= 1u << 1;
+  for (int i = 0; i < 4; i++)
+    source.update(now += 10);
+  events = drain(source);
+  assert(events.size() == 1 && events[0].inputId == 2 && events[0].type == IInputSource::EventType::Released);
+
+  std::cout << "Bank input native test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include "../src/input_manager.h"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+// Simulated board: pin levels, clock and attached pin-change handlers
+static unsigned long simulated_time = 0;
+static int pinLevels[32];
+static void (*handlers[32])(void *);
+static void *handlerArgs[32];
+
+extern "C" unsigned long millis() { return simulated_time; }
+extern "C" int digitalRead(int pin) { return pinLevels[pin]; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode)
+{
+  handlers[pin] = handler;
+  handlerArgs[pin] = arg;
+}
+
+// Change a pin at a given time, firing its interrupt like the hardware would
+static void setPin(int pin, int level, unsigned long time)
+{
+  simulated_time = time;
+  pinLevels[pin] = level;
+  if (handlers[pin])
+    handlers[pin](handlerArgs[pin]);
+}
+
+// A press with contact bounce: the first edge is the real press
+static void bouncyPress(int pin, unsigned long start, int level)
+{
+  setPin(pin, level, start);
+  setPin(pin, !level, start + 1);
+  setPin(pin, level, start + 2);
+  setPin(pin, !level, start + 4);
+  setPin(pin, level, start + 5);
+}
+
+static std::vector<IInputSource::InputEvent> drain(IInputSource &source)
+{
+  std::vector<IInputSource::InputEvent> events;
+  while (source.hasEvents())
+    events.push_back(source.getNextEvent());
+  return events;
+}
+
+static const int PIN_A = 14;
+static const int PIN_B = 12;
+static const ButtonInputSource::ButtonConfig configs[] = {
+    {.pin = PIN_A, .inputId = 1, .activeLow = true, .debounceMs = 50, .name = "A"},
+    {.pin = PIN_B, .inputId = 2, .activeLow = true, .debounceMs = 50, .name = "B"}};
+
+int main()
+{
+  pinLevels[PIN_A] = HIGH;
+  pinLevels[PIN_B] = HIGH;
+
+  ButtonInputSource buttons(nullptr, 0);
+  buttons = ButtonInputSource(configs, 2, ButtonInputSource::CaptureMode::Interrupt);
+  buttons.begin();
+  assert(handlers[PIN_A] && handlers[PIN_B]);
+
+  // A press during a long render is dated to its first edge, not to the
+  // update that finally processes it
+  bouncyPress(PIN_A, 1000, LOW);
+  assert(!buttons.update(1020)); // still bouncing within the debounce window
+  simulated_time = 1180;         // loop() stuck in show()/handleClient()
+  assert(buttons.update(1180));
+  std::vector<IInputSource::InputEvent> events = drain(buttons);
+  assert(events.size() == 1);
+  assert(events[0].inputId == 1 && events[0].type == IInputSource::EventType::Pressed);
+  assert(events[0].timestamp == 1000);
+
+  // Release, and a second button pressed in the same busy stretch
+  bouncyPress(PIN_A, 1300, HIGH);
+  bouncyPress(PIN_B, 1310, LOW);
+  buttons.update(1500);
+  events = drain(buttons);
+  assert(events.size() == 2);
+  assert(events[0].inputId == 1 && events[0].type == IInputSource::EventType::Released && events[0].timestamp == 1300);
+  assert(events[1].inputId == 2 && events[1].type == IInputSource::EventType::Pressed && events[1].timestamp == 1310);
+
+  // Timestamps do not depend on how often update() runs
+  for (unsigned long period : {1UL, 10UL, 24UL, 100UL, 400UL})
+  {
+    unsigned long start = 10000 * period;
+    setPin(PIN_B, HIGH, start);
+    buttons.update(start + 1000);
+    drain(buttons);
+    bouncyPress(PIN_B, start + 2000 + period / 3, LOW);
+    unsigned long now = start + 2000;
+    while (!buttons.hasEvents())
+    {
+      now += period;
+      buttons.update(now);
+    }
+    events = drain(buttons);
+    assert(events.size() == 1 && events[0].timestamp == start + 2000 + period / 3);
+  }
+
+  // A glitch shorter than the debounce interval is ignored
+  setPin(PIN_A, LOW, 200000);
+  setPin(PIN_A, HIGH, 200005);
+  buttons.update(200100);
+  assert(!buttons.hasEvents());
+
+  // An edge captured after update() read the clock is not settled early
+  setPin(PIN_A, LOW, 200200);
+  assert(!buttons.update(200190));
+  buttons.update(200260);
+  events = drain(buttons);
+  assert(events.size() == 1 && events[0].timestamp == 200200);
+
+  // Overflowing the edge ring loses edges but the state resyncs to the pin
+  for (int i = 0; i < 200; i++)
+    setPin(PIN_A, i % 2 ? LOW : HIGH, 300000 + i);
+  assert(buttons.getDroppedEdgeCount() > 0);
+  pinLevels[PIN_A] = HIGH; // released in the end
+  buttons.update(300300);
+  buttons.update(300400);
+  events = drain(buttons);
+  assert(!events.empty() && events.back().inputId == 1 && events.back().type == IInputSource::EventType::Released);
+
+  // Polling mode keeps working and dates presses by when it sees them
+  ButtonInputSource polled(configs, 1);
+  polled.begin(); // no-op
+  pinLevels[PIN_A] = LOW;
+  polled.update(400000);
+  polled.update(400060);
+  events = drain(polled);
+  assert(events.size() == 1 && events[0].timestamp == 400060);
+
+  std::cout << "Button capture native test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,185 @@
+#include "../src/input_manager.h"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static unsigned long simulated_time = 0;
+static int pinLevels[32];
+
+extern "C" unsigned long millis() { return simulated_time; }
+extern "C" int digitalRead(int pin) { return pinLevels[pin]; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+struct Gesture
+{
+  ButtonGesture::Type type;
+  unsigned long time;
+};
+
+static std::vector<Gesture> tick(ButtonGesture &gesture, unsigned long now)
+{
+  std::vector<Gesture> gestures;
+  Gesture g;
+  while (gesture.tick(now, g.type, g.time))
+    gestures.push_back(g);
+  return gestures;
+}
+
+static std::vector<IInputSource::InputEvent> drain(IInputSource &source)
+{
+  std::vector<IInputSource::InputEvent> events;
+  while (source.hasEvents())
+    events.push_back(source.getNextEvent());
+  return events;
+}
+
+// Hold a polled pin at a level, updating every 10 ms
+static void holdPin(ButtonInputSource &buttons, int pin, int level, unsigned long from, unsigned long to)
+{
+  pinLevels[pin] = level;
+  for (unsigned long t = from; t <= to; t += 10)
+    buttons.update(t);
+}
+
+static const int PIN_A = 14;
+static const int PIN_B = 12;
+static const ButtonInputSource::ButtonConfig configs[] = {
+    {.pin = PIN_A, .inputId = 1, .activeLow = true, .debounceMs = 50, .name = "A"},
+    {.pin = PIN_B,
+     .inputId = 3,
+     .activeLow = true,
+     .debounceMs = 50,
+     .name = "B",
+     .longPressMs = 800,
+     .doubleTapMs = 300,
+     .holdRepeatMs = 150,
+     .longPressId = 5,
+     .doubleTapId = 4}};
+
+int main()
+{
+  // Short press: a tap dated to the press
+  ButtonGesture plain(800, 0, 0);
+  plain.press(1000);
+  assert(tick(plain, 1500).empty());
+  plain.release(1200);
+  std::vector<Gesture> gestures = tick(plain, 1200);
+  assert(gestures.size() == 1 && gestures[0].type == ButtonGesture::Type::Tap && gestures[0].time == 1000);
+
+  // Long press fires while held, once, and the release adds nothing
+  plain.press(2000);
+  gestures = tick(plain, 2900);
+  assert(gestures.size() == 1 && gestures[0].type == ButtonGesture::Type::LongPress && gestures[0].time == 2800);
+  assert(tick(plain, 4000).empty());
+  plain.release(4000);
+  assert(tick(plain, 4000).empty());
+
+  // A long press released before anyone ticked is still a long press
+  plain.press(5000);
+  plain.release(6000);
+  gestures = tick(plain, 6000);
+  assert(gestures.size() == 1 && gestures[0].type == ButtonGesture::Type::LongPress);
+
+  // Hold repeats at fixed times after the long press, however late the tick
+  ButtonGesture hold(800, 0, 150);
+  hold.press(0);
+  gestures = tick(hold, 1250);
+  assert(gestures.size() == 4);
+  assert(gestures[0].type == ButtonGesture::Type::LongPress && gestures[0].time == 800);
+  for (int k = 1; k < 4; k++)
+    assert(gestures[k].type == ButtonGesture::Type::Hold && gestures[k].time == 800 + 150 * (unsigned long)k);
+  hold.release(1260);
+  assert(tick(hold, 2000).empty());
+
+  // Double tap, and a single tap that waits out the window
+  ButtonGesture taps(0, 300, 0);
+  taps.press(100);
+  taps.release(180);
+  assert(tick(taps, 300).empty());
+  taps.press(350);
+  gestures = tick(taps, 350);
+  assert(gestures.size() == 1 && gestures[0].type == ButtonGesture::Type::DoubleTap && gestures[0].time == 350);
+  taps.release(420);
+  assert(tick(taps, 1000).empty());
+  taps.press(2000);
+  taps.release(2050);
+  assert(tick(taps, 2349).empty());
+  gestures = tick(taps, 2350);
+  assert(gestures.size() == 1 && gestures[0].type == ButtonGesture::Type::Tap && gestures[0].time == 2000);
+
+  // A second press after the window is two taps even if nobody ticked between
+  taps.press(3000);
+  taps.release(3050);
+  taps.press(3500);
+  gestures = tick(taps, 3500);
+  assert(gestures.size() == 1 && gestures[0].type == ButtonGesture::Type::Tap && gestures[0].time == 3000);
+
+  // ButtonInputSource: plain buttons report raw presses, gesture buttons
+  // report gestures with their own input IDs
+  pinLevels[PIN_A] = HIGH;
+  pinLevels[PIN_B] = HIGH;
+  ButtonInputSource buttons(configs, 2);
+
+  holdPin(buttons, PIN_A, LOW, 10000, 10100);
+  holdPin(buttons, PIN_A, HIGH, 10110, 10200);
+  std::vector<IInputSource::InputEvent> events = drain(buttons);
+  assert(events.size() == 2);
+  assert(events[0].inputId == 1 && events[0].type == IInputSource::EventType::Pressed);
+  assert(events[1].type == IInputSource::EventType::Released);
+
+  // Tap on B is reported after the double-tap window, with B's own ID
+  holdPin(buttons, PIN_B, LOW, 20000, 20100);
+  assert(!buttons.hasEvents()); // no raw press for a gesture button
+  holdPin(buttons, PIN_B, HIGH, 20110, 20800);
+  events = drain(buttons);
+  assert(events.size() == 2);
+  assert(events[0].type == IInputSource::EventType::Released);
+  assert(events[1].inputId == 3 && events[1].type == IInputSource::EventType::Tap);
+
+  // Double tap on B
+  holdPin(buttons, PIN_B, LOW, 30000, 30100);
+  holdPin(buttons, PIN_B, HIGH, 30110, 30200);
+  holdPin(buttons, PIN_B, LOW, 30210, 30300);
+  holdPin(buttons, PIN_B, HIGH, 30310, 31000);
+  events = drain(buttons);
+  int doubleTaps = 0, taps3 = 0;
+  for (const IInputSource::InputEvent &event : events)
+  {
+    doubleTaps += event.type == IInputSource::EventType::DoubleTap && event.inputId == 4;
+    taps3 += event.type == IInputSource::EventType::Tap;
+  }
+  assert(doubleTaps == 1 && taps3 == 0);
+
+  // Long press and hold on B repeat the long-press ID
+  holdPin(buttons, PIN_B, LOW, 40000, 41250);
+  holdPin(buttons, PIN_B, HIGH, 41260, 42000);
+  events = drain(buttons);
+  int longPresses = 0, holds = 0;
+  for (const IInputSource::InputEvent &event : events)
+  {
+    longPresses += event.type == IInputSource::EventType::LongPress && event.inputId == 5;
+    holds += event.type == IInputSource::EventType::Hold && event.inputId == 5;
+    assert(event.type != IInputSource::EventType::Tap);
+  }
+  assert(longPresses == 1 && holds >= 2 && holds <= 3);
+
+  // InputManager turns gestures into their commands
+  InputManager manager;
+  static std::vector<InputManager::Command> commands;
+  manager.setInputCallback([](InputManager::Command command, const IInputSource::InputEvent &)
+                           { commands.push_back(command); });
+  manager.addInputSource(&buttons);
+  pinLevels[PIN_B] = LOW;
+  for (unsigned long t = 50000; t <= 50900; t += 10)
+    manager.update(t);
+  pinLevels[PIN_B] = HIGH;
+  for (unsigned long t = 50910; t <= 51000; t += 10)
+    manager.update(t);
+  assert(commands.size() == 1 && commands[0] == InputManager::Command::DimStep);
+  assert(InputManager::isValidCommand(4) && InputManager::isValidCommand(5) &&
+         !InputManager::isValidCommand(InputManager::COMMAND_COUNT + 1));
+
+  std::cout << "Button gesture native test passed" << std::endl;
+  return 0;
+}
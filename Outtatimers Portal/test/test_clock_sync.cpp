@@ -0,0 +1,172 @@
+#include "posix_udp_transport.h"
+#include "../src/clock_sync.h"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sys/wait.h>
+#include <time.h>
+
+// Several portals as separate processes on loopback: one master and two
+// followers, each with its own local clock (offset and crystal drift) and a
+// random blocking "show()" between loop iterations. CLOCK_MONOTONIC is
+// shared by all processes, so every follower can compare its shared clock
+// against the master's true local time at the same instant.
+static const uint16_t TEST_PORT = 17010;
+static const uint32_t LOOPBACK_BROADCAST = htonl(0x7FFFFFFF); // 127.255.255.255
+
+static const int64_t MASTER_OFFSET_US = 5000000;
+static const int RUN_MS = 4000;
+static const int SETTLE_MS = 2500;        // Errors are checked after this point
+static const int64_t MAX_ERROR_US = 4000; // "Within a few ms"
+static const int64_t MAX_STALL_US = 50000; // Longest real time nowMs() may stand still
+
+struct PortalClock
+{
+  int64_t offsetUs;
+  double driftPpm;
+  int64_t jumpAtMs; // Local clock glitch (e.g. master reboot seen by a follower)
+  int64_t jumpUs;
+};
+
+static int64_t monotonicMicros()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t epochUs;
+
+static uint64_t localMicros(const PortalClock &clock, int64_t realUs)
+{
+  int64_t elapsed = realUs - epochUs;
+  int64_t local = elapsed + (int64_t)(elapsed * clock.driftPpm / 1e6) + clock.offsetUs;
+  if (clock.jumpAtMs > 0 && elapsed >= clock.jumpAtMs * 1000)
+    local += clock.jumpUs;
+  return (uint64_t)local;
+}
+
+static void simulatedRender()
+{
+  usleep(rand() % 8000); // Blocking show() of a long strip
+}
+
+static int runMaster()
+{
+  PosixUdpTransport udp;
+  ClockSync sync(&udp, ClockSync::Role::Master, 1, LOOPBACK_BROADCAST);
+  if (!sync.begin(TEST_PORT))
+    return 2;
+  PortalClock clock = {MASTER_OFFSET_US, 0.0, 0, 0};
+  while (monotonicMicros() - epochUs < (RUN_MS + 500) * 1000LL)
+  {
+    sync.update(localMicros(clock, monotonicMicros()));
+    simulatedRender();
+  }
+  return 0;
+}
+
+static int runFollower(uint32_t nodeId, const PortalClock &clock)
+{
+  PosixUdpTransport udp;
+  ClockSync sync(&udp, ClockSync::Role::Follower, nodeId, LOOPBACK_BROADCAST);
+  if (!sync.begin(TEST_PORT))
+    return 2;
+
+  int64_t worstError = 0;
+  unsigned long lastMs = 0;
+  bool monotonic = true;
+  int64_t lastAdvanceUs = monotonicMicros();
+  int64_t worstStall = 0;
+  while (monotonicMicros() - epochUs < RUN_MS * 1000LL)
+  {
+    int64_t real = monotonicMicros();
+    uint64_t local = localMicros(clock, real);
+    sync.update(local);
+
+    unsigned long ms = sync.nowMs(local);
+    if ((long)(ms - lastMs) < 0)
+      monotonic = false;
+    // A follower ahead of the master must slow down, not freeze, after the first sync
+    if (ms != lastMs)
+      lastAdvanceUs = real;
+    else if (real - lastAdvanceUs > worstStall)
+      worstStall = real - lastAdvanceUs;
+    lastMs = ms;
+
+    if (real - epochUs >= SETTLE_MS * 1000LL)
+    {
+      int64_t masterNow = real - epochUs + MASTER_OFFSET_US;
+      int64_t error = (int64_t)sync.nowMicros(local) - masterNow;
+      if (error < 0)
+        error = -error;
+      if (error > worstError)
+        worstError = error;
+      if (!sync.isLocked(local))
+        return 3;
+    }
+    simulatedRender();
+  }
+
+  printf("Follower %u: worst error %.2f ms, last delay %.2f ms, %lu samples, longest stall %.2f ms\n", nodeId,
+         worstError / 1000.0, sync.getLastDelayMicros() / 1000.0, sync.getSampleCount(), worstStall / 1000.0);
+  fflush(stdout); // Children leave through _exit()
+  if (!monotonic)
+    return 4;
+  if (worstStall > MAX_STALL_US)
+    return 6;
+  return worstError <= MAX_ERROR_US ? 0 : 5;
+}
+
+static void testUnsyncedFallsBackToLocal()
+{
+  PosixUdpTransport udp;
+  ClockSync sync(&udp, ClockSync::Role::Follower, 9, LOOPBACK_BROADCAST);
+  assert(!sync.isLocked(1000000));
+  assert(sync.nowMs(1234567) == 1234);
+  assert(sync.nowMicros(42) == 42);
+}
+
+int main()
+{
+  testUnsyncedFallsBackToLocal();
+
+  epochUs = monotonicMicros();
+  const PortalClock followers[] = {
+      {3000000, 120.0, 0, 0},
+      {7000000, -150.0, 1200, -80000}, // Jumps 80 ms back mid-run: stepped, never runs backwards
+      {9000000, 0.0, 0, 0},            // 4 s ahead of the master: slows down, keeps advancing
+  };
+  const int FOLLOWERS = sizeof(followers) / sizeof(followers[0]);
+
+  pid_t master = fork();
+  if (master == 0)
+  {
+    srand(1);
+    _exit(runMaster());
+  }
+  pid_t children[FOLLOWERS];
+  for (int i = 0; i < FOLLOWERS; ++i)
+  {
+    children[i] = fork();
+    if (children[i] == 0)
+    {
+      srand(2 + i);
+      _exit(runFollower(10 + i, followers[i]));
+    }
+  }
+
+  for (pid_t child : children)
+  {
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+  int status = 0;
+  waitpid(master, &status, 0);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  std::cout << "Clock sync native test passed" << std::endl;
+  return 0;
+}
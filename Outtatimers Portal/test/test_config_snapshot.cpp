@@ -0,0 +1,60 @@
+#include "../src/config_manager.h"
+#include <cassert>
+#include <iostream>
+
+int main()
+{
+  ConfigManager::begin();
+  const ConfigManager::Snapshot initial = ConfigManager::capture();
+  assert(initial.rotationSpeed == 2);
+  assert(initial.hueMin == 160 && initial.hueMax == 200);
+
+  // Staged changes are invisible to the frame until the next capture
+  ConfigManager::setRotationSpeed(8);
+  ConfigManager::setMaxBrightness(40);
+  assert(ConfigManager::current().rotationSpeed == 2);
+  assert(ConfigManager::getRotationSpeed() == 8); // writers see staged values
+
+  const ConfigManager::Snapshot frame = ConfigManager::capture();
+  assert(frame.rotationSpeed == 8);
+  assert(frame.maxBrightness == 40);
+  assert(frame.version > initial.version);
+
+  // A frame's copy never changes, whatever happens afterwards
+  ConfigManager::setRotationSpeed(3);
+  assert(frame.rotationSpeed == 8);
+
+  // Capturing without changes keeps the version
+  const ConfigManager::Snapshot again = ConfigManager::capture();
+  assert(again.rotationSpeed == 3);
+  assert(ConfigManager::capture().version == again.version);
+
+  // An open transaction is never published halfway, and holds back
+  // regeneration until the matching values are published
+  ConfigManager::clearEffectRegenerationFlag();
+  {
+    ConfigManager::Transaction transaction;
+    ConfigManager::setHueMin(10);
+    assert(ConfigManager::capture().hueMin == 160);
+    assert(!ConfigManager::needsEffectRegeneration());
+    ConfigManager::setHueMax(30);
+    assert(ConfigManager::capture().hueMax == 200);
+  }
+  assert(ConfigManager::needsEffectRegeneration());
+  const ConfigManager::Snapshot hue = ConfigManager::capture();
+  assert(hue.hueMin == 10 && hue.hueMax == 30);
+
+  // Nested transactions publish only when the outermost one closes
+  {
+    ConfigManager::Transaction outer;
+    {
+      ConfigManager::Transaction inner;
+      ConfigManager::setPortalMode(1);
+    }
+    assert(ConfigManager::capture().portalMode == 0);
+  }
+  assert(ConfigManager::capture().portalMode == 1);
+
+  std::cout << "Config snapshot native test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include "mock_file_store.h"
+#include "../src/config_store.h"
+#include <cassert>
+#include <iostream>
+
+static const char *LOG = PortalConfig::Storage::CONFIG_LOG_PATH;
+static const unsigned long DEBOUNCE = PortalConfig::Storage::CONFIG_WRITE_DEBOUNCE_MS;
+
+// Simulate a power cycle: defaults, then restore from flash
+static int reboot(MemoryFileStore &files, ConfigStore *&store)
+{
+  delete store;
+  ConfigManager::begin();
+  store = new ConfigStore(&files);
+  return store->load();
+}
+
+int main()
+{
+  MemoryFileStore files;
+  ConfigStore *store = nullptr;
+
+  // First boot: no log, defaults stay
+  assert(reboot(files, store) == -1);
+  assert(ConfigManager::getRotationSpeed() == 2);
+
+  // A slider drag produces many changes but a single debounced write
+  unsigned long now = 1000;
+  for (int b = 100; b <= 200; b += 10)
+  {
+    ConfigManager::setMaxBrightness(b);
+    assert(!store->update(now));
+    now += 50;
+  }
+  assert(store->isDirty());
+  assert(!store->update(now + DEBOUNCE - 100));
+  assert(store->update(now + DEBOUNCE));
+  assert(store->getWriteCount() == 1);
+  assert(files.size(LOG) == (long)ConfigStore::RECORD_BYTES); // only the changed key
+  assert(!store->update(now + 2 * DEBOUNCE));                  // nothing left to write
+
+  // Venue tuning survives a reboot, restored with one read
+  ConfigManager::setRotationSpeed(7);
+  ConfigManager::setHueMin(20);
+  ConfigManager::setHueMax(40);
+  ConfigManager::setPortalMode(1);
+  store->update(now);
+  assert(store->flush());
+  files.readCalls = 0;
+  assert(reboot(files, store) == 5);
+  assert(files.readCalls == 1);
+  assert(ConfigManager::getRotationSpeed() == 7);
+  assert(ConfigManager::getMaxBrightness() == 200);
+  assert(ConfigManager::getHueMin() == 20);
+  assert(ConfigManager::getHueMax() == 40);
+  assert(ConfigManager::getPortalMode() == 1);
+  assert(!ConfigManager::needsEffectRegeneration());
+  assert(!store->isDirty());
+
+  // Changing a value back and forth before the debounce expires writes nothing
+  ConfigManager::setRotationSpeed(3);
+  ConfigManager::setRotationSpeed(7);
+  store->update(now);
+  long sizeBefore = files.size(LOG);
+  store->update(now + DEBOUNCE);
+  assert(files.size(LOG) == sizeBefore);
+
+  // The log is compacted before it outgrows its budget
+  for (int i = 0; i < 200; ++i)
+  {
+    ConfigManager::setRotationSpeed(i % 10);
+    ConfigManager::setMaxBrightness(i);
+    store->flush();
+    assert(files.size(LOG) <= (long)ConfigStore::MAX_LOG_BYTES);
+  }
+  assert(store->getCompactionCount() > 0);
+  assert(files.size(PortalConfig::Storage::CONFIG_TMP_PATH) == -1);
+  reboot(files, store);
+  assert(ConfigManager::getRotationSpeed() == 199 % 10);
+  assert(ConfigManager::getMaxBrightness() == 199);
+
+  // A write torn by power loss loses only that record and is repaired on boot
+  ConfigManager::setHueMin(99);
+  files.tearNextWrite = 3;
+  assert(!store->flush());
+  assert(reboot(files, store) > 0);
+  assert(store->getCorruptCount() == 1);
+  assert(ConfigManager::getHueMin() == 20);
+  assert(files.size(LOG) == (long)(ConfigStore::KEY_COUNT * ConfigStore::RECORD_BYTES));
+
+  // Bit rot in one record is detected by the CRC; other keys survive
+  files.files[LOG][ConfigStore::RECORD_BYTES * 2 + 2] ^= 0x01; // HueMin value
+  reboot(files, store);
+  assert(store->getCorruptCount() == 1);
+  assert(ConfigManager::getHueMin() == 160); // default
+  assert(ConfigManager::getHueMax() == 40);
+
+  // The runtime LED count is clamped and restored at boot like the rest
+  assert(ConfigManager::getLedCount() == PortalConfig::Hardware::NUM_LEDS);
+  ConfigManager::setLedCount(100000);
+  assert(ConfigManager::getLedCount() == PortalConfig::Hardware::MAX_NUM_LEDS);
+  ConfigManager::setLedCount(300);
+  assert(store->flush());
+  reboot(files, store);
+  assert(ConfigManager::getLedCount() == 300);
+
+  // So is the show clock role
+  assert(ConfigManager::isClockMaster() == PortalConfig::ClockSync::IS_MASTER);
+  ConfigManager::setClockMaster(!PortalConfig::ClockSync::IS_MASTER);
+  assert(store->flush());
+  reboot(files, store);
+  assert(ConfigManager::isClockMaster() != PortalConfig::ClockSync::IS_MASTER);
+
+  delete store;
+  std::cout << "Config store native test passed" << std::endl;
+  return 0;
+}
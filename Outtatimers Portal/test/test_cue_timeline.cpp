@@ -0,0 +1,160 @@
+#include "../src/cue_timeline.h"
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+extern "C" unsigned long millis() { return 0; }
+extern "C" int digitalRead(int pin) { return HIGH; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+// Commands are recorded; parameter cues are applied like main.cpp does
+static std::vector<IInputSource::InputEvent> fired;
+static void record(InputManager::Command, const IInputSource::InputEvent &event) { fired.push_back(event); }
+static void setSpeed(InputManager::Command, const IInputSource::InputEvent &event) { ConfigManager::setRotationSpeed(event.arg1); }
+static void setBrightness(InputManager::Command, const IInputSource::InputEvent &event) { ConfigManager::setMaxBrightness(event.arg1); }
+static void setHue(InputManager::Command, const IInputSource::InputEvent &event)
+{
+  ConfigManager::setHueMin(event.arg1);
+  ConfigManager::setHueMax(event.arg2);
+}
+static void setMode(InputManager::Command, const IInputSource::InputEvent &event) { ConfigManager::setPortalMode(event.arg1); }
+static const InputManager::CommandHandler table[InputManager::COMMAND_COUNT] = {
+    record, record, record, record, record, setSpeed, setBrightness, setHue, setMode};
+
+static IInputSource::InputEvent nextFired()
+{
+  assert(!fired.empty());
+  IInputSource::InputEvent event = fired.front();
+  fired.erase(fired.begin());
+  return event;
+}
+
+static const char *SHOW = R"(# test show
+0      toggle
+500    speed 4
+250    hue 180 220     # out of order on purpose
+1000   brightness 128
+1500   mode 1
+2000   malfunction
+bogus  line
+2500   unknown 1
+3000   fadeout
+)";
+
+int main()
+{
+  ConfigManager::begin();
+  CueTimeline timeline;
+  InputManager inputs;
+  inputs.addInputSource(&timeline);
+  inputs.setCommandTable(table);
+  assert(timeline.loadFromString(SHOW) == 7);
+  assert(timeline.getDuration() == 3000);
+  // Sorted by time
+  for (int i = 1; i < timeline.getCueCount(); ++i)
+    assert(timeline.getCue(i - 1).atMs <= timeline.getCue(i).atMs);
+
+  // Nothing fires before start
+  inputs.update(10000);
+  assert(fired.empty());
+
+  unsigned long t0 = 10000;
+  timeline.start(t0);
+  inputs.update(t0);
+  IInputSource::InputEvent event = nextFired();
+  assert(event.inputId == static_cast<int>(InputManager::Command::TogglePortal));
+  assert(event.timestamp == t0);
+  assert(fired.empty());
+
+  // Parameter cues are applied exactly at their time, in order
+  inputs.update(t0 + 249);
+  assert(ConfigManager::getHueMin() == 160);
+  inputs.update(t0 + 250);
+  assert(ConfigManager::getHueMin() == 180 && ConfigManager::getHueMax() == 220);
+  inputs.update(t0 + 1000);
+  assert(ConfigManager::getRotationSpeed() == 4);
+  assert(ConfigManager::getMaxBrightness() == 128);
+  assert(ConfigManager::getPortalMode() == 0);
+
+  // Pause keeps the position; resuming later continues from there
+  timeline.stop(t0 + 1200);
+  inputs.update(t0 + 5000);
+  assert(ConfigManager::getPortalMode() == 0);
+  timeline.start(t0 + 6000);
+  inputs.update(t0 + 6000 + 299);
+  assert(ConfigManager::getPortalMode() == 0);
+  inputs.update(t0 + 6000 + 300);
+  assert(ConfigManager::getPortalMode() == 1);
+  assert(timeline.getPosition() == 1500);
+
+  // Commands carry their scheduled timestamp even if loop() was late
+  inputs.update(t0 + 6000 + 900);
+  event = nextFired();
+  assert(event.inputId == static_cast<int>(InputManager::Command::TriggerMalfunction));
+  assert(event.timestamp == t0 + 6000 + 800);
+
+  // Seeking back chases parameter state but does not re-fire commands
+  ConfigManager::setRotationSpeed(9);
+  ConfigManager::setPortalMode(0);
+  unsigned long now = 50000;
+  timeline.seek(1200, now);
+  assert(ConfigManager::getRotationSpeed() == 4);
+  assert(ConfigManager::getPortalMode() == 0);
+  assert(!timeline.hasEvents());
+  inputs.update(now + 300);
+  assert(ConfigManager::getPortalMode() == 1);
+  inputs.update(now + 1800);
+  assert(nextFired().inputId == static_cast<int>(InputManager::Command::TriggerMalfunction));
+  assert(nextFired().inputId == static_cast<int>(InputManager::Command::FadeOut));
+  assert(timeline.getNextCueIndex() == timeline.getCueCount());
+
+  // A late loop() with more due cues than queue slots loses none of them
+  static char dense[CueTimeline::MAX_CUES * 16];
+  char *out = dense;
+  for (int i = 0; i < 40; i++)
+    out += sprintf(out, "%d speed %d\n%d malfunction\n", i, i % 10, i);
+  CueTimeline burst;
+  assert(burst.loadFromString(dense) == 80);
+  InputManager burstInputs;
+  burstInputs.addInputSource(&burst);
+  burstInputs.setCommandTable(table);
+  fired.clear();
+  burst.start(0);
+  burstInputs.update(5000);
+  for (int i = 0; i < 10 && burst.getNextCueIndex() < burst.getCueCount(); i++)
+    burstInputs.update(5000);
+  assert(fired.size() == 40);
+  assert(ConfigManager::getRotationSpeed() == 39 % 10);
+  assert(burst.getHeldBackCount() > 0);
+  assert(timeline.getHeldBackCount() == 0);
+
+  // Cues fired but not yet collected do not run after stop, seek or reload
+  CueTimeline pending;
+  assert(pending.loadFromString("0 malfunction\n10 fadeout\n") == 2);
+  pending.start(0);
+  pending.update(20);
+  assert(pending.hasEvents());
+  pending.stop(20);
+  assert(!pending.hasEvents());
+  pending.seek(0, 100);
+  pending.start(100);
+  pending.update(120);
+  assert(pending.hasEvents());
+  pending.seek(0, 120);
+  assert(!pending.hasEvents());
+  pending.update(130);
+  assert(pending.hasEvents());
+  assert(pending.loadFromString("0 toggle\n") == 1);
+  assert(!pending.hasEvents());
+
+  // A line longer than the line buffer is rejected whole, not split into cues
+  CueTimeline longLines;
+  assert(longLines.loadFromString("100 toggle # a comment long enough to run past the line buffer 900 fadeout\n"
+                                  "200 malfunction\n") == 1);
+  assert(longLines.getCue(0).atMs == 200 && longLines.getCue(0).action == CueTimeline::Action::TriggerMalfunction);
+
+    std::cout << "Cue timeline native test passed" << std::endl;
+  return 0;
+}
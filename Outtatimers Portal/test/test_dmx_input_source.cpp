@@ -0,0 +1,151 @@
+#include "mock_led_driver.h"
+#include "posix_udp_transport.h"
+#include "../src/dmx_input_source.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+// Local "lighting console": builds E1.31 / Art-Net packets and sends them to
+// the DmxInputSource over loopback UDP.
+static const uint16_t TEST_PORT = 15568;
+static const uint16_t TEST_ARTNET_PORT = 16454;
+
+static size_t buildE131(uint8_t *p, uint16_t universe, uint8_t seq, const uint8_t *slots, size_t count, uint8_t options = 0)
+{
+  memset(p, 0, 126);
+  p[1] = 0x10;
+  memcpy(p + 4, "ASC-E1.17\0\0\0", 12);
+  p[21] = 0x04; // VECTOR_ROOT_E131_DATA
+  p[43] = 0x02; // VECTOR_E131_DATA_PACKET
+  strcpy((char *)p + 44, "host-console");
+  p[108] = 100;
+  p[111] = seq;
+  p[112] = options;
+  p[113] = universe >> 8;
+  p[114] = universe & 0xFF;
+  p[117] = 0x02;
+  p[118] = 0xA1;
+  p[122] = 0x01;
+  p[123] = (uint8_t)((count + 1) >> 8);
+  p[124] = (uint8_t)((count + 1) & 0xFF);
+  memcpy(p + 126, slots, count);
+  return 126 + count;
+}
+
+static size_t buildArtDmx(uint8_t *p, uint16_t universe, const uint8_t *slots, size_t count)
+{
+  memcpy(p, "Art-Net\0", 8);
+  p[8] = 0x00;
+  p[9] = 0x50;
+  p[10] = 0;
+  p[11] = 14;
+  p[12] = 0; // sequencing disabled
+  p[13] = 0;
+  p[14] = universe & 0xFF;
+  p[15] = universe >> 8;
+  p[16] = (uint8_t)(count >> 8);
+  p[17] = (uint8_t)(count & 0xFF);
+  memcpy(p + 18, slots, count);
+  return 18 + count;
+}
+
+// Pump the receiver until the expected number of packets has been accepted
+static void pump(DmxInputSource &dmx, unsigned long now, unsigned long expectedPackets)
+{
+  for (int i = 0; i < 1000 && dmx.getPacketCount() + dmx.getRejectedCount() < expectedPackets; ++i)
+  {
+    dmx.update(now);
+    usleep(100);
+  }
+}
+
+int main()
+{
+  const int N = 800;
+  MockLEDDriver<N> mock;
+  PosixUdpTransport rx;
+  PosixUdpTransport artNetRx;
+  PosixUdpTransport console;
+  DmxInputSource dmx(&rx, &mock, N, &artNetRx);
+  assert(dmx.begin(TEST_PORT, TEST_ARTNET_PORT));
+  assert(dmx.getUniverseCount() == 5);
+
+  uint8_t slots[512];
+  uint8_t packet[700];
+  unsigned long now = 1000;
+  unsigned long sent = 0;
+
+  // Send universes 1..5, each filled with its own color
+  for (int u = 0; u < 5; ++u)
+  {
+    for (int i = 0; i < 510; i += 3)
+    {
+      slots[i] = (uint8_t)(10 * (u + 1));
+      slots[i + 1] = (uint8_t)(u + 1);
+      slots[i + 2] = (uint8_t)(200 - u);
+    }
+    size_t len = buildE131(packet, 1 + u, 1, slots, 510);
+    assert(console.send(PosixUdpTransport::loopback(), TEST_PORT, packet, len));
+    pump(dmx, now, ++sent);
+    assert(dmx.isActive(now));
+    assert(dmx.consumeFrame() == (u == 4)); // frame completes with the last universe
+  }
+  assert(dmx.getPacketCount() == 5);
+  assert(mock.buffer[0].r == 10 && mock.buffer[0].g == 1 && mock.buffer[0].b == 200);
+  assert(mock.buffer[169].r == 10);
+  assert(mock.buffer[170].r == 20 && mock.buffer[170].b == 199);
+  assert(mock.buffer[680].r == 50);
+  assert(mock.buffer[799].r == 50 && mock.buffer[799].b == 196);
+
+  // Out-of-order (stale) sequence numbers are rejected
+  size_t len = buildE131(packet, 1, 1, slots, 510);
+  console.send(PosixUdpTransport::loopback(), TEST_PORT, packet, len);
+  pump(dmx, now, ++sent);
+  assert(dmx.getRejectedCount() == 1);
+
+  // Universes outside the strip are ignored
+  len = buildE131(packet, 9, 1, slots, 510);
+  console.send(PosixUdpTransport::loopback(), TEST_PORT, packet, len);
+  pump(dmx, now, ++sent);
+  assert(dmx.getRejectedCount() == 2);
+
+  // Art-Net universe 2 (0-based) maps to pixels 340..509
+  memset(slots, 0x7F, sizeof(slots));
+  len = buildArtDmx(packet, 2, slots, 510);
+  console.send(PosixUdpTransport::loopback(), TEST_PORT, packet, len);
+  pump(dmx, now, ++sent);
+  assert(dmx.getPacketCount() == 6);
+  assert(mock.buffer[340].r == 0x7F && mock.buffer[509].b == 0x7F);
+  assert(mock.buffer[339].r == 20 && mock.buffer[510].r == 40);
+
+  // Art-Net consoles send to the Art-Net port: universe 0 maps to pixels 0..169
+  memset(slots, 0x33, sizeof(slots));
+  len = buildArtDmx(packet, 0, slots, 510);
+  assert(console.send(PosixUdpTransport::loopback(), TEST_ARTNET_PORT, packet, len));
+  pump(dmx, now, ++sent);
+  assert(dmx.getPacketCount() == 7);
+  assert(mock.buffer[0].r == 0x33 && mock.buffer[169].b == 0x33);
+  assert(mock.buffer[170].r == 20);
+
+  // Hand back to the effects after the timeout
+  now += PortalConfig::Dmx::TAKEOVER_TIMEOUT_MS;
+  dmx.update(now);
+  assert(!dmx.isActive(now));
+
+  // Stream_Terminated releases immediately
+  len = buildE131(packet, 2, 50, slots, 510);
+  console.send(PosixUdpTransport::loopback(), TEST_PORT, packet, len);
+  pump(dmx, now, ++sent);
+  assert(dmx.isActive(now));
+  len = buildE131(packet, 2, 51, slots, 0, 0x40);
+  console.send(PosixUdpTransport::loopback(), TEST_PORT, packet, len);
+  for (int i = 0; i < 100 && dmx.isActive(now); ++i)
+  {
+    dmx.update(now);
+    usleep(100);
+  }
+  assert(!dmx.isActive(now));
+
+  std::cout << "DMX input source native test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include "mock_led_driver.h"
+#include "../src/frame_preview.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+// Minimal client-side decoder mirroring data/index.html
+struct PreviewClient
+{
+  uint16_t bins[FramePreview::BINS];
+  uint16_t seq = 0;
+  bool hasFrame = false;
+
+  bool apply(const uint8_t *frame, size_t length)
+  {
+    assert(length >= FramePreview::HEADER_BYTES);
+    assert(frame[0] == FramePreview::MAGIC);
+    bool keyframe = (frame[1] & FramePreview::FLAG_KEYFRAME) != 0;
+    uint16_t frameSeq = frame[2] | (frame[3] << 8);
+    uint16_t baseSeq = frame[4] | (frame[5] << 8);
+    int binCount = frame[6];
+    int runs = frame[7];
+    size_t pos = FramePreview::HEADER_BYTES;
+    assert(binCount == FramePreview::BINS);
+
+    if (keyframe)
+    {
+      for (int i = 0; i < binCount; i++, pos += 2)
+        bins[i] = frame[pos] | (frame[pos + 1] << 8);
+    }
+    else
+    {
+      if (!hasFrame || baseSeq != seq)
+        return false;
+      for (int r = 0; r < runs; r++)
+      {
+        int start = frame[pos];
+        int len = frame[pos + 1];
+        pos += 2;
+        for (int i = 0; i < len; i++, pos += 2)
+          bins[start + i] = frame[pos] | (frame[pos + 1] << 8);
+      }
+    }
+    assert(pos == length);
+    seq = frameSeq;
+    hasFrame = true;
+    return true;
+  }
+};
+
+int main()
+{
+  const int N = 400; // 4 LEDs per preview bin
+  MockLEDDriver<N> mock;
+  for (int i = 0; i < N; ++i)
+    mock.buffer[i] = CRGB(0, 0, 200);
+  mock.buffer[0] = CRGB(255, 0, 0);
+  mock.buffer[1] = CRGB(255, 0, 0);
+  mock.buffer[2] = CRGB(255, 0, 0);
+  mock.buffer[3] = CRGB(255, 0, 0);
+
+  FramePreview preview(&mock, N);
+  PreviewClient client;
+  uint8_t frame[FramePreview::MAX_FRAME_BYTES];
+  unsigned long t = 1000;
+
+  // First request without a sequence yields a full keyframe
+  size_t len = preview.encode(t, 0, false, frame, sizeof(frame));
+  assert(len == FramePreview::MAX_FRAME_BYTES);
+  assert(frame[1] & FramePreview::FLAG_KEYFRAME);
+  assert(client.apply(frame, len));
+  assert(client.bins[0] == FramePreview::toRGB565(255, 0, 0));
+  assert(client.bins[1] == FramePreview::toRGB565(0, 0, 200));
+
+  // Averaging: one bright LED in a bin of four
+  mock.buffer[4] = CRGB(200, 0, 200);
+
+  // Polling faster than the cap reuses the cached frame (no new capture)
+  unsigned long captures = preview.getCaptureCount();
+  len = preview.encode(t + 10, client.seq, true, frame, sizeof(frame));
+  assert(len == FramePreview::HEADER_BYTES);
+  assert(preview.getCaptureCount() == captures);
+
+  // After the interval a delta with a single changed bin is sent
+  t += PortalConfig::Preview::MIN_FRAME_INTERVAL_MS;
+  len = preview.encode(t, client.seq, true, frame, sizeof(frame));
+  assert(!(frame[1] & FramePreview::FLAG_KEYFRAME));
+  assert(frame[7] == 1);
+  assert(len == FramePreview::HEADER_BYTES + 2 + 2);
+  assert(client.apply(frame, len));
+  assert(client.bins[1] == FramePreview::toRGB565(50, 0, 200));
+
+  // A client that missed frames gets a keyframe again
+  mock.buffer[N - 1] = CRGB(0, 255, 0);
+  t += PortalConfig::Preview::MIN_FRAME_INTERVAL_MS;
+  preview.encode(t, client.seq, true, frame, sizeof(frame));
+  t += PortalConfig::Preview::MIN_FRAME_INTERVAL_MS;
+  len = preview.encode(t, client.seq, true, frame, sizeof(frame));
+  assert(frame[1] & FramePreview::FLAG_KEYFRAME);
+  assert(client.apply(frame, len));
+  assert(client.seq == preview.getSequence());
+
+  // Fully changed frames fall back to a keyframe and never exceed the bound
+  for (int i = 0; i < N; ++i)
+    mock.buffer[i] = CRGB((uint8_t)i, (uint8_t)(i * 3), (uint8_t)(i * 7));
+  t += PortalConfig::Preview::MIN_FRAME_INTERVAL_MS;
+  len = preview.encode(t, client.seq, true, frame, sizeof(frame));
+  assert(len <= FramePreview::MAX_FRAME_BYTES);
+  assert(client.apply(frame, len));
+
+  // Undersized output buffers are rejected
+  assert(preview.encode(t, 0, false, frame, 4) == 0);
+
+  std::cout << "Frame preview native test passed" << std::endl;
+  return 0;
+}
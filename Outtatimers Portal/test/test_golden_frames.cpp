@@ -0,0 +1,247 @@
+#include "mock_led_driver.h"
+#include "../src/portal_effect.h"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Golden-frame regression test: every scenario runs from a fixed seed on a
+// simulated clock and must reproduce the stored frames. Run with --update
+// after an intentional visual change to rewrite test/golden/portal_frames.golden.
+// Colors come from the test build's simplified CHSV, so the goldens cover
+// layout and timing, not the exact colors of FastLED.
+
+static unsigned long simulated_time = 0;
+extern "C" unsigned long millis() { return simulated_time; }
+
+static const int N = 64;
+typedef PortalEffectTemplate<N, PortalConfig::Effects::GRADIENT_STEP_DEFAULT, PortalConfig::Effects::GRADIENT_MOVE_DEFAULT>
+    GoldenPortal;
+
+/**
+ * @brief Hashes every shown frame (colors and brightness) into a running FNV-1a
+ */
+class HashingDriver : public MockLEDDriver<N>
+{
+public:
+  uint32_t hash = 2166136261u;
+  unsigned long shows = 0;
+
+  void show() override
+  {
+    mix(brightness);
+    for (int i = 0; i < N; i++)
+    {
+      mix(buffer[i].r);
+      mix(buffer[i].g);
+      mix(buffer[i].b);
+    }
+    shows++;
+  }
+
+private:
+  void mix(uint8_t byte)
+  {
+    hash ^= byte;
+    hash *= 16777619u;
+  }
+};
+
+/**
+ * @brief A command applied at a point of the simulated timeline
+ */
+struct Action
+{
+  unsigned long atMs;
+  void (*apply)(GoldenPortal &portal);
+};
+
+struct Scenario
+{
+  const char *name;
+  unsigned seed;
+  void (*configure)();
+  std::vector<Action> actions;
+  std::vector<unsigned long> captureMs; ///< Frames stored in full
+  unsigned long durationMs;
+  int tolerance; ///< Largest per-channel difference accepted; 0 = bit-exact
+};
+
+static void start(GoldenPortal &portal) { portal.start(); }
+static void fadeOut(GoldenPortal &portal) { portal.triggerFadeOut(); }
+static void malfunction(GoldenPortal &portal) { portal.triggerMalfunction(); }
+static void stop(GoldenPortal &portal) { portal.stop(); }
+
+static void classic() {}
+static void virtualGradients() { ConfigManager::setPortalMode(1); }
+static void fastWrappedHue()
+{
+  ConfigManager::setRotationSpeed(7);
+  ConfigManager::setHueMin(250);
+  ConfigManager::setHueMax(10);
+  ConfigManager::setMaxBrightness(140);
+}
+
+static std::string toHex(const CRGB *leds)
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string hex;
+  for (int i = 0; i < N; i++)
+  {
+    for (uint8_t byte : {leds[i].r, leds[i].g, leds[i].b})
+    {
+      hex += digits[byte >> 4];
+      hex += digits[byte & 15];
+    }
+  }
+  return hex;
+}
+
+/**
+ * @brief Results of one run: the running hash and the captured frames as hex
+ */
+struct Run
+{
+  uint32_t hash;
+  unsigned long shows;
+  std::map<unsigned long, std::string> frames;
+};
+
+static Run run(const Scenario &scenario)
+{
+  ConfigManager::begin();
+  scenario.configure();
+  ConfigManager::capture();
+  randomSeed(scenario.seed);
+
+  LedArena arena;
+  assert(arena.begin(GoldenPortal::arenaBytes(N)));
+  HashingDriver driver;
+  GoldenPortal portal(&driver, &arena);
+  assert(portal.begin());
+
+  Run result;
+  size_t nextAction = 0;
+  for (unsigned long t = 0; t <= scenario.durationMs; t += PortalConfig::Timing::UPDATE_INTERVAL_MS)
+  {
+    simulated_time = t;
+    while (nextAction < scenario.actions.size() && scenario.actions[nextAction].atMs <= t)
+      scenario.actions[nextAction++].apply(portal);
+    portal.update(t);
+    for (unsigned long at : scenario.captureMs)
+    {
+      if (at == t)
+        result.frames[t] = toHex(driver.buffer);
+    }
+  }
+  result.hash = driver.hash;
+  result.shows = driver.shows;
+  return result;
+}
+
+static int maxDifference(const std::string &a, const std::string &b)
+{
+  if (a.size() != b.size())
+    return 256;
+  int worst = 0;
+  for (size_t i = 0; i + 1 < a.size(); i += 2)
+  {
+    int diff = abs((int)strtol(a.substr(i, 2).c_str(), nullptr, 16) - (int)strtol(b.substr(i, 2).c_str(), nullptr, 16));
+    if (diff > worst)
+      worst = diff;
+  }
+  return worst;
+}
+
+int main(int argc, char **argv)
+{
+  bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+  const char *path = argc > 1 + (int)update ? argv[1 + (int)update] : "test/golden/portal_frames.golden";
+
+  const std::vector<Scenario> scenarios = {
+      {"classic", 1, classic, {{0, start}}, {0, 500, 1500, 3000, 6000}, 6000, 0},
+      {"virtual", 2, virtualGradients, {{0, start}}, {0, 1000, 3000, 6000}, 6000, 0},
+      {"fadeout", 3, classic, {{0, start}, {4000, fadeOut}}, {4000, 4100, 4200}, 4500, 0},
+      {"malfunction", 4, classic, {{0, start}, {1000, malfunction}, {4000, stop}}, {1000, 1500, 2500, 3990}, 4500, 0},
+      {"wrapped_hue", 5, fastWrappedHue, {{0, start}}, {0, 3000, 5000}, 5000, 0},
+  };
+
+  std::vector<Run> runs;
+  for (const Scenario &scenario : scenarios)
+  {
+    Run result = run(scenario);
+    assert(result.shows > 0);
+    // Same seed, same frames: the effects must not depend on anything else
+    assert(run(scenario).hash == result.hash);
+    runs.push_back(result);
+  }
+
+  if (update)
+  {
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fprintf(file, "# Golden portal frames (%d LEDs), written by test_golden_frames --update\n", N);
+    fprintf(file, "# scenario  time_ms|all  fnv1a  [frame as rrggbb per LED]\n");
+    for (size_t s = 0; s < scenarios.size(); s++)
+    {
+      fprintf(file, "%s all %08x %lu\n", scenarios[s].name, runs[s].hash, runs[s].shows);
+      for (const auto &frame : runs[s].frames)
+        fprintf(file, "%s %lu %s\n", scenarios[s].name, frame.first, frame.second.c_str());
+    }
+    fclose(file);
+    std::cout << "Golden frames written to " << path << std::endl;
+    return 0;
+  }
+
+  // Load the stored goldens
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    std::cerr << "Missing " << path << " (run with --update to create it)" << std::endl;
+    return 1;
+  }
+  std::map<std::string, std::string> golden;
+  char line[1024];
+  while (fgets(line, sizeof(line), file))
+  {
+    if (line[0] == '#')
+      continue;
+    char name[64], when[16], value[512];
+    if (sscanf(line, "%63s %15s %511s", name, when, value) == 3)
+      golden[std::string(name) + " " + when] = value;
+  }
+  fclose(file);
+
+  int failures = 0;
+  for (size_t s = 0; s < scenarios.size(); s++)
+  {
+    const Scenario &scenario = scenarios[s];
+    char hash[16];
+    snprintf(hash, sizeof(hash), "%08x", runs[s].hash);
+    bool exact = golden[std::string(scenario.name) + " all"] == hash;
+    for (const auto &frame : runs[s].frames)
+    {
+      std::string key = std::string(scenario.name) + " " + std::to_string(frame.first);
+      int diff = golden.count(key) ? maxDifference(golden[key], frame.second) : 256;
+      if (diff > scenario.tolerance)
+      {
+        std::cerr << "Golden mismatch: " << key << " differs by up to " << diff << std::endl;
+        failures++;
+      }
+    }
+    if (!exact && scenario.tolerance == 0)
+    {
+      std::cerr << "Golden mismatch: " << scenario.name << " frame hash " << hash << std::endl;
+      failures++;
+    }
+  }
+  if (failures > 0)
+    return 1;
+
+  std::cout << "Golden frames native test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include "mock_led_driver.h"
+#include "../src/heap_monitor.h"
+#include "../src/response_buffer.h"
+#include "../src/portal_effect.h"
+#include "../src/frame_preview.h"
+#include "../src/wifi_input_source.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static unsigned long simulated_time = 0;
+extern "C" unsigned long millis() { return simulated_time; }
+
+int main()
+{
+  // The operator new hook counts allocations once armed
+  HeapMonitor::begin();
+  assert(HeapMonitor::getAllocationsSinceSetup() == 0);
+  {
+    std::vector<int> numbers(1000, 1);
+    assert(HeapMonitor::getAllocationsSinceSetup() == 1);
+    assert(HeapMonitor::getStats().heapGrowthHigh >= 1000 * sizeof(int));
+  }
+  uint32_t growth = HeapMonitor::getStats().heapGrowthHigh;
+  std::vector<int> small(10, 1);
+  assert(HeapMonitor::getStats().heapGrowthHigh == growth); // high water mark, not current use
+
+  // Response formatting stays inside its fixed buffer and reports truncation
+  ResponseBuffer<48> response;
+  response.append("{\"speed\":").appendf("%d", 7).append("}");
+  assert(strcmp(response.c_str(), "{\"speed\":7}") == 0);
+  response.clear();
+  for (int i = 0; i < 10; ++i)
+    response.appendf("line %d\n", i);
+  assert(response.overflowed());
+  assert(response.length() == 47);
+  assert(strlen(response.c_str()) == 47);
+  response.clear();
+  response.append(std::string(100, 'x').c_str());
+  assert(response.overflowed() && response.length() == 47);
+
+  // Everything a show touches per frame or per request is set up once ...
+  const int N = 200;
+  LedArena arena;
+  assert(arena.begin(PortalEffectTemplate<N, 4, 1>::arenaBytes(N)));
+  MockLEDDriver<N> mock;
+  PortalEffectTemplate<N, 4, 1> portal(&mock, &arena);
+  assert(portal.begin());
+  FramePreview preview(&mock, N);
+  static uint8_t frame[FramePreview::MAX_FRAME_BYTES];
+  static WiFiInputSource wifi(80);
+  wifi.attachPreview(&preview);
+  wifi.attachArena(&arena);
+  ConfigManager::begin();
+
+  // ... so that rendering, preview encoding and the formatting of the
+  // /config and /status responses perform no allocations at all. The web
+  // server's own per-request Strings (arguments, reply) are not covered.
+  HeapMonitor::begin();
+  uint16_t seq = 0;
+  for (int mode = 0; mode <= 1; ++mode)
+  {
+    ConfigManager::setPortalMode(mode);
+    portal.start();
+    for (int k = 0; k < 500; ++k)
+    {
+      simulated_time += 20;
+      portal.update(simulated_time);
+      if (k % 10 == 0)
+      {
+        preview.encode(simulated_time, seq, k > 0, frame, sizeof(frame));
+        seq++;
+        assert(strncmp(wifi.formatConfig(), "{\"speed\":", 9) == 0);
+        assert(strstr(wifi.formatStatus(), "LED Arena: ") != nullptr);
+      }
+      if (k == 250)
+        portal.triggerMalfunction();
+    }
+    portal.triggerFadeOut();
+    for (int k = 0; k < 200; ++k)
+    {
+      simulated_time += 20;
+      portal.update(simulated_time);
+    }
+  }
+  HeapMonitor::sample();
+  assert(HeapMonitor::getAllocationsSinceSetup() == 0);
+  assert(HeapMonitor::getStats().heapGrowthHigh == 0);
+
+  std::cout << "Heap monitor native test passed" << std::endl;
+  return 0;
+}
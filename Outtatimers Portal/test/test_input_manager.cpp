@@ -0,0 +1,195 @@
+#include "../src/input_manager.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+extern "C" unsigned long millis() { return 0; }
+extern "C" int digitalRead(int pin) { return HIGH; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+/**
+ * @brief Input source replaying a fixed list of events
+ */
+class ScriptedSource : public IInputSource
+{
+public:
+  std::vector<InputEvent> events;
+  size_t next = 0;
+  const char *name = "Script";
+
+  void push(int inputId, EventType type = EventType::Pressed, int16_t arg1 = 0, int16_t arg2 = 0)
+  {
+    events.push_back({inputId, type, 0, name, arg1, arg2});
+  }
+
+  bool update(unsigned long) override { return hasEvents(); }
+  bool hasEvents() const override { return next < events.size(); }
+  InputEvent getNextEvent() override { return events[next++]; }
+  const char *getSourceName() const override { return name; }
+};
+
+struct Call
+{
+  const char *handler;
+  InputManager::Command command;
+  int16_t arg1;
+  int16_t arg2;
+};
+static std::vector<Call> calls;
+
+static void onToggle(InputManager::Command command, const IInputSource::InputEvent &) { calls.push_back({"toggle", command, 0, 0}); }
+static void onMalfunction(InputManager::Command command, const IInputSource::InputEvent &) { calls.push_back({"malfunction", command, 0, 0}); }
+static void onAny(InputManager::Command command, const IInputSource::InputEvent &) { calls.push_back({"any", command, 0, 0}); }
+static void onParameter(InputManager::Command command, const IInputSource::InputEvent &event)
+{
+  calls.push_back({"parameter", command, event.arg1, event.arg2});
+}
+
+int main()
+{
+  ScriptedSource script;
+  InputManager manager;
+  manager.addInputSource(&script);
+
+  // Each command reaches its own handler; a missing handler rejects it
+  static const InputManager::CommandHandler table[InputManager::COMMAND_COUNT] = {onToggle, onMalfunction};
+  manager.setCommandTable(table);
+  script.push(1);
+  script.push(2);
+  script.push(2, IInputSource::EventType::Released); // releases are not commands
+  script.push(3);
+  manager.update(0);
+  assert(calls.size() == 2);
+  assert(strcmp(calls[0].handler, "toggle") == 0 && calls[0].command == InputManager::Command::TogglePortal);
+  assert(strcmp(calls[1].handler, "malfunction") == 0 && calls[1].command == InputManager::Command::TriggerMalfunction);
+  assert(manager.getRejectedCount() == 1);
+
+  // Unknown or corrupted IDs are rejected, never mapped to a default command
+  calls.clear();
+  for (int id : {0, -1, InputManager::COMMAND_COUNT + 1, 255, 1 << 20})
+    script.push(id);
+  manager.update(0);
+  assert(calls.empty());
+  assert(manager.getRejectedCount() == 6);
+
+  // A single callback serves every known command when no table is set
+  InputManager single;
+  single.addInputSource(&script);
+  single.setInputCallback(onAny);
+  for (int id = 0; id <= InputManager::COMMAND_COUNT + 1; id++)
+    script.push(id);
+  single.update(0);
+  assert(calls.size() == (size_t)InputManager::COMMAND_COUNT);
+  for (int i = 0; i < InputManager::COMMAND_COUNT; i++)
+    assert(static_cast<int>(calls[i].command) == i + 1);
+  assert(single.getRejectedCount() == 2);
+
+  // Parameter updates are coalesced to the newest value per command and
+  // applied after the other commands of the update
+  static const InputManager::CommandHandler full[InputManager::COMMAND_COUNT] = {
+      onToggle, onMalfunction, onAny, onAny, onAny, onParameter, onParameter, onParameter, onParameter};
+  InputManager params;
+  params.addInputSource(&script);
+  params.setCommandTable(full);
+  calls.clear();
+  const int speed = static_cast<int>(InputManager::Command::SetSpeed);
+  const int hue = static_cast<int>(InputManager::Command::SetHue);
+  for (int16_t value = 0; value < 200; value++) // a fader sweep within one loop iteration
+    script.push(speed, IInputSource::EventType::Pressed, value);
+  script.push(hue, IInputSource::EventType::Pressed, 10, 40);
+  script.push(hue, IInputSource::EventType::Pressed, 20, 60);
+  script.push(1);
+  script.push(speed, IInputSource::EventType::Pressed, 3);
+  params.update(0);
+  assert(calls.size() == 3);
+  assert(strcmp(calls[0].handler, "toggle") == 0);
+  assert(calls[1].command == InputManager::Command::SetSpeed && calls[1].arg1 == 3);
+  assert(calls[2].command == InputManager::Command::SetHue && calls[2].arg1 == 20 && calls[2].arg2 == 60);
+  assert(params.getCoalescedCount() == 200 + 1);
+  assert(InputManager::isParameterCommand(InputManager::Command::SetMode));
+  assert(!InputManager::isParameterCommand(InputManager::Command::DimStep));
+
+  // Show cues run before mode changes, whatever order they arrived in
+  calls.clear();
+  script.push(4);
+  script.push(speed, IInputSource::EventType::Pressed, 5);
+  script.push(3);
+  script.push(2);
+  params.update(0);
+  assert(calls.size() == 4);
+  assert(calls[0].command == InputManager::Command::FadeOut);
+  assert(calls[1].command == InputManager::Command::TriggerMalfunction);
+  assert(calls[2].command == InputManager::Command::CycleMode);
+  assert(calls[3].command == InputManager::Command::SetSpeed);
+
+  // Two toggles in one update cancel out; a third still toggles
+  calls.clear();
+  unsigned long coalesced = params.getCoalescedCount();
+  script.push(1);
+  script.push(2);
+  script.push(1);
+  script.push(1);
+  params.update(0);
+  assert(calls.size() == 2);
+  assert(strcmp(calls[0].handler, "malfunction") == 0 && strcmp(calls[1].handler, "toggle") == 0);
+  assert(params.getCoalescedCount() == coalesced + 2);
+
+  // Toggles from two sources in one update both run
+  ScriptedSource web;
+  web.name = "WiFi";
+  params.addInputSource(&web);
+  calls.clear();
+  script.push(1);
+  web.push(1);
+  params.update(0);
+  assert(calls.size() == 2);
+  assert(calls[0].command == InputManager::Command::TogglePortal && calls[1].command == InputManager::Command::TogglePortal);
+  assert(params.getCoalescedCount() == coalesced + 2);
+
+  // A flood from one source cannot crowd out another source's press: the
+  // press is gathered in the first round, the flood's newest entries drop
+  ScriptedSource flood;
+  ScriptedSource button;
+  InputManager fair;
+  fair.addInputSource(&flood);
+  fair.addInputSource(&button);
+  fair.setCommandTable(full);
+  calls.clear();
+  for (int i = 0; i < 40; i++)
+    flood.push(4);
+  button.push(3);
+  fair.update(0);
+  assert(calls.size() == 16);
+  assert(calls[0].command == InputManager::Command::FadeOut);
+  assert(fair.getDroppedCount() == 40 - 15);
+
+  // A more urgent command evicts the newest less urgent one from a full queue
+  calls.clear();
+  for (int i = 0; i < 20; i++)
+    flood.push(5);
+  for (int i = 0; i < 20; i++)
+    flood.push(2);
+  fair.update(0);
+  assert(calls.size() == 16);
+  for (const Call &call : calls)
+    assert(call.command == InputManager::Command::TriggerMalfunction);
+
+  // PriorityQueue: FIFO within a priority, drops the new item when nothing is less urgent
+  PriorityQueue<int, 3> queue;
+  assert(queue.push(1, 1) && queue.push(2, 0) && queue.push(3, 1));
+  assert(!queue.push(4, 1) && queue.getDroppedCount() == 1);
+  assert(queue.push(5, 0) && queue.getDroppedCount() == 2 && queue.size() == 3);
+  int item;
+  assert(queue.pop(item) && item == 2);
+  assert(queue.pop(item) && item == 5);
+  assert(queue.pop(item) && item == 1);
+  assert(!queue.pop(item) && queue.isEmpty());
+
+  for (int id = 1; id <= InputManager::COMMAND_COUNT; id++)
+    assert(strcmp(InputManager::getCommandName(static_cast<InputManager::Command>(id)), "Unknown") != 0);
+
+  std::cout << "Input manager native test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include "../src/input_manager.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static unsigned long simulated_us = 0;
+
+extern "C" unsigned long millis() { return simulated_us / 1000; }
+extern "C" unsigned long micros() { return simulated_us; }
+extern "C" int digitalRead(int pin) { return HIGH; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+/**
+ * @brief Input source replaying a fixed list of events
+ */
+class ScriptedSource : public IInputSource
+{
+public:
+  std::vector<InputEvent> events;
+  size_t next = 0;
+
+  void push(int inputId, unsigned long timestamp, int16_t arg1 = 0)
+  {
+    events.push_back({inputId, EventType::Pressed, timestamp, "Script", arg1, 0});
+  }
+
+  bool update(unsigned long) override { return hasEvents(); }
+  bool hasEvents() const override { return next < events.size(); }
+  InputEvent getNextEvent() override { return events[next++]; }
+  const char *getSourceName() const override { return "Script"; }
+};
+
+// Every handler takes 300 us to change the effect state
+static void slowHandler(InputManager::Command, const IInputSource::InputEvent &) { simulated_us += 300; }
+
+int main()
+{
+  // Histogram: percentiles report bucket upper edges, never above the maximum
+  LatencyHistogram histogram;
+  assert(histogram.percentile(500) == 0 && histogram.getCount() == 0);
+  for (int i = 0; i < 90; i++)
+    histogram.record(400); // 250-500 bucket
+  for (int i = 0; i < 9; i++)
+    histogram.record(1800); // 1500-2000 bucket
+  histogram.record(2500000); // beyond the last edge
+  assert(histogram.getCount() == 100 && histogram.getMax() == 2500000);
+  assert(histogram.percentile(500) == 500);
+  assert(histogram.percentile(900) == 500);
+  assert(histogram.percentile(990) == 2000);
+  assert(histogram.percentile(1000) == 2500000);
+  LatencyHistogram single;
+  single.record(120);
+  assert(single.percentile(990) == 120);
+  histogram.reset();
+  assert(histogram.getCount() == 0 && histogram.getMax() == 0);
+
+  ScriptedSource script;
+  InputManager manager;
+  LatencyTracer tracer;
+  static const InputManager::CommandHandler table[InputManager::COMMAND_COUNT] = {
+      slowHandler, slowHandler, slowHandler, slowHandler, slowHandler,
+      slowHandler, slowHandler, slowHandler, slowHandler};
+  manager.setCommandTable(table);
+  manager.addInputSource(&script);
+  manager.setTracer(&tracer);
+
+  // Captured at 10 ms, dispatched at 12 ms, shown 5 ms after the effect changed
+  simulated_us = 12000;
+  script.push(1, 10);
+  manager.update(12);
+  const LatencyHistogram &dispatch = tracer.getHistogram(LatencyTracer::Stage::Dispatch);
+  const LatencyHistogram &apply = tracer.getHistogram(LatencyTracer::Stage::Apply);
+  const LatencyHistogram &show = tracer.getHistogram(LatencyTracer::Stage::Show);
+  assert(dispatch.getCount() == 1 && dispatch.getMax() == 2000);
+  assert(apply.getCount() == 1 && apply.getMax() == 2300);
+  assert(show.getCount() == 0);
+  simulated_us += 5000;
+  tracer.shown();
+  assert(show.getCount() == 1 && show.getMax() == 7300);
+  tracer.shown(); // nothing pending: no sample
+  assert(show.getCount() == 1);
+
+  // Coalesced parameter commands are traced once, from the event that was applied
+  simulated_us = 100000;
+  script.push(7, 95, 10);
+  script.push(7, 98, 20);
+  manager.update(100);
+  assert(manager.getCoalescedCount() == 1);
+  assert(dispatch.getCount() == 2 && dispatch.getMax() == 2000);
+  simulated_us += 1000;
+  tracer.shown();
+  assert(show.getCount() == 2);
+
+  // One show closes every command dispatched before it; overflow is counted
+  simulated_us = 200000;
+  for (int i = 0; i < LatencyTracer::MAX_PENDING + 2; i++)
+    script.push(2, 200);
+  manager.update(200);
+  assert(tracer.getDroppedCount() == 2);
+  tracer.shown();
+  assert(show.getCount() == 2 + (uint32_t)LatencyTracer::MAX_PENDING);
+
+  // A detached tracer sees nothing
+  manager.setTracer(nullptr);
+  script.push(1, 300);
+  manager.update(300);
+  assert(dispatch.getCount() == 2 + (uint32_t)LatencyTracer::MAX_PENDING + 2);
+
+  // JSON report
+  ResponseBuffer<384> json;
+  tracer.appendJson(json);
+  assert(strncmp(json.c_str(), "{\"dispatch\":{\"count\":12,", 24) == 0);
+  assert(strstr(json.c_str(), "\"show\":{\"count\":10,") != nullptr);
+  assert(strstr(json.c_str(), "\"dropped\":2}") != nullptr);
+  tracer.reset();
+  json.clear();
+  tracer.appendJson(json);
+  assert(strstr(json.c_str(), "\"apply\":{\"count\":0,\"p50\":0,\"p90\":0,\"p99\":0,\"max\":0}") != nullptr);
+
+  std::cout << "Latency tracer native test passed" << std::endl;
+  return 0;
+}
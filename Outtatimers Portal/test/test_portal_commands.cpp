@@ -0,0 +1,69 @@
+#include "../src/portal_commands.h"
+#include <cassert>
+#include <iostream>
+
+extern "C" unsigned long millis() { return 0; }
+extern "C" int digitalRead(int pin) { return 1; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+// Show that only counts what the handlers asked for
+struct CountingShow
+{
+  static int starts, stops, malfunctions, fadeOuts;
+  static void start() { starts++; }
+  static void stop() { stops++; }
+  static void triggerMalfunction() { malfunctions++; }
+  static void triggerFadeOut() { fadeOuts++; }
+  static void log(const char *) {}
+};
+int CountingShow::starts = 0;
+int CountingShow::stops = 0;
+int CountingShow::malfunctions = 0;
+int CountingShow::fadeOuts = 0;
+
+typedef PortalCommands<CountingShow> Commands;
+
+static void dim()
+{
+  IInputSource::InputEvent event = {static_cast<int>(InputManager::Command::DimStep), IInputSource::EventType::Pressed,
+                                    0, "Test"};
+  Commands::dimStep(InputManager::Command::DimStep, event);
+}
+
+int main()
+{
+  IInputSource::InputEvent event = {0, IInputSource::EventType::Pressed, 0, "Test"};
+  Commands::togglePortal(InputManager::Command::TogglePortal, event);
+  assert(Commands::isRunning() && CountingShow::starts == 1);
+  Commands::togglePortal(InputManager::Command::TogglePortal, event);
+  assert(!Commands::isRunning() && CountingShow::stops == 1);
+
+  // Holding dim walks down to the floor, never wrapping to full
+  ConfigManager::setMaxBrightness(255);
+  uint8_t last = 255;
+  for (int i = 0; i < 15; i++)
+  {
+    dim();
+    assert(ConfigManager::getMaxBrightness() < last);
+    last = ConfigManager::getMaxBrightness();
+  }
+  assert(last == PortalConfig::Timing::DIM_MIN);
+
+  // At the floor it turns back up, and at full it turns down again
+  dim();
+  assert(ConfigManager::getMaxBrightness() == PortalConfig::Timing::DIM_MIN + PortalConfig::Timing::DIM_STEP);
+  for (int i = 0; i < 20 && ConfigManager::getMaxBrightness() < 255; i++)
+    dim();
+  assert(ConfigManager::getMaxBrightness() == 255);
+  dim();
+  assert(ConfigManager::getMaxBrightness() == 255 - PortalConfig::Timing::DIM_STEP);
+
+  // A brightness below the floor set from the web page steps up
+  ConfigManager::setMaxBrightness(5);
+  dim();
+  assert(ConfigManager::getMaxBrightness() == 5 + PortalConfig::Timing::DIM_STEP);
+
+  std::cout << "Portal commands native test passed" << std::endl;
+  return 0;
+}
@@ -1,4 +1,3 @@
-#define UNIT_TEST
 #include "mock_led_driver.h"
 #include "../src/portal_effect.h"
 #include <cassert>
@@ -8,23 +7,63 @@
 static unsigned long simulated_time = 0;
 extern "C" unsigned long millis() { return simulated_time; }
 
-// Simple CRGB subtraction and multiplication for testing
-CRGB crgbSubtractAndScale(const CRGB &c1, const CRGB &c2, float scale)
+static bool between(uint8_t v, uint8_t a, uint8_t b)
 {
-  return CRGB(
-      (uint8_t)(c1.r + (c2.r - c1.r) * scale),
-      (uint8_t)(c1.g + (c2.g - c1.g) * scale),
-      (uint8_t)(c1.b + (c2.b - c1.b) * scale));
+  return a <= b ? (v >= a && v <= b) : (v >= b && v <= a);
+}
+
+// Driver with guard pixels after the ring to catch out-of-range writes
+template <int N>
+class GuardedLEDDriver : public MockLEDDriver<N + 4>
+{
+public:
+  GuardedLEDDriver() { this->length = N; }
+  void fillSolid(const CRGB &c) override
+  {
+    for (int i = 0; i < this->length; ++i)
+      this->buffer[i] = c;
+  }
+  void clear() override { fillSolid(CRGB()); }
+  void setGuard()
+  {
+    for (int i = N; i < N + 4; ++i)
+      this->buffer[i] = CRGB(1, 2, 3);
+  }
+  bool guardIntact() const
+  {
+    for (int i = N; i < N + 4; ++i)
+    {
+      if (this->buffer[i].r != 1 || this->buffer[i].g != 2 || this->buffer[i].b != 3)
+        return false;
+    }
+    return true;
+  }
+};
+
+// Run an instance through start, a few seconds of frames and stop
+template <int N>
+static void runFrames(PortalEffectTemplate<N, 4, 1> &portal, unsigned long &t)
+{
+  portal.start();
+  for (int k = 0; k < 200; ++k)
+  {
+    t += 20;
+    portal.update(t);
+  }
+  portal.stop();
 }
 
 int main()
 {
   // Use small N for native test
   const int N = 32;
+  LedArena arena;
+  assert(arena.begin(4096));
   MockLEDDriver<N> mock;
-  PortalEffectTemplate<N, 4, 1> portal(&mock);
+  PortalEffectTemplate<N, 4, 1> portal(&mock, &arena);
 
-  portal.begin();
+  assert(portal.begin());
+  assert(arena.getUsed() == (PortalEffectTemplate<N, 4, 1>::arenaBytes(N)));
   portal.setBrightness(128);
   portal.fillSolid(CRGB::Red());
   // verify buffer filled with red
@@ -40,35 +79,113 @@ int main()
   CRGB *result = portal.testGeneratePortalEffect(testBuffer);
   assert(result == testBuffer);
 
-  // Check gradient generation
-  int numDrivers = 0;
-  CRGB driverColors[N];
-  portal.generateDriverColors(driverColors, numDrivers);
-
-  for (int d = 0; d < numDrivers - 1; d++)
+  // Drivers span the ring in increasing order, and every LED between two
+  // drivers lies between the colors at its segment's endpoints
+  assert(portal.testGetDriverIndex(0) == 0);
+  int d = 0;
+  while (portal.testGetDriverIndex(d) < N)
   {
     int start = portal.testGetDriverIndex(d);
     int end = portal.testGetDriverIndex(d + 1);
-    CRGB c1 = driverColors[d];
-    CRGB c2 = driverColors[d + 1];
-
+    assert(end > start);
+    assert(end - start <= PortalConfig::Effects::MAX_DRIVER_DISTANCE + PortalConfig::Effects::MIN_DRIVER_DISTANCE);
+    const CRGB &c1 = testBuffer[start];
+    const CRGB &c2 = testBuffer[end - 1];
     for (int i = start; i < end; i++)
     {
-      float ratio = (float)(i - start) / (end - start);
-      CRGB expectedColor = c1 + (c2 - c1) * ratio;
-      assert(testBuffer[i].r == expectedColor.r);
-      assert(testBuffer[i].g == expectedColor.g);
-      assert(testBuffer[i].b == expectedColor.b);
+      assert(between(testBuffer[i].r, c1.r, c2.r));
+      assert(between(testBuffer[i].g, c1.g, c2.g));
+      assert(between(testBuffer[i].b, c1.b, c2.b));
     }
+    d++;
   }
+  assert(portal.testGetDriverIndex(d) == N);
+
   // Start portal and run a few updates to ensure no crashes
-  portal.start();
   unsigned long t = 0;
-  for (int k = 0; k < 10; ++k)
+  runFrames(portal, t);
+
+  // Two rings of different lengths side by side, in both modes: each keeps
+  // its own buffers and never writes past its own LEDs
+  const int INNER = 20;
+  GuardedLEDDriver<INNER> innerMock;
+  PortalEffectTemplate<INNER, 4, 1> inner(&innerMock, &arena);
+  assert(inner.begin());
+  innerMock.setGuard();
+  assert(inner.getEffectLength() == INNER);
+  assert(inner.getEffectBuffer() != portal.getEffectBuffer());
+
+  for (int mode = 0; mode <= 1; ++mode)
   {
-    t += 50;
+    ConfigManager::setPortalMode(mode);
+    ConfigManager::capture();
+    runFrames(portal, t);
+    runFrames(inner, t);
+    portal.start();
+    inner.start();
+    for (int k = 0; k < 50; ++k)
+    {
+      t += 20;
+      portal.update(t);
+      inner.update(t);
+    }
+    assert(innerMock.guardIntact());
+  }
+  // Virtual gradient mode is anchored to the clock like the classic mode:
+  // portals started at different moments reach the same positions
+  LedArena lateArena;
+  assert(lateArena.begin(PortalEffectTemplate<N, 4, 1>::arenaBytes(N)));
+  MockLEDDriver<N> lateMock;
+  PortalEffectTemplate<N, 4, 1> late(&lateMock, &lateArena);
+  assert(late.begin());
+  ConfigManager::setRotationSpeed(6);
+  ConfigManager::capture();
+  portal.stop();
+  portal.start();
+  for (int k = 0; k < 60; ++k)
+  {
+    t += 20;
     portal.update(t);
+    if (k == 23)
+      late.start();
+    late.update(t);
   }
+  assert(late.testGetGradientPos1() == portal.testGetGradientPos1());
+  assert(late.testGetGradientPos2() == portal.testGetGradientPos2());
+  assert(portal.testGetGradientPos1() != 0);
+  portal.stop();
+  late.stop();
+  ConfigManager::setRotationSpeed(2);
+
+  static_assert(PortalEffectTemplate<INNER, 4, 1>::RAM_BYTES < PortalEffectTemplate<N, 4, 1>::RAM_BYTES,
+                "Buffers scale with the ring length");
+
+  // The LED count is a runtime value up to N: a shorter strip only takes
+  // arena space for its own LEDs and never touches the rest of the buffer
+  const int SHORT = 24;
+  GuardedLEDDriver<N> shortMock;
+  shortMock.length = SHORT;
+  PortalEffectTemplate<N, 4, 1> shortPortal(&shortMock, &arena);
+  size_t usedBefore = arena.getUsed();
+  assert(shortPortal.begin());
+  assert(shortPortal.getEffectLength() == SHORT);
+  assert(arena.getUsed() - usedBefore == (PortalEffectTemplate<N, 4, 1>::arenaBytes(SHORT)));
+  for (int i = SHORT; i < N + 4; ++i)
+    shortMock.buffer[i] = CRGB(1, 2, 3);
+  runFrames(shortPortal, t);
+  for (int i = SHORT; i < N + 4; ++i)
+    assert(shortMock.buffer[i].r == 1 && shortMock.buffer[i].g == 2 && shortMock.buffer[i].b == 3);
+
+  // Out of arena space: the ring stays dark instead of writing anywhere
+  LedArena tiny;
+  assert(tiny.begin(16));
+  MockLEDDriver<N> darkMock;
+  PortalEffectTemplate<N, 4, 1> dark(&darkMock, &tiny);
+  assert(!dark.begin());
+  assert(!dark.isReady());
+  dark.start();
+  dark.update(t + 100);
+  assert(tiny.getFailedCount() > 0);
 
   std::cout << "Portal native test passed" << std::endl;
   return 0;
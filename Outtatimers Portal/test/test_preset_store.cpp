@@ -0,0 +1,105 @@
+#include "mock_file_store.h"
+#include "../src/preset_store.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+static const int N = 800;
+static CRGB effect[N];
+static int recallCallbacks = 0;
+
+static void fillPattern(uint8_t seed)
+{
+  for (int i = 0; i < N; ++i)
+    effect[i] = CRGB((uint8_t)(i + seed), (uint8_t)(i * 3 + seed), (uint8_t)(255 - i + seed));
+}
+
+static bool matchesPattern(uint8_t seed)
+{
+  for (int i = 0; i < N; ++i)
+  {
+    if (effect[i].r != (uint8_t)(i + seed) || effect[i].g != (uint8_t)(i * 3 + seed) ||
+        effect[i].b != (uint8_t)(255 - i + seed))
+      return false;
+  }
+  return true;
+}
+
+int main()
+{
+  MemoryFileStore files;
+  PresetStore presets(&files, effect, N);
+  presets.setRecallCallback([]()
+                            { recallCallbacks++; });
+  ConfigManager::begin();
+
+  // Save a look
+  fillPattern(7);
+  ConfigManager::setRotationSpeed(6);
+  ConfigManager::setMaxBrightness(90);
+  ConfigManager::setHueMin(10);
+  ConfigManager::setHueMax(30);
+  assert(presets.save(2));
+  assert(presets.exists(2));
+  assert(!presets.exists(3));
+  assert(files.size(PortalConfig::Storage::PRESET_TMP_PATH) == -1);
+
+  // Change everything, then recall: buffer and parameters come back exactly
+  fillPattern(99);
+  ConfigManager::setRotationSpeed(1);
+  ConfigManager::setMaxBrightness(255);
+  ConfigManager::setHueMin(200);
+  ConfigManager::setHueMax(220);
+  assert(ConfigManager::needsEffectRegeneration());
+  files.readCalls = 0;
+  assert(presets.recall(2));
+  assert(files.readCalls == 2); // header + one streamed read of the pixel data
+  assert(matchesPattern(7));
+  assert(ConfigManager::getRotationSpeed() == 6);
+  assert(ConfigManager::getMaxBrightness() == 90);
+  assert(ConfigManager::getHueMin() == 10);
+  assert(ConfigManager::getHueMax() == 30);
+  assert(!ConfigManager::needsEffectRegeneration()); // no re-roll
+  assert(recallCallbacks == 1);
+
+  // Empty and out-of-range slots
+  assert(!presets.recall(3));
+  assert(!presets.recall(-1));
+  assert(!presets.recall(PresetStore::SLOT_COUNT));
+  assert(!presets.save(PresetStore::SLOT_COUNT));
+
+  // A preset captured for a different ring size is not applied
+  {
+    static CRGB small[100];
+    PresetStore other(&files, small, 100);
+    assert(!other.exists(2));
+    assert(!other.recall(2));
+  }
+
+  // An interrupted save keeps the previous preset
+  fillPattern(50);
+  files.tearNextWrite = 100; // power lost while writing the pixel data
+  assert(!presets.save(2));
+  fillPattern(0);
+  assert(presets.recall(2));
+  assert(matchesPattern(7));
+
+  // Corrupted pixel data is rejected and the effect is asked to regenerate
+  char path[24];
+  PresetStore::slotPath(2, path, sizeof(path));
+  files.files[path][PresetStore::HEADER_BYTES + 500] ^= 0xFF;
+  int callbacksBefore = recallCallbacks;
+  ConfigManager::setRotationSpeed(3);
+  ConfigManager::clearEffectRegenerationFlag();
+  assert(!presets.recall(2));
+  assert(ConfigManager::needsEffectRegeneration());
+  assert(ConfigManager::getRotationSpeed() == 3);
+  assert(recallCallbacks == callbacksBefore);
+
+  // Delete
+  assert(presets.remove(2));
+  assert(!presets.exists(2));
+
+  std::cout << "Preset store native test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,195 @@
+#include "../src/serial_command_source.h"
+#include "posix_serial_port.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <vector>
+
+extern "C" unsigned long millis() { return 0; }
+extern "C" int digitalRead(int pin) { return HIGH; }
+extern "C" void pinMode(int pin, int mode) {}
+extern "C" void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode) {}
+
+static int master = -1;
+static int slave = -1;
+
+static void send(const uint8_t *data, size_t length)
+{
+  assert(write(master, data, length) == (ssize_t)length);
+  tcdrain(master);
+}
+
+static void sendCommand(InputManager::Command command, int16_t arg1 = 0, int16_t arg2 = 0)
+{
+  uint8_t frame[SerialCommandSource::MAX_FRAME_BYTES];
+  send(frame, SerialCommandSource::encodeCommand(command, arg1, arg2, frame));
+}
+
+// Update until the pty has nothing left for the source
+static std::vector<IInputSource::InputEvent> pump(SerialCommandSource &source, unsigned long now = 1000)
+{
+  std::vector<IInputSource::InputEvent> events;
+  pollfd pfd = {slave, POLLIN, 0};
+  while (poll(&pfd, 1, 50) > 0)
+  {
+    source.update(now);
+    while (source.hasEvents())
+      events.push_back(source.getNextEvent());
+  }
+  source.update(now);
+  while (source.hasEvents())
+    events.push_back(source.getNextEvent());
+  return events;
+}
+
+// Read one reply frame from the show PC end
+static std::vector<uint8_t> readReply()
+{
+  std::vector<uint8_t> frame;
+  pollfd pfd = {master, POLLIN, 0};
+  uint8_t byte;
+  while (poll(&pfd, 1, 200) > 0 && read(master, &byte, 1) == 1)
+  {
+    frame.push_back(byte);
+    if (frame.size() >= 4 && frame.size() == (size_t)frame[2] + 4)
+      break;
+  }
+  return frame;
+}
+
+static size_t writeState(uint8_t *payload, size_t capacity)
+{
+  assert(capacity == SerialCommandSource::MAX_PAYLOAD);
+  payload[0] = 1;
+  payload[1] = 42;
+  return 2;
+}
+
+struct Call
+{
+  InputManager::Command command;
+  int16_t arg1;
+  int16_t arg2;
+};
+static std::vector<Call> calls;
+
+static void record(InputManager::Command command, const IInputSource::InputEvent &event)
+{
+  calls.push_back({command, event.arg1, event.arg2});
+}
+
+int main()
+{
+  // CRC-8 (poly 0x07) check value
+  uint8_t crc = 0;
+  for (const char *c = "123456789"; *c; c++)
+    crc = SerialCommandSource::crc8(crc, (uint8_t)*c);
+  assert(crc == 0xF4);
+
+  assert(PosixSerialPort::openPty(master, slave));
+  PosixSerialPort port(slave);
+  SerialCommandSource source(&port);
+  source.setStateWriter(writeState);
+  assert(strcmp(source.getSourceName(), "Serial") == 0);
+
+  // Trigger and parameter commands
+  sendCommand(InputManager::Command::TogglePortal);
+  sendCommand(InputManager::Command::SetHue, 10, 200);
+  sendCommand(InputManager::Command::SetSpeed, -3);
+  std::vector<IInputSource::InputEvent> events = pump(source);
+  assert(events.size() == 3);
+  assert(events[0].inputId == 1 && events[0].type == IInputSource::EventType::Pressed && events[0].timestamp == 1000);
+  assert(events[1].inputId == 8 && events[1].arg1 == 10 && events[1].arg2 == 200);
+  assert(events[2].inputId == 6 && events[2].arg1 == -3);
+  assert(source.getFrameCount() == 3);
+
+  // A frame split across updates waits for its tail without blocking
+  uint8_t frame[SerialCommandSource::MAX_FRAME_BYTES];
+  size_t size = SerialCommandSource::encodeCommand(InputManager::Command::SetBrightness, 128, 0, frame);
+  send(frame, 4);
+  assert(pump(source).empty());
+  send(frame + 4, size - 4);
+  events = pump(source);
+  assert(events.size() == 1 && events[0].inputId == 7 && events[0].arg1 == 128);
+
+  // Log text, a corrupt frame and a bogus length are skipped; the next frame parses
+  const char *noise = "Input from Serial: toggle\r\n";
+  send((const uint8_t *)noise, strlen(noise));
+  size = SerialCommandSource::encodeCommand(InputManager::Command::FadeOut, 0, 0, frame);
+  frame[size - 1] ^= 0x55;
+  send(frame, size);
+  const uint8_t tooLong[] = {SerialCommandSource::SYNC, SerialCommandSource::COMMAND, 200};
+  send(tooLong, sizeof(tooLong));
+  sendCommand(InputManager::Command::TriggerMalfunction);
+  events = pump(source);
+  assert(events.size() == 1 && events[0].inputId == 2);
+  assert(source.getChecksumErrorCount() == 2);
+
+  // Refused frames are answered with REJECT and queue nothing
+  const uint8_t unknownCommand[] = {99};
+  send(frame, SerialCommandSource::encode(SerialCommandSource::COMMAND, unknownCommand, 1, frame));
+  assert(pump(source).empty());
+  std::vector<uint8_t> reply = readReply();
+  assert(reply.size() == 6 && reply[1] == SerialCommandSource::REJECT);
+  assert(reply[3] == SerialCommandSource::COMMAND &&
+         reply[4] == static_cast<uint8_t>(SerialCommandSource::Error::BadCommand));
+  const uint8_t shortParameter[] = {static_cast<uint8_t>(InputManager::Command::SetSpeed)};
+  send(frame, SerialCommandSource::encode(SerialCommandSource::COMMAND, shortParameter, 1, frame));
+  send(frame, SerialCommandSource::encode(0x42, nullptr, 0, frame));
+  assert(pump(source).empty());
+  assert(readReply()[4] == static_cast<uint8_t>(SerialCommandSource::Error::BadCommand));
+  reply = readReply();
+  assert(reply[3] == 0x42 && reply[4] == static_cast<uint8_t>(SerialCommandSource::Error::UnknownType));
+  assert(source.getRejectedCount() == 3);
+
+  // State query and ping
+  send(frame, SerialCommandSource::encode(SerialCommandSource::QUERY, nullptr, 0, frame));
+  pump(source);
+  reply = readReply();
+  assert(reply.size() == 6 && reply[0] == SerialCommandSource::SYNC && reply[1] == SerialCommandSource::STATE);
+  assert(reply[2] == 2 && reply[3] == 1 && reply[4] == 42);
+  uint8_t check = 0;
+  for (size_t i = 1; i < reply.size() - 1; i++)
+    check = SerialCommandSource::crc8(check, reply[i]);
+  assert(check == reply.back());
+  const uint8_t token[] = {1, 2, 3};
+  send(frame, SerialCommandSource::encode(SerialCommandSource::PING, token, sizeof(token), frame));
+  pump(source);
+  reply = readReply();
+  assert(reply.size() == 7 && reply[1] == SerialCommandSource::PONG && memcmp(&reply[3], token, 3) == 0);
+
+  // A burst larger than the event queue is held back, not dropped
+  for (int i = 0; i < 40; i++)
+    sendCommand(InputManager::Command::TriggerMalfunction);
+  source.update(2000);
+  int queued = 0;
+  while (source.hasEvents())
+  {
+    source.getNextEvent();
+    queued++;
+  }
+  assert(queued > 0 && queued < 40);
+  assert((int)pump(source).size() == 40 - queued);
+
+  // A fader at 200 updates/s: every frame arrives, InputManager applies the last value
+  InputManager manager;
+  static const InputManager::CommandHandler table[InputManager::COMMAND_COUNT] = {
+      record, record, record, record, record, record, record, record, record};
+  manager.setCommandTable(table);
+  manager.addInputSource(&source);
+  unsigned long framesBefore = source.getFrameCount();
+  for (int i = 0; i < 200; i++)
+    sendCommand(InputManager::Command::SetBrightness, (int16_t)i);
+  pollfd pfd = {slave, POLLIN, 0};
+  for (unsigned long now = 3000; poll(&pfd, 1, 50) > 0; now += 5)
+    manager.update(now);
+  assert(source.getFrameCount() - framesBefore == 200);
+  assert(!calls.empty() && calls.back().command == InputManager::Command::SetBrightness && calls.back().arg1 == 199);
+  assert(calls.size() < 200);
+
+  close(slave);
+  close(master);
+  std::cout << "Serial command source native test passed" << std::endl;
+  return 0;
+}
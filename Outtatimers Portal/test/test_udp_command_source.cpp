@@ -0,0 +1,290 @@
+#include "posix_udp_transport.h"
+#include "../src/udp_command_source.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Functional checks plus a host-side latency harness: a sender thread fires
+// cues at random times while the main thread runs a simulated loop() with a
+// blocking "show()", and the loop iterations and time from sendto() to
+// command dispatch are recorded per cue.
+static const uint16_t TEST_PORT = 17001;
+static const uint16_t SESSION = 0x1234;
+
+using Clock = std::chrono::steady_clock;
+
+static void pumpUntil(UdpCommandSource &source, unsigned long expected)
+{
+  for (int i = 0; i < 1000; ++i)
+  {
+    source.update(0);
+    if (source.getAcceptedCount() + source.getDuplicateCount() + source.getRejectedCount() >= expected)
+      return;
+    usleep(100);
+  }
+}
+
+static void testDedupAndValidation()
+{
+  PosixUdpTransport rx;
+  PosixUdpTransport tx;
+  UdpCommandSource source(&rx);
+  assert(source.begin(TEST_PORT));
+
+  uint8_t datagram[UdpCommandSource::DATAGRAM_BYTES];
+  unsigned long sent = 0;
+
+  // The same cue repeated three times is delivered once
+  UdpCommandSource::encode(InputManager::Command::TriggerMalfunction, SESSION, 1, datagram);
+  for (int i = 0; i < 3; ++i)
+    tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  pumpUntil(source, sent += 3);
+  assert(source.getAcceptedCount() == 1);
+  assert(source.getDuplicateCount() == 2);
+  IInputSource::InputEvent event = source.getNextEvent();
+  assert(event.inputId == static_cast<int>(InputManager::Command::TriggerMalfunction));
+  assert(event.type == IInputSource::EventType::Pressed);
+  assert(!source.hasEvents());
+
+  // Every datagram is acknowledged
+  int acks = 0;
+  for (int i = 0; i < 100 && acks < 3; ++i)
+  {
+    if (tx.parsePacket() == (int)UdpCommandSource::DATAGRAM_BYTES)
+    {
+      uint8_t ack[UdpCommandSource::DATAGRAM_BYTES];
+      tx.read(ack, sizeof(ack));
+      assert(ack[2] == (UdpCommandSource::VERSION | UdpCommandSource::ACK_FLAG));
+      acks++;
+    }
+    else
+      usleep(100);
+  }
+  assert(acks == 3);
+
+  // Reordered cues inside the window are each delivered once
+  UdpCommandSource::encode(InputManager::Command::FadeOut, SESSION, 5, datagram);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  UdpCommandSource::encode(InputManager::Command::TogglePortal, SESSION, 3, datagram);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  pumpUntil(source, sent += 3);
+  assert(source.getAcceptedCount() == 3);
+  assert(source.getNextEvent().inputId == static_cast<int>(InputManager::Command::FadeOut));
+  assert(source.getNextEvent().inputId == static_cast<int>(InputManager::Command::TogglePortal));
+
+  // Unknown commands and malformed datagrams are rejected
+  UdpCommandSource::encode(InputManager::Command::FadeOut, SESSION, 6, datagram);
+  datagram[3] = 42;
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, 4);
+  pumpUntil(source, sent += 2);
+  assert(source.getRejectedCount() == 2);
+  assert(!source.hasEvents());
+
+  // Parameter commands carry signed arguments in a 14-byte datagram
+  uint8_t param[UdpCommandSource::PARAM_DATAGRAM_BYTES];
+  UdpCommandSource::encode(InputManager::Command::SetHue, SESSION, 7, 180, -3, param);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, param, sizeof(param));
+  pumpUntil(source, sent += 1);
+  assert(source.getAcceptedCount() == 4);
+  event = source.getNextEvent();
+  assert(event.inputId == static_cast<int>(InputManager::Command::SetHue));
+  assert(event.arg1 == 180 && event.arg2 == -3);
+
+  // ... and only parameter commands may use it
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, param, UdpCommandSource::DATAGRAM_BYTES);
+  UdpCommandSource::encode(InputManager::Command::FadeOut, SESSION, 8, 0, 0, param);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, param, sizeof(param));
+  pumpUntil(source, sent += 2);
+  assert(source.getRejectedCount() == 4);
+  assert(!source.hasEvents());
+
+  // A restarted sender numbers from 1 again under a new session id
+  UdpCommandSource::encode(InputManager::Command::FadeOut, SESSION + 1, 1, datagram);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  UdpCommandSource::encode(InputManager::Command::TogglePortal, SESSION + 1, 2, datagram);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  pumpUntil(source, sent += 3);
+  assert(source.getAcceptedCount() == 6);
+  assert(source.getDuplicateCount() == 4);
+  assert(source.getNextEvent().inputId == static_cast<int>(InputManager::Command::FadeOut));
+  assert(source.getNextEvent().inputId == static_cast<int>(InputManager::Command::TogglePortal));
+
+  // Two senders interleaving keep their own windows: repeats of either are
+  // still duplicates
+  const uint32_t A = SESSION + 2, B = SESSION + 3;
+  const uint32_t order[][2] = {{A, 1}, {B, 1}, {A, 1}, {B, 1}, {A, 2}, {B, 2}, {A, 2}};
+  for (const auto &cue : order)
+  {
+    UdpCommandSource::encode(InputManager::Command::FadeOut, (uint16_t)cue[0], cue[1], datagram);
+    tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+    pumpUntil(source, ++sent);
+  }
+  assert(source.getAcceptedCount() == 10);
+  assert(source.getDuplicateCount() == 7);
+  while (source.hasEvents())
+    source.getNextEvent();
+
+  // A late repeat far behind the window is a duplicate, not a restart, and
+  // does not reopen the recent cues
+  for (uint32_t seq = 3; seq <= 3 + UdpCommandSource::WINDOW; ++seq)
+  {
+    UdpCommandSource::encode(InputManager::Command::FadeOut, (uint16_t)A, seq, datagram);
+    tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+    pumpUntil(source, ++sent);
+    while (source.hasEvents())
+      source.getNextEvent();
+  }
+  unsigned long accepted = source.getAcceptedCount();
+  UdpCommandSource::encode(InputManager::Command::FadeOut, (uint16_t)A, 1, datagram);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  UdpCommandSource::encode(InputManager::Command::FadeOut, (uint16_t)A, 3 + UdpCommandSource::WINDOW, datagram);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT, datagram, sizeof(datagram));
+  pumpUntil(source, sent += 2);
+  assert(source.getAcceptedCount() == accepted);
+  assert(!source.hasEvents());
+}
+
+// More new cues in one update than the queue holds: the overflow is counted
+// and left unacknowledged, and the sender's repeat is accepted later
+static void testBurstOverflow()
+{
+  PosixUdpTransport rx;
+  PosixUdpTransport tx;
+  UdpCommandSource source(&rx);
+  assert(source.begin(TEST_PORT + 2));
+
+  const int BURST = 10;
+  uint8_t datagram[UdpCommandSource::DATAGRAM_BYTES];
+  for (uint32_t seq = 1; seq <= BURST; ++seq)
+  {
+    UdpCommandSource::encode(InputManager::Command::TriggerMalfunction, SESSION, seq, datagram);
+    tx.send(PosixUdpTransport::loopback(), TEST_PORT + 2, datagram, sizeof(datagram));
+  }
+  usleep(10000); // All of them waiting in the socket
+  source.update(0);
+  int queued = 0;
+  while (source.hasEvents())
+  {
+    source.getNextEvent();
+    queued++;
+  }
+  assert(queued == 7); // The ring holds MAX_EVENTS - 1
+  assert(source.getAcceptedCount() == 7);
+  assert(source.getDroppedCount() == 1); // One more read, two still unread
+
+  int acks = 0;
+  for (int i = 0; i < 100; ++i)
+  {
+    if (tx.parsePacket() == (int)UdpCommandSource::DATAGRAM_BYTES)
+    {
+      uint8_t ack[UdpCommandSource::DATAGRAM_BYTES];
+      tx.read(ack, sizeof(ack));
+      acks++;
+    }
+    else if (acks > 0)
+      break;
+    else
+      usleep(100);
+  }
+  assert(acks == 7);
+
+  // The unread cues come next, then the repeat of the dropped one
+  source.update(0);
+  assert(source.getAcceptedCount() == 9);
+  UdpCommandSource::encode(InputManager::Command::TriggerMalfunction, SESSION, 8, datagram);
+  tx.send(PosixUdpTransport::loopback(), TEST_PORT + 2, datagram, sizeof(datagram));
+  for (int i = 0; i < 1000 && source.getAcceptedCount() < BURST; ++i)
+  {
+    source.update(0);
+    usleep(100);
+  }
+  assert(source.getAcceptedCount() == BURST);
+  assert(source.getDuplicateCount() == 0);
+}
+
+static void latencyHarness()
+{
+  const int CUES = 40;
+  const auto RENDER_COST = std::chrono::milliseconds(12); // blocking show() of a long strip
+
+  PosixUdpTransport rx;
+  UdpCommandSource source(&rx);
+  assert(source.begin(TEST_PORT + 1));
+
+  InputManager inputManager;
+  inputManager.addInputSource(&source);
+
+  static Clock::time_point sentAt[CUES + 1];
+  static Clock::time_point handledAt[CUES + 1];
+  static long sentIteration[CUES + 1];
+  static long handledIteration[CUES + 1];
+  static std::atomic<long> iterations(0);
+  static int received = 0;
+  inputManager.setInputCallback([](InputManager::Command, const IInputSource::InputEvent &)
+                                {
+                                  handledAt[++received] = Clock::now();
+                                  handledIteration[received] = iterations; });
+
+  std::atomic<bool> done(false);
+  std::thread sender([&]()
+                     {
+    PosixUdpTransport tx;
+    uint8_t datagram[UdpCommandSource::DATAGRAM_BYTES];
+    srand(7);
+    for (uint32_t seq = 1; seq <= CUES; ++seq)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(5000 + rand() % 20000));
+      UdpCommandSource::encode(InputManager::Command::TriggerMalfunction, SESSION, seq, datagram);
+      sentAt[seq] = Clock::now();
+      tx.send(PosixUdpTransport::loopback(), TEST_PORT + 1, datagram, sizeof(datagram));
+      tx.send(PosixUdpTransport::loopback(), TEST_PORT + 1, datagram, sizeof(datagram)); // redundancy
+      sentIteration[seq] = iterations; // Loopback datagrams are queued once send() returns
+    }
+    done = true; });
+
+  // Simulated loop(): poll inputs, then block in "show()"
+  auto deadline = Clock::now() + std::chrono::seconds(10);
+  while ((!done || received < CUES) && Clock::now() < deadline)
+  {
+    inputManager.update(0);
+    iterations++;
+    std::this_thread::sleep_for(RENDER_COST);
+  }
+  sender.join();
+  inputManager.update(0);
+
+  assert(received == CUES);
+  assert(source.getAcceptedCount() == CUES);
+  std::vector<double> latencies;
+  for (int i = 1; i <= CUES; ++i)
+  {
+    latencies.push_back(std::chrono::duration<double, std::milli>(handledAt[i] - sentAt[i]).count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  double p50 = latencies[CUES / 2];
+  double p99 = latencies[(CUES * 99) / 100];
+  std::cout << "UDP cue latency (render cost " << RENDER_COST.count() << " ms): p50=" << p50
+            << " ms p99=" << p99 << " ms max=" << latencies.back() << " ms" << std::endl;
+  // Each cue is dispatched by the input poll of the loop iteration it arrived
+  // in or the next one, independent of TCP/HTTP overhead and host scheduling
+  for (int i = 1; i <= CUES; ++i)
+  {
+    assert(handledIteration[i] <= sentIteration[i] + 1);
+  }
+}
+
+int main()
+{
+  testDedupAndValidation();
+  testBurstOverflow();
+  latencyHarness();
+  std::cout << "UDP command source native test passed" << std::endl;
+  return 0;
+}